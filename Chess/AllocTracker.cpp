@@ -0,0 +1,144 @@
+/**
+ * @file AllocTracker.cpp
+ * @brief Counting replacements of the global operator new / delete, when built with CHESS_ALLOC_TRACKING.
+ *
+ * The counters are shared relaxed atomics: the tracking build is for counting allocations,
+ * not for timing, so the contention between search threads doesn't matter. Blocks come from
+ * malloc, and nothing here allocates, so the operators can't recurse.
+ */
+#include "AllocTracker.h"
+
+#ifdef CHESS_ALLOC_TRACKING
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+    std::atomic<std::uint64_t> allocationCounts[AllocTracker::SLOTS];
+    std::atomic<std::uint64_t> byteCounts[AllocTracker::SLOTS];
+
+    void* allocate(std::size_t size) {
+        int slot = AllocTracker::currentPhase;
+        allocationCounts[slot].fetch_add(1, std::memory_order_relaxed);
+        byteCounts[slot].fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    std::string formatBytes(std::uint64_t bytes) {
+        char text[32];
+        if (bytes >= 10 * 1024 * 1024) std::snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+        else if (bytes >= 10 * 1024) std::snprintf(text, sizeof(text), "%.1f kB", bytes / 1024.0);
+        else std::snprintf(text, sizeof(text), "%llu B", static_cast<unsigned long long>(bytes));
+        return text;
+    }
+}
+
+thread_local int AllocTracker::currentPhase = static_cast<int>(Phase::COUNT);
+
+AllocTracker::Counts AllocTracker::Snapshot::total() const {
+    Counts sum;
+    for (const Counts& c : phases) {
+        sum.allocations += c.allocations;
+        sum.bytes += c.bytes;
+    }
+    return sum;
+}
+
+AllocTracker::Snapshot AllocTracker::Snapshot::operator-(const Snapshot& earlier) const {
+    Snapshot difference;
+    for (int i = 0; i < SLOTS; ++i) {
+        difference.phases[i].allocations = phases[i].allocations - earlier.phases[i].allocations;
+        difference.phases[i].bytes = phases[i].bytes - earlier.phases[i].bytes;
+    }
+    return difference;
+}
+
+AllocTracker::Snapshot& AllocTracker::Snapshot::operator+=(const Snapshot& other) {
+    for (int i = 0; i < SLOTS; ++i) {
+        phases[i].allocations += other.phases[i].allocations;
+        phases[i].bytes += other.phases[i].bytes;
+    }
+    return *this;
+}
+
+AllocTracker::Snapshot AllocTracker::snapshot() {
+    Snapshot now;
+    for (int i = 0; i < SLOTS; ++i) {
+        now.phases[i].allocations = allocationCounts[i].load(std::memory_order_relaxed);
+        now.phases[i].bytes = byteCounts[i].load(std::memory_order_relaxed);
+    }
+    return now;
+}
+
+std::string AllocTracker::report(const Snapshot& allocated, long long nodes) {
+    double perNode = nodes > 0 ? 1.0 / nodes : 0.0;
+    Counts sum = allocated.total();
+    char text[96];
+    std::snprintf(text, sizeof(text), "%.3f allocs/node (%llu allocs, ", sum.allocations * perNode,
+        static_cast<unsigned long long>(sum.allocations));
+    std::string line = text + formatBytes(sum.bytes) + ")";
+
+    // Phases that allocated, most allocations first.
+    std::vector<int> order;
+    for (int i = 0; i < SLOTS; ++i) {
+        if (allocated.phases[i].allocations) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&allocated](int a, int b) {
+        return allocated.phases[a].allocations > allocated.phases[b].allocations;
+    });
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Counts& c = allocated.phases[order[i]];
+        std::snprintf(text, sizeof(text), "%s %s %.3f (", i ? "," : ":", phaseName(static_cast<Phase>(order[i])),
+            c.allocations * perNode);
+        line += text + formatBytes(c.bytes) + ")";
+    }
+    return line;
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+#endif // CHESS_ALLOC_TRACKING
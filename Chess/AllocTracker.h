@@ -0,0 +1,60 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include "Trace.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+#ifdef CHESS_ALLOC_TRACKING
+
+/**
+ * @brief Heap-allocation accounting per Phase (compiled in with CHESS_ALLOC_TRACKING).
+ *
+ * In this build mode the global operator new and delete are replaced by counting versions,
+ * and PROFILE_SCOPE(phase) also makes `phase` the calling thread's current phase, so every
+ * allocation is charged to the innermost phase it happens in. Allocations outside any scope
+ * are charged to "other". Bot::think() snapshots the counters around each search, so a move
+ * can be reported as allocations per searched node.
+ */
+namespace AllocTracker {
+    const int SLOTS = static_cast<int>(Phase::COUNT) + 1;  ///< One per phase, then "other".
+
+    struct Counts {
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    /**
+     * @brief Allocations made by all threads since the program started, per phase.
+     */
+    struct Snapshot {
+        std::array<Counts, SLOTS> phases{};
+
+        Counts total() const;
+        Snapshot operator-(const Snapshot& earlier) const;  ///< What was allocated in between.
+        Snapshot& operator+=(const Snapshot& other);
+    };
+
+    Snapshot snapshot();
+
+    /// "0.840 allocs/node (12345 allocs, 1.2 MB): move generation 0.700 (800.0 kB), ..." for a search of `nodes` nodes.
+    std::string report(const Snapshot& allocated, long long nodes);
+
+    extern thread_local int currentPhase;  ///< Slot the calling thread's allocations are charged to.
+
+    class PhaseScope {
+    public:
+        explicit PhaseScope(Phase phase) : previous(currentPhase) { currentPhase = static_cast<int>(phase); }
+        ~PhaseScope() { currentPhase = previous; }
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+
+    private:
+        int previous;
+    };
+}
+
+#endif // CHESS_ALLOC_TRACKING
+
+#endif // ALLOCTRACKER_H
@@ -0,0 +1,315 @@
+/**
+ * @file AnalysisLoad.cpp
+ * @brief Load generator for the analysis daemon: shallow request streams plus deep background work.
+ */
+#include "AnalysisLoad.h"
+#include "AnalysisServer.h"
+#include "Notation.h"
+#include "Socket.h"
+#include "Histogram.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    struct LoadOptions {
+        int port = 0;
+        int workers = 0;
+        int requests = 5000;
+        int positions = 2000;
+        int depth = 4;
+        int clients = 2;
+        int window = 32;
+        int urgentEvery = 50;
+        int deep = 8;
+        int deepDepth = 10;
+        int urgentMs = 250;
+        int urgentDepth = 7;
+    };
+
+    struct Sent {
+        Clock::time_point at;
+        bool urgent;
+    };
+
+    struct Tally {
+        std::vector<long long> normalUs;       ///< End-to-end latency of normal requests.
+        std::vector<long long> urgentUs;       ///< ...and of urgent ones.
+        std::vector<long long> urgentWaitMs;   ///< Server-reported queueing delay of urgent requests.
+        long long cache = 0, shared = 0, search = 0, errors = 0, cancelled = 0;
+        bool connected = false;
+    };
+
+    std::vector<std::string> randomPositions(int count, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::string> fens;
+        while (int(fens.size()) < count) {
+            Board board;
+            int plies = 4 + int(rng() % 20);
+            for (int i = 0; i < plies; ++i) {
+                std::vector<PackedMove> legal = generateLegalMoves(board, board.currentPlayerColor);
+                if (legal.empty()) break;
+                PackedMove move = legal[rng() % legal.size()];
+                Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+                board.applyMove(piece->getId(), packedToX(move), packedToY(move));
+            }
+            if (!generateLegalMoves(board, board.currentPlayerColor).empty()) fens.push_back(board.toFen());
+        }
+        return fens;
+    }
+
+    // Account for one reply line, closing the request it answers.
+    void settle(const std::string& line, std::unordered_map<std::string, Sent>& open, Tally& tally) {
+        std::istringstream in(line);
+        std::string kind, id;
+        in >> kind >> id;
+        auto it = open.find(id);
+        if (it == open.end()) return;
+        long long us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - it->second.at).count();
+        if (kind == "result") {
+            std::string word, source;
+            long long wait = 0;
+            while (in >> word) {
+                if (word == "source") in >> source;
+                else if (word == "wait") in >> wait;
+            }
+            if (source == "cache") ++tally.cache;
+            else if (source == "shared") ++tally.shared;
+            else ++tally.search;
+            if (it->second.urgent) {
+                tally.urgentUs.push_back(us);
+                tally.urgentWaitMs.push_back(wait);
+            }
+            else {
+                tally.normalUs.push_back(us);
+            }
+        }
+        else if (kind == "cancelled") {
+            ++tally.cancelled;
+        }
+        else {
+            ++tally.errors;
+        }
+        open.erase(it);
+    }
+
+    void runShallowClient(const LoadOptions& o, const std::vector<std::string>& fens, int count, int client,
+        Tally& tally) {
+        SocketHandle socket = connectLoopback(o.port);
+        if (socket == INVALID_SOCKET_HANDLE) return;
+        tally.connected = true;
+        LineReader reader(socket);
+        std::mt19937 rng(1000u + unsigned(client));
+        std::unordered_map<std::string, Sent> open;
+        std::vector<std::string> lines;
+        int sent = 0;
+        while (sent < count || !open.empty()) {
+            std::string batch;
+            while (sent < count && int(open.size()) < o.window) {
+                bool urgent = o.urgentEvery > 0 && sent % o.urgentEvery == o.urgentEvery - 1;
+                std::string id = "s" + std::to_string(sent++);
+                batch += "go " + id + " depth " + std::to_string(o.depth) + (urgent ? " priority urgent" : "")
+                    + " fen " + fens[rng() % fens.size()] + "\n";
+                open[id] = Sent{ Clock::now(), urgent };
+            }
+            if (!batch.empty() && !sendAll(socket, batch)) break;
+            lines.clear();
+            if (!reader.readLines(lines)) break;
+            for (const std::string& line : lines) {
+                settle(line, open, tally);
+            }
+        }
+        sendAll(socket, "quit\n");
+        closeSocket(socket);
+    }
+
+    // Deep background searches (half cancelled again) and periodic urgent deep requests.
+    void runDeepClient(const LoadOptions& o, const std::vector<std::string>& fens, std::atomic<bool>& done,
+        Tally& tally) {
+        SocketHandle socket = connectLoopback(o.port);
+        if (socket == INVALID_SOCKET_HANDLE) return;
+        LineReader reader(socket);
+        std::unordered_map<std::string, Sent> open;
+        std::string batch;
+        for (int i = 0; i < o.deep; ++i) {
+            std::string id = "d" + std::to_string(i);
+            batch += "go " + id + " depth " + std::to_string(o.deepDepth) + " fen " + fens[(i * 7919) % fens.size()] + "\n";
+            open[id] = Sent{ Clock::now(), false };
+        }
+        sendAll(socket, batch);
+        Clock::time_point start = Clock::now();
+        Clock::time_point nextUrgent = start + std::chrono::milliseconds(o.urgentMs);
+        bool cancelledHalf = false;
+        bool stopping = false;
+        int urgentSent = 0;
+        std::vector<SocketHandle> sockets(1, socket);
+        std::vector<bool> readable;
+        std::vector<std::string> lines;
+        while (!done || !open.empty()) {
+            Clock::time_point now = Clock::now();
+            if (!cancelledHalf && now - start >= std::chrono::milliseconds(100)) {
+                cancelledHalf = true;
+                batch.clear();
+                for (int i = 0; i < o.deep; i += 2) {
+                    batch += "cancel d" + std::to_string(i) + "\n";
+                }
+                sendAll(socket, batch);
+            }
+            if (!done && o.urgentMs > 0 && now >= nextUrgent) {
+                std::string id = "u" + std::to_string(urgentSent);
+                sendAll(socket, "go " + id + " depth " + std::to_string(o.urgentDepth) + " priority urgent fen "
+                    + fens[(urgentSent * 104729 + 13) % fens.size()] + "\n");
+                open[id] = Sent{ now, true };
+                ++urgentSent;
+                nextUrgent += std::chrono::milliseconds(o.urgentMs);
+            }
+            if (done && !stopping) {
+                // The shallow run is over: stop the background work that is left.
+                stopping = true;
+                batch.clear();
+                for (const auto& entry : open) {
+                    if (entry.first[0] == 'd') batch += "cancel " + entry.first + "\n";
+                }
+                if (!batch.empty()) sendAll(socket, batch);
+            }
+            if (pollReadable(sockets, readable, 20) <= 0) continue;
+            lines.clear();
+            if (!reader.readLines(lines)) break;
+            for (const std::string& line : lines) {
+                settle(line, open, tally);
+            }
+        }
+        sendAll(socket, "quit\n");
+        closeSocket(socket);
+    }
+
+    void printLatency(const char* label, std::vector<long long>& us) {
+        std::sort(us.begin(), us.end());
+        std::cout << label << us.size() << " requests, latency ms p50 " << samplePercentile(us, 0.50) / 1000.0
+            << "  p99 " << samplePercentile(us, 0.99) / 1000.0 << "  max " << (us.empty() ? 0.0 : us.back() / 1000.0) << "\n";
+    }
+
+    std::string queryStats(int port) {
+        SocketHandle socket = connectLoopback(port);
+        if (socket == INVALID_SOCKET_HANDLE) return "";
+        sendAll(socket, "stats\n");
+        LineReader reader(socket);
+        std::vector<std::string> lines;
+        while (lines.empty() && reader.readLines(lines)) {
+        }
+        closeSocket(socket);
+        return lines.empty() ? "" : lines.front();
+    }
+}
+
+int runAnalysisLoad(const std::vector<std::string>& args) {
+    LoadOptions o;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        const std::string& a = args[i];
+        int v = std::atoi(args[i + 1].c_str());
+        if (a == "--port") o.port = v;
+        else if (a == "--workers") o.workers = v;
+        else if (a == "--requests") o.requests = std::max(1, v);
+        else if (a == "--positions") o.positions = std::max(1, v);
+        else if (a == "--depth") o.depth = std::max(1, v);
+        else if (a == "--clients") o.clients = std::max(1, v);
+        else if (a == "--window") o.window = std::max(1, v);
+        else if (a == "--urgent-every") o.urgentEvery = std::max(0, v);
+        else if (a == "--deep") o.deep = std::max(0, v);
+        else if (a == "--deep-depth") o.deepDepth = std::max(1, v);
+        else if (a == "--urgent-ms") o.urgentMs = std::max(0, v);
+        else if (a == "--urgent-depth") o.urgentDepth = std::max(1, v);
+        else {
+            std::cerr << "analysisload: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+    if (args.size() % 2 != 0) {
+        std::cerr << "analysisload: missing value for " << args.back() << std::endl;
+        return 1;
+    }
+    if (!initSockets()) {
+        std::cerr << "analysisload: socket library initialisation failed" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<AnalysisServer> server;
+    if (o.port == 0) {
+        AnalysisOptions serverOptions;
+        serverOptions.port = 0;
+        serverOptions.workers = o.workers;
+        server.reset(new AnalysisServer(serverOptions));
+        std::string error;
+        if (!server->start(error)) {
+            std::cerr << "analysisload: " << error << std::endl;
+            return 1;
+        }
+        o.port = server->getPort();
+    }
+
+    std::vector<std::string> fens = randomPositions(o.positions, 4242u);
+    std::cout << "Load: " << o.requests << " shallow requests (depth " << o.depth << ", " << fens.size()
+        << " distinct positions) over " << o.clients << " connections, window " << o.window << "; "
+        << o.deep << " deep background searches (depth " << o.deepDepth << "), urgent depth " << o.urgentDepth
+        << " every " << o.urgentMs << " ms; daemon 127.0.0.1:" << o.port << std::endl;
+
+    std::vector<Tally> tallies(o.clients + 1);
+    std::atomic<bool> shallowDone{ false };
+    std::thread deepClient(runDeepClient, std::cref(o), std::cref(fens), std::ref(shallowDone), std::ref(tallies[o.clients]));
+    std::vector<std::thread> clients;
+    Clock::time_point start = Clock::now();
+    for (int c = 0; c < o.clients; ++c) {
+        int share = o.requests / o.clients + (c < o.requests % o.clients ? 1 : 0);
+        clients.emplace_back(runShallowClient, std::cref(o), std::cref(fens), share, c, std::ref(tallies[c]));
+    }
+    for (std::thread& t : clients) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    shallowDone = true;
+    deepClient.join();
+
+    Tally shallow;
+    for (int c = 0; c < o.clients; ++c) {
+        const Tally& t = tallies[c];
+        shallow.normalUs.insert(shallow.normalUs.end(), t.normalUs.begin(), t.normalUs.end());
+        shallow.urgentUs.insert(shallow.urgentUs.end(), t.urgentUs.begin(), t.urgentUs.end());
+        shallow.cache += t.cache;
+        shallow.shared += t.shared;
+        shallow.search += t.search;
+        shallow.errors += t.errors;
+        shallow.connected = shallow.connected || t.connected;
+    }
+    if (!shallow.connected) {
+        std::cerr << "analysisload: cannot connect to 127.0.0.1:" << o.port << std::endl;
+        return 1;
+    }
+    Tally& deep = tallies[o.clients];
+    long long answered = shallow.cache + shallow.shared + shallow.search;
+    std::cout << std::fixed << std::setprecision(1)
+        << "Shallow: " << answered << " answered in " << seconds << " s (" << (seconds > 0 ? answered / seconds : 0.0)
+        << " requests/s), from cache " << shallow.cache << ", shared " << shallow.shared << ", searched "
+        << shallow.search << ", errors " << shallow.errors << "\n";
+    printLatency("  normal: ", shallow.normalUs);
+    printLatency("  urgent: ", shallow.urgentUs);
+    std::sort(deep.urgentWaitMs.begin(), deep.urgentWaitMs.end());
+    std::cout << "Deep: " << deep.normalUs.size() << " background searches finished, " << deep.cancelled
+        << " cancelled, errors " << deep.errors << "\n";
+    printLatency("  urgent deep: ", deep.urgentUs);
+    std::cout << "  urgent deep queueing delay ms: p50 " << samplePercentile(deep.urgentWaitMs, 0.50) << "  p99 "
+        << samplePercentile(deep.urgentWaitMs, 0.99) << "  max " << (deep.urgentWaitMs.empty() ? 0 : deep.urgentWaitMs.back())
+        << std::endl;
+    std::string serverStats = queryStats(o.port);
+    if (!serverStats.empty()) std::cout << "Server: " << serverStats << std::endl;
+    if (server) server->stop();
+    return 0;
+}
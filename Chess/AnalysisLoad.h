@@ -0,0 +1,35 @@
+#ifndef ANALYSIS_LOAD_H
+#define ANALYSIS_LOAD_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Synthetic load for the AnalysisServer ("analysisload" mode).
+ * @param args Command-line arguments after the mode name.
+ * @return Process exit code.
+ *
+ * Client threads stream shallow requests for positions drawn from a pool of random
+ * positions (so some repeat), keeping a window of requests outstanding; every Nth request
+ * is urgent. Meanwhile one more client keeps deep searches busy, cancels half of them and
+ * adds an urgent deep request at a fixed interval. The report gives shallow requests per
+ * second, latency by class, where answers came from (cache, shared search, new search) and
+ * the server-side queueing delay of urgent requests.
+ *
+ * Options:
+ *   --port P            Daemon to load (default: start one in this process on a free port).
+ *   --workers N         Deep-search threads of the in-process daemon (default: hardware threads).
+ *   --requests N        Shallow requests (default 5000).
+ *   --positions N       Distinct positions they are drawn from (default 2000).
+ *   --depth D           Shallow search depth (default 4).
+ *   --clients N         Shallow client connections (default 2).
+ *   --window N          Outstanding requests per shallow client (default 32).
+ *   --urgent-every N    Every Nth shallow request is urgent (default 50, 0 = none).
+ *   --deep N            Background deep requests (default 8).
+ *   --deep-depth D      Their depth (default 10).
+ *   --urgent-ms MS      Interval between urgent deep requests (default 250, 0 = none).
+ *   --urgent-depth D    Their depth (default 7).
+ */
+int runAnalysisLoad(const std::vector<std::string>& args);
+
+#endif // ANALYSIS_LOAD_H
@@ -0,0 +1,538 @@
+/**
+ * @file AnalysisServer.cpp
+ * @brief Analysis daemon: request deduplication, result cache, shallow batches and
+ *        priority-scheduled deep searches.
+ *
+ * Locking: `mutex` guards the job tables, both queues, the free Bot list, the cache and the
+ * counters; the connections (LineServer) lock themselves. Searches and socket writes always
+ * run without `mutex`. The scheduler is only entered with `mutex` held (submit), never the
+ * other way round: its completion callbacks run without any scheduler lock.
+ */
+#include "AnalysisServer.h"
+#include "Notation.h"
+#include "Histogram.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+    const std::size_t WAIT_SAMPLES = 100000;
+    const int PRIORITY_COUNT = 4;
+    const char* const PRIORITY_NAMES[PRIORITY_COUNT] = { "urgent", "high", "normal", "low" };
+
+    void recordSample(std::vector<long long>& ring, std::size_t& next, long long value) {
+        if (ring.size() < WAIT_SAMPLES) {
+            ring.push_back(value);
+        }
+        else {
+            ring[next] = value;
+            next = (next + 1) % WAIT_SAMPLES;
+        }
+    }
+
+    long long millisBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+        return std::max(0LL, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count());
+    }
+}
+
+AnalysisServer::AnalysisServer(const AnalysisOptions& opts)
+    : options(opts) {
+    if (options.workers <= 0) {
+        options.workers = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    options.batchThreads = std::max(1, options.batchThreads);
+    options.batchSize = std::max(1, options.batchSize);
+    options.deepSlots = std::max(1, options.deepSlots);
+}
+
+AnalysisServer::~AnalysisServer() {
+    stop();
+}
+
+bool AnalysisServer::start(std::string& error) {
+    if (!initSockets()) {
+        error = "socket library initialisation failed";
+        return false;
+    }
+    listener = listenLoopback(options.port, port);
+    if (listener == INVALID_SOCKET_HANDLE) {
+        error = "cannot listen on 127.0.0.1:" + std::to_string(options.port);
+        return false;
+    }
+    table = std::make_shared<TranspositionTable>(options.hashMb);
+    for (int i = 0; i < options.deepSlots; ++i) {
+        deepBots.emplace_back(new Bot(Color::WHITE, table));
+        freeBots.push_back(deepBots.back().get());
+    }
+    scheduler.reset(new SearchScheduler(options.workers));
+    running = true;
+    for (int i = 0; i < options.batchThreads; ++i) {
+        batchThreads.emplace_back([this] { batchLoop(); });
+    }
+    networkThread = std::thread([this] { networkLoop(); });
+    return true;
+}
+
+void AnalysisServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    shallowReady.notify_all();
+    if (networkThread.joinable()) networkThread.join();
+    for (std::thread& thread : batchThreads) {
+        thread.join();
+    }
+    batchThreads.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        deepQueue.clear();
+        for (auto& bot : deepBots) {
+            bot->stop();
+        }
+    }
+    scheduler.reset();   // the stopped searches end within a slice
+    connections.closeAll();
+    closeSocket(listener);
+}
+
+void AnalysisServer::wait() {
+    if (networkThread.joinable()) networkThread.join();
+}
+
+int AnalysisServer::getPort() const {
+    return port;
+}
+
+bool AnalysisServer::runsLater(const QueueEntry& a, const QueueEntry& b) {
+    if (a.priority != b.priority) return a.priority > b.priority;
+    return a.seq > b.seq;
+}
+
+bool AnalysisServer::covers(LimitKind kind, long long amount, const Job& request) {
+    return kind == request.kind && amount >= request.amount;
+}
+
+bool AnalysisServer::covers(const CachedResult& result, const Job& request) {
+    switch (request.kind) {
+    case LimitKind::DEPTH:    return result.depth >= request.amount;
+    case LimitKind::NODES:    return result.nodes >= request.amount;
+    case LimitKind::MOVETIME: return result.timeMs >= request.amount;
+    }
+    return false;
+}
+
+bool AnalysisServer::isDeep(LimitKind kind, long long amount) const {
+    if (kind == LimitKind::DEPTH) return amount > options.shallowDepth;
+    if (kind == LimitKind::NODES) return amount > options.shallowNodes;
+    return true;
+}
+
+SearchLimits AnalysisServer::limitsFor(const Job& job) const {
+    SearchLimits limits;
+    limits.moveTimeMs = 0;
+    if (job.kind == LimitKind::DEPTH) limits.maxDepth = int(job.amount);
+    else if (job.kind == LimitKind::NODES) limits.maxNodes = job.amount;
+    else limits.moveTimeMs = int(job.amount);
+    return limits;
+}
+
+void AnalysisServer::networkLoop() {
+    connections.run(listener, running,
+        [this](std::uint32_t connection, const std::string& line) { handleLine(connection, line); },
+        [this](std::uint32_t connection) { dropConnection(connection); });
+}
+
+void AnalysisServer::handleLine(std::uint32_t connection, const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    if (!(in >> command)) return;
+
+    if (command == "go") {
+        handleGo(connection, in);
+    }
+    else if (command == "cancel") {
+        std::string id;
+        in >> id;
+        cancelRequest(connection, id);
+    }
+    else if (command == "stats") {
+        reply(connection, statsLine());
+    }
+    else if (command == "quit") {
+        dropConnection(connection);
+    }
+    else {
+        reply(connection, "error 0 unknown command " + command);
+    }
+}
+
+void AnalysisServer::handleGo(std::uint32_t connection, std::istringstream& in) {
+    std::shared_ptr<Job> request = std::make_shared<Job>();
+    Waiter waiter;
+    waiter.connection = connection;
+    waiter.arrived = Clock::now();
+    waiter.priority = Priority::NORMAL;
+    waiter.shared = false;
+    if (!(in >> waiter.id)) {
+        reply(connection, "error 0 go needs an ID");
+        return;
+    }
+    request->kind = LimitKind::DEPTH;
+    request->amount = options.shallowDepth;
+    std::string word;
+    while (in >> word && word != "fen") {
+        std::string value;
+        if (!(in >> value)) break;
+        if (word == "depth" || word == "nodes" || word == "movetime") {
+            request->kind = word == "depth" ? LimitKind::DEPTH : (word == "nodes" ? LimitKind::NODES : LimitKind::MOVETIME);
+            request->amount = std::max(1LL, std::atoll(value.c_str()));
+            if (request->kind == LimitKind::DEPTH) request->amount = std::min<long long>(request->amount, Bot::MAX_PLY - 1);
+        }
+        else if (word == "priority") {
+            const char* const* name = std::find(PRIORITY_NAMES, PRIORITY_NAMES + PRIORITY_COUNT, value);
+            if (name == PRIORITY_NAMES + PRIORITY_COUNT) {
+                reply(connection, "error " + waiter.id + " unknown priority " + value);
+                return;
+            }
+            waiter.priority = Priority(name - PRIORITY_NAMES);
+        }
+        else {
+            reply(connection, "error " + waiter.id + " unknown option " + word);
+            return;
+        }
+    }
+    std::string fen;
+    std::getline(in, fen);
+    try {
+        request->board.loadFromFen(fen);
+    }
+    catch (const std::exception& e) {
+        reply(connection, "error " + waiter.id + " " + e.what());
+        return;
+    }
+    request->key = request->board.getPositionKey(request->board.currentPlayerColor);
+    request->priority = waiter.priority;
+    request->deep = isDeep(request->kind, request->amount);
+    request->arrived = waiter.arrived;
+
+    std::string cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++requestCount;
+        auto key = std::make_pair(connection, waiter.id);
+        if (requests.count(key)) {
+            cached = "error " + waiter.id + " request ID already in use";
+        }
+        else {
+            auto hit = cacheIndex.find(request->key);
+            if (hit != cacheIndex.end() && covers(*hit->second, *request)) {
+                ++cacheHits;
+                cache.splice(cache.begin(), cache, hit->second);
+                cached = resultLine(waiter.id, request->board, *hit->second, "cache", 0);
+            }
+        }
+        if (cached.empty()) {
+            auto flying = inFlight.find(request->key);
+            std::shared_ptr<Job> job;
+            if (flying != inFlight.end()) {
+                Job& j = *flying->second;
+                // Join a search of the same position that goes at least as far, or can still be
+                // made to without changing lanes.
+                if (covers(j.kind, j.amount, *request) ||
+                    (!j.started && j.kind == request->kind && j.deep == request->deep)) {
+                    job = flying->second;
+                }
+            }
+            if (job) {
+                ++sharedHits;
+                waiter.shared = true;
+                if (!job->started) {
+                    job->amount = std::max(job->amount, request->amount);
+                    if (request->priority < job->priority) {
+                        // Queue it again at the more urgent place; the old entry goes stale.
+                        job->priority = request->priority;
+                        std::vector<QueueEntry>& queue = job->deep ? deepQueue : shallowQueue;
+                        queue.push_back(QueueEntry{ job->priority, job->seq, job });
+                        std::push_heap(queue.begin(), queue.end(), runsLater);
+                    }
+                }
+            }
+            else {
+                job = request;
+                job->seq = nextSeq++;
+                inFlight[job->key] = job;
+                std::vector<QueueEntry>& queue = job->deep ? deepQueue : shallowQueue;
+                queue.push_back(QueueEntry{ job->priority, job->seq, job });
+                std::push_heap(queue.begin(), queue.end(), runsLater);
+            }
+            job->waiters.push_back(waiter);
+            requests[key] = job;
+            if (job->deep) startDeepJobs();
+        }
+    }
+    if (!cached.empty()) reply(connection, cached);
+    else if (!request->deep) shallowReady.notify_all();   // a paused batch thread may want an urgent one
+}
+
+void AnalysisServer::cancelRequest(std::uint32_t connection, const std::string& id) {
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = requests.find(std::make_pair(connection, id));
+        if (it != requests.end()) {
+            found = true;
+            std::shared_ptr<Job> job = it->second;
+            requests.erase(it);
+            ++cancelledCount;
+            job->waiters.erase(std::remove_if(job->waiters.begin(), job->waiters.end(),
+                [&](const Waiter& w) { return w.connection == connection && w.id == id; }), job->waiters.end());
+            if (job->waiters.empty()) {
+                // Nobody wants it any more: queued copies are skipped, a running deep search stops.
+                job->cancelled = true;
+                forgetJob(job);
+                if (job->bot) job->bot->stop();
+            }
+        }
+    }
+    reply(connection, found ? "cancelled " + id : "error " + id + " unknown request");
+}
+
+bool AnalysisServer::popShallow(std::shared_ptr<Job>& job, int priorityLimit) {
+    while (!shallowQueue.empty()) {
+        const QueueEntry& top = shallowQueue.front();
+        bool stale = top.job->started || top.job->cancelled || top.priority != top.job->priority;
+        if (!stale && int(top.priority) >= priorityLimit) return false;
+        std::pop_heap(shallowQueue.begin(), shallowQueue.end(), runsLater);
+        QueueEntry entry = shallowQueue.back();
+        shallowQueue.pop_back();
+        if (stale) continue;
+        job = entry.job;
+        startJob(*job);
+        return true;
+    }
+    return false;
+}
+
+void AnalysisServer::startJob(Job& job) {
+    job.started = true;
+    job.startedAt = Clock::now();
+    for (const Waiter& w : job.waiters) {
+        recordWait(w.priority, std::chrono::duration_cast<std::chrono::microseconds>(job.startedAt - w.arrived).count());
+    }
+}
+
+void AnalysisServer::batchLoop() {
+    Bot bot(Color::WHITE, table);   // warm across the whole batch, and sharing the server's table
+    std::vector<std::shared_ptr<Job>> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            shallowReady.wait(lock, [this] { return !running || !shallowQueue.empty(); });
+            if (!running) return;
+            // Leave the other batch threads a share of a short queue.
+            std::size_t take = std::min<std::size_t>(options.batchSize,
+                (shallowQueue.size() + options.batchThreads - 1) / options.batchThreads);
+            std::shared_ptr<Job> job;
+            while (batch.size() < take && popShallow(job, PRIORITY_COUNT)) {
+                batch.push_back(job);
+            }
+        }
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    if (!running) return;
+                    // A more urgent request that arrived meanwhile goes before the rest of the batch.
+                    std::shared_ptr<Job> urgent;
+                    if (popShallow(urgent, int(batch[i]->priority))) {
+                        batch.insert(batch.begin() + i, urgent);
+                    }
+                    // Urgent deep searches keep every scheduler thread busy: leave them the CPU.
+                    if (batch[i]->priority == Priority::URGENT || urgentDeepRunning < options.workers) break;
+                    shallowReady.wait(lock);
+                }
+                if (batch[i]->cancelled) continue;
+            }
+            Job& job = *batch[i];
+            bot.setColor(job.board.currentPlayerColor);
+            bot.setSearchLimits(limitsFor(job));
+            bot.think(job.board);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++shallowSearches;
+            }
+            finishJob(batch[i], bot.getLastResult(), true);
+        }
+        batch.clear();
+    }
+}
+
+void AnalysisServer::startDeepJobs() {
+    while (!freeBots.empty() && !deepQueue.empty()) {
+        std::pop_heap(deepQueue.begin(), deepQueue.end(), runsLater);
+        QueueEntry entry = deepQueue.back();
+        deepQueue.pop_back();
+        std::shared_ptr<Job> job = entry.job;
+        if (job->started || job->cancelled || entry.priority != job->priority) continue;
+        startJob(*job);
+        ++deepSearches;
+        if (job->priority == Priority::URGENT) ++urgentDeepRunning;
+        Bot* bot = freeBots.back();
+        freeBots.pop_back();
+        job->bot = bot;
+        bot->setColor(job->board.currentPlayerColor);
+        bot->setSearchLimits(limitsFor(*job));
+        scheduler->submit(*bot, job->board, job->arrived, [this, job](Bot& done) { finishDeepJob(job, done); },
+            int(job->priority));
+    }
+}
+
+void AnalysisServer::finishDeepJob(const std::shared_ptr<Job>& job, Bot& bot) {
+    // Copy the result first: the Bot may be handed to the next job right away.
+    SearchResult result = bot.getLastResult();
+    bool complete;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // stop() halts the deep bots without cancelling their jobs: those searches are cut short too.
+        complete = !job->cancelled && running;
+        job->bot = nullptr;
+        freeBots.push_back(&bot);
+        if (job->priority == Priority::URGENT) --urgentDeepRunning;
+        if (running) startDeepJobs();
+    }
+    shallowReady.notify_all();
+    finishJob(job, result, complete);
+}
+
+void AnalysisServer::finishJob(const std::shared_ptr<Job>& job, const SearchResult& searched, bool complete) {
+    CachedResult result{ job->key, searched.bestMove, searched.score, searched.depth, searched.nodes, searched.timeMs };
+    std::vector<std::pair<std::uint32_t, std::string>> replies;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A stopped search only reached part of its limit; it is neither cached nor reported.
+        if (!complete) return;
+        storeResult(result);
+        if (job->cancelled) return;
+        forgetJob(job);
+        for (const Waiter& w : job->waiters) {
+            replies.emplace_back(w.connection, resultLine(w.id, job->board, result,
+                w.shared ? "shared" : "search", millisBetween(w.arrived, std::max(w.arrived, job->startedAt))));
+        }
+        job->waiters.clear();
+    }
+    for (const auto& r : replies) {
+        reply(r.first, r.second);
+    }
+}
+
+void AnalysisServer::forgetJob(const std::shared_ptr<Job>& job) {
+    auto flying = inFlight.find(job->key);
+    if (flying != inFlight.end() && flying->second == job) inFlight.erase(flying);
+    for (const Waiter& w : job->waiters) {
+        auto it = requests.find(std::make_pair(w.connection, w.id));
+        if (it != requests.end() && it->second == job) requests.erase(it);
+    }
+}
+
+void AnalysisServer::storeResult(const CachedResult& result) {
+    if (options.cacheEntries == 0) return;
+    auto it = cacheIndex.find(result.key);
+    if (it != cacheIndex.end()) {
+        // Keep whichever search went further.
+        if (result.depth >= it->second->depth) *it->second = result;
+        cache.splice(cache.begin(), cache, it->second);
+        return;
+    }
+    cache.push_front(result);
+    cacheIndex[result.key] = cache.begin();
+    if (cache.size() > options.cacheEntries) {
+        cacheIndex.erase(cache.back().key);
+        cache.pop_back();
+    }
+}
+
+void AnalysisServer::recordWait(Priority priority, long long micros) {
+    if (priority == Priority::URGENT) recordSample(urgentWaits, urgentNext, micros);
+    else recordSample(otherWaits, otherNext, micros);
+}
+
+std::string AnalysisServer::resultLine(const std::string& id, const Board& board, const CachedResult& result,
+    const char* source, long long waitMs) const {
+    std::ostringstream line;
+    line << "result " << id << " bestmove " << moveToUci(board, result.move) << " score " << scoreToUci(result.score)
+        << " depth " << result.depth << " nodes " << result.nodes << " time " << result.timeMs
+        << " source " << source << " wait " << waitMs;
+    return line.str();
+}
+
+void AnalysisServer::dropConnection(std::uint32_t id) {
+    if (!connections.close(id)) return;
+    // Its open requests are cancelled like explicit cancels, without the replies.
+    std::lock_guard<std::mutex> lock(mutex);
+    auto first = requests.lower_bound(std::make_pair(id, std::string()));
+    std::vector<std::shared_ptr<Job>> jobs;
+    for (auto it = first; it != requests.end() && it->first.first == id;) {
+        jobs.push_back(it->second);
+        it = requests.erase(it);
+    }
+    for (const std::shared_ptr<Job>& job : jobs) {
+        job->waiters.erase(std::remove_if(job->waiters.begin(), job->waiters.end(),
+            [id](const Waiter& w) { return w.connection == id; }), job->waiters.end());
+        if (job->waiters.empty() && !job->cancelled) {
+            job->cancelled = true;
+            forgetJob(job);
+            if (job->bot) job->bot->stop();
+        }
+    }
+}
+
+void AnalysisServer::reply(std::uint32_t id, const std::string& line) {
+    connections.send(id, line);
+}
+
+std::string AnalysisServer::statsLine() {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "stats requests " << requestCount << " cachehits " << cacheHits << " shared " << sharedHits
+        << " shallowsearches " << shallowSearches << " deepsearches " << deepSearches
+        << " cancelled " << cancelledCount << " inflight " << inFlight.size()
+        << " deeprunning " << (deepBots.size() - freeBots.size()) << " cached " << cache.size()
+        << " urgentwaitp50us " << samplePercentile(urgentWaits, 0.50) << " urgentwaitp99us " << samplePercentile(urgentWaits, 0.99)
+        << " waitp50us " << samplePercentile(otherWaits, 0.50) << " waitp99us " << samplePercentile(otherWaits, 0.99);
+    return out.str();
+}
+
+int runAnalysisServer(const std::vector<std::string>& args) {
+    AnalysisOptions options;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        const std::string& a = args[i];
+        long long v = std::atoll(args[i + 1].c_str());
+        if (a == "--port") options.port = int(v);
+        else if (a == "--workers") options.workers = int(v);
+        else if (a == "--batch-threads") options.batchThreads = int(v);
+        else if (a == "--batch") options.batchSize = int(v);
+        else if (a == "--hash") options.hashMb = std::size_t(std::max(1LL, v));
+        else if (a == "--cache") options.cacheEntries = std::size_t(std::max(0LL, v));
+        else if (a == "--shallow-depth") options.shallowDepth = int(v);
+        else if (a == "--shallow-nodes") options.shallowNodes = v;
+        else if (a == "--deep-slots") options.deepSlots = int(v);
+        else {
+            std::cerr << "analysisd: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+    if (args.size() % 2 != 0) {
+        std::cerr << "analysisd: missing value for " << args.back() << std::endl;
+        return 1;
+    }
+    AnalysisServer server(options);
+    std::string error;
+    if (!server.start(error)) {
+        std::cerr << "analysisd: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Analysing on 127.0.0.1:" << server.getPort() << std::endl;
+    server.wait();
+    return 0;
+}
@@ -0,0 +1,188 @@
+#ifndef ANALYSIS_SERVER_H
+#define ANALYSIS_SERVER_H
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Board.h"
+#include "Bot.h"
+#include "Socket.h"
+#include "SearchScheduler.h"
+#include "TranspositionTable.h"
+
+struct AnalysisOptions {
+    int port = 7879;                  ///< Loopback TCP port (0 = any free port).
+    int workers = 0;                  ///< Scheduler threads for deep requests (0 = hardware threads).
+    int batchThreads = 1;             ///< Threads working through shallow requests.
+    std::size_t hashMb = 64;          ///< The one transposition table every search shares.
+    std::size_t cacheEntries = 100000;///< Finished results kept for repeated positions.
+    int shallowDepth = 6;             ///< Depth requests up to this depth are shallow.
+    long long shallowNodes = 50000;   ///< Node requests up to this many nodes are shallow.
+    int batchSize = 32;               ///< Shallow requests a batch thread takes at once.
+    int deepSlots = 16;               ///< Deep searches in progress at once (one Bot each).
+};
+
+/**
+ * @class AnalysisServer
+ * @brief "Evaluate this position" daemon: many independent requests over a loopback socket.
+ *
+ * A request names a position, one limit (depth, nodes or move time) and a priority. It is
+ * answered, cheapest first, from:
+ *   - the result cache, if a recent search of the same position went at least as far;
+ *   - a search already queued or running for the same position (keyed by Zobrist hash)
+ *     with a limit at least as high, whose result it shares;
+ *   - a new search. Shallow ones are queued by priority and worked off in batches by
+ *     batch threads on warm Bots; deep ones run time-sliced on a SearchScheduler, most
+ *     urgent priority first and oldest first within a priority. While urgent deep searches
+ *     occupy every scheduler thread, the batch threads only take urgent requests.
+ * Every Bot searches with the same lock-free transposition table, so repeated and related
+ * positions profit from each other. A cancelled request is dropped from its search, and a
+ * search nobody waits for any more is abandoned (a running one is stopped).
+ *
+ * Protocol (one line each way):
+ *   go ID [depth D | nodes N | movetime MS] [priority urgent|high|normal|low] fen FEN
+ *       -> result ID bestmove MOVE score cp S|mate M depth D nodes N time MS source cache|shared|search wait MS
+ *          (`wait` is the queueing delay before the search started), or error ID REASON
+ *   cancel ID   -> cancelled ID, or error ID unknown request
+ *   stats       -> stats key value ...
+ *   quit        -> closes the connection (and cancels its requests)
+ * IDs are chosen by the client and only need to be unique among its open requests.
+ */
+class AnalysisServer {
+public:
+    explicit AnalysisServer(const AnalysisOptions& options);
+    ~AnalysisServer();
+
+    AnalysisServer(const AnalysisServer&) = delete;
+    AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+    bool start(std::string& error);   ///< Bind and start the network, batch and scheduler threads.
+    void stop();                      ///< Stop every search, close the connections, join the threads.
+    void wait();                      ///< Block until the network thread ends.
+    int getPort() const;
+
+    enum class Priority : std::uint8_t { URGENT, HIGH, NORMAL, LOW };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    enum class LimitKind : std::uint8_t { DEPTH, NODES, MOVETIME };
+
+    struct Waiter {
+        std::uint32_t connection;
+        std::string id;
+        Clock::time_point arrived;
+        Priority priority;
+        bool shared;                  ///< Joined a search someone else asked for.
+    };
+
+    struct Job {
+        std::uint64_t key{ 0 };
+        Board board;
+        LimitKind kind{ LimitKind::DEPTH };
+        long long amount{ 0 };
+        Priority priority{ Priority::NORMAL };
+        bool deep{ false };
+        bool started{ false };
+        bool cancelled{ false };
+        Clock::time_point arrived;
+        Clock::time_point startedAt;
+        std::uint64_t seq{ 0 };       ///< Arrival order, the tie-break within a priority.
+        std::vector<Waiter> waiters;
+        Bot* bot{ nullptr };          ///< Deep search in progress.
+    };
+
+    // Queue entry; re-pushed when a job's priority rises, stale copies are skipped on pop.
+    struct QueueEntry {
+        Priority priority;
+        std::uint64_t seq;
+        std::shared_ptr<Job> job;
+    };
+
+    struct CachedResult {
+        std::uint64_t key;
+        PackedMove move;
+        int score;
+        int depth;
+        long long nodes;
+        long long timeMs;
+    };
+
+    static bool runsLater(const QueueEntry& a, const QueueEntry& b);   ///< Priority, then arrival.
+    static bool covers(LimitKind kind, long long amount, const Job& request);
+    static bool covers(const CachedResult& result, const Job& request);
+
+    void networkLoop();
+    void batchLoop();
+    void handleLine(std::uint32_t connection, const std::string& line);
+    void handleGo(std::uint32_t connection, std::istringstream& in);
+    void cancelRequest(std::uint32_t connection, const std::string& id);
+    void dropConnection(std::uint32_t connection);
+    void reply(std::uint32_t connection, const std::string& line);
+
+    // Called with `mutex` held.
+    bool popShallow(std::shared_ptr<Job>& job, int priorityLimit);
+    ///< Most urgent queued shallow job whose priority is below priorityLimit.
+    void startJob(Job& job);
+    void startDeepJobs();
+    void forgetJob(const std::shared_ptr<Job>& job);
+    void storeResult(const CachedResult& result);
+    void recordWait(Priority priority, long long micros);
+
+    void finishJob(const std::shared_ptr<Job>& job, const SearchResult& result, bool complete);
+    void finishDeepJob(const std::shared_ptr<Job>& job, Bot& bot);
+    bool isDeep(LimitKind kind, long long amount) const;
+    SearchLimits limitsFor(const Job& job) const;
+    std::string resultLine(const std::string& id, const Board& board, const CachedResult& result,
+        const char* source, long long waitMs) const;
+    std::string statsLine();
+
+    AnalysisOptions options;
+    SocketHandle listener{ INVALID_SOCKET_HANDLE };
+    int port{ 0 };
+    std::atomic<bool> running{ false };
+    std::thread networkThread;
+    std::vector<std::thread> batchThreads;
+
+    LineServer connections;
+
+    std::shared_ptr<TranspositionTable> table;
+    std::vector<std::unique_ptr<Bot>> deepBots;
+    std::unique_ptr<SearchScheduler> scheduler;
+
+    // Guarded by `mutex`: jobs, queues, cache and counters.
+    std::mutex mutex;
+    std::condition_variable shallowReady;
+    std::unordered_map<std::uint64_t, std::shared_ptr<Job>> inFlight;   ///< Newest job per position.
+    std::map<std::pair<std::uint32_t, std::string>, std::shared_ptr<Job>> requests;
+    std::vector<QueueEntry> shallowQueue;   ///< Heap on runsLater.
+    std::vector<QueueEntry> deepQueue;      ///< Heap on runsLater; waits for a free deep Bot.
+    std::vector<Bot*> freeBots;
+    int urgentDeepRunning{ 0 };
+    std::list<CachedResult> cache;          ///< Most recently used first.
+    std::unordered_map<std::uint64_t, std::list<CachedResult>::iterator> cacheIndex;
+    std::uint64_t nextSeq{ 0 };
+    long long requestCount{ 0 };
+    long long cacheHits{ 0 };
+    long long sharedHits{ 0 };
+    long long shallowSearches{ 0 };
+    long long deepSearches{ 0 };
+    long long cancelledCount{ 0 };
+    std::vector<long long> urgentWaits;     ///< Recent queueing delays in microseconds (rings).
+    std::vector<long long> otherWaits;
+    std::size_t urgentNext{ 0 };
+    std::size_t otherNext{ 0 };
+};
+
+int runAnalysisServer(const std::vector<std::string>& args);   ///< "analysisd" mode.
+
+#endif // ANALYSIS_SERVER_H
@@ -0,0 +1,366 @@
+/**
+ * @file Bench.cpp
+ * @brief Fixed-position search benchmarks.
+ *
+ * Positions are reached by playing short move sequences (coordinate notation, e.g. "e2e4")
+ * from the initial position, so the benchmark needs nothing but the Board itself. The
+ * "bench" signature uses its own, larger set of FEN positions.
+ */
+#include "Bench.h"
+#include "Board.h"
+#include "Bot.h"
+#include "SearchScheduler.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    const char* const benchLines[] = {
+        "",
+        "e2e4 e7e5 g1f3 b8c6 f1c4 g8f6",
+        "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6 c1g5 f8e7",
+        "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6",
+        "e2e4 e7e6 d2d4 d7d5 b1c3 f8b4 e4e5 c7c5 a2a3 b4c3 b2c3",
+        "c2c4 e7e5 b1c3 g8f6 g2g3 d7d5 c4d5 f6d5 f1g2 d5b6",
+        "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 d2d3 b7b5 a4b3 d7d6 c2c3",
+        "d2d4 g8f6 c2c4 g7g6 b1c3 f8g7 e2e4 d7d6 g1f3 e7e5 d4e5 d6e5 d1d8 e8d8"
+    };
+
+    // Positions of the "bench" signature: openings, middlegames and endgames, a few with the
+    // side to move in check. Changing this list changes the signature.
+    const char* const signatureFens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+        "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+        "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+        "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+        "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+        "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w - - 0 13",
+        "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+        "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+        "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b - - 0 11",
+        "r1bq1b1r/ppp3kp/3p1n2/4p3/2B1P3/8/PPP2PPP/RNBQK2R w - - 0 8",
+        "r2q1rk1/1ppnbppp/p2p1nb1/3Pp3/2P1P1P1/2N2N1P/PPB1QP2/R1B2RK1 b - - 0 13",
+        "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w - - 1 10",
+        "r1b1kb1r/ppp2ppp/2n5/3qp3/8/2N5/PPPP1PPP/R1BQKBNR w - - 0 5",
+        "r2qk2r/pp2bppp/2n1pn2/3p1b2/2PP4/1QN1PN2/PP3PPP/R1B1KB1R w - - 0 8",
+        "3r2k1/pp3ppp/4p3/8/2P5/1P3P2/P4KPP/3R4 w - - 0 25",
+        "6k1/5pp1/7p/8/8/4B2P/5PP1/6K1 w - - 0 40",
+        "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+        "8/8/1k6/2b5/2pP4/8/5K2/8 b - - 0 1",
+        "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+        "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 0 1",
+        "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+        "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+        "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+        "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+        "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+        "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+        "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+        "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+        "8/8/8/8/8/5k2/6p1/6K1 w - - 0 1",
+        "6k1/8/6KP/8/8/2B5/8/8 b - - 0 1",
+        "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w - - 0 4",
+        "rnbqkbnr/pp1ppppp/8/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R b - - 1 2",
+        "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b - - 3 3",
+        "rnbqkb1r/ppp1pppp/5n2/3p4/3P1B2/5N2/PPP1PPPP/RN1QKB1R b - - 3 3",
+        "rnbqk2r/ppppppbp/5np1/8/2PP4/2N5/PP2PPPP/R1BQKBNR w - - 2 4",
+        "r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/2P2N2/PP1P1PPP/RNBQK2R w - - 1 5",
+        "rnbqkb1r/1p2pppp/p2p1n2/8/3NP3/2N5/PPP2PPP/R1BQKB1R w - - 0 6",
+        "r1bqkb1r/5ppp/p1np1n2/1p2p1B1/4P3/N1N5/PPP2PPP/R2QKB1R w - - 0 9",
+        "rnbq1rk1/ppp1ppbp/3p1np1/8/2PPP3/2N2N2/PP3PPP/R1BQKB1R w - - 1 6",
+        "r2qkbnr/ppp2ppp/2np4/4p3/2B1P1b1/2N2N2/PPPP1PPP/R1BQK2R w - - 2 5",
+        "2kr3r/ppp2ppp/2n5/2b1q3/4p3/2P1B3/PP1NQPPP/R4RK1 w - - 0 14",
+        "r4rk1/1b2qppp/p3pn2/1pn5/3N4/2NBB3/PPP2PPP/R2Q1RK1 w - - 4 13",
+        "2r2rk1/1bqnbppp/pp1ppn2/8/2PNP3/1PN1B3/P1Q1BPPP/R4RK1 w - - 0 12",
+        "r4rk1/pp3ppp/2n1b3/q1pp2B1/8/P1Q2NP1/1PP1PP1P/2KR3R w - - 0 15",
+        "8/pp2k1pp/2p1pn2/8/3P4/2PB1P2/PP4PP/6K1 w - - 0 26",
+        "8/5pk1/4p1p1/1p1pP3/1P1P2P1/r6P/5K2/R7 w - - 0 40",
+        "8/1p3k2/p1p3p1/P1P1p1Pp/1P2P2P/5K2/8/8 w - - 0 45",
+        "2r5/5pk1/4b1p1/1p1pP2p/3P3P/2RB2P1/5PK1/8 w - - 0 35"
+    };
+
+    struct Config {
+        const char* name;
+        bool nullMove;
+        bool lmr;
+        bool futility;
+    };
+
+    bool playLine(Board& board, const std::string& line) {
+        std::istringstream in(line);
+        std::string mv;
+        while (in >> mv) {
+            int fx = mv[0] - 'a', fy = 8 - (mv[1] - '0');
+            int tx = mv[2] - 'a', ty = 8 - (mv[3] - '0');
+            Piece* piece = board.getPieceAt(fx, fy);
+            if (!piece || !board.movePiece(piece->getId(), tx, ty).first) {
+                std::cerr << "Bench line rejected at move " << mv << ": " << line << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Board> benchPositions() {
+        std::vector<Board> positions;
+        for (const char* line : benchLines) {
+            Board board;
+            if (playLine(board, line)) {
+                positions.push_back(board);
+            }
+        }
+        return positions;
+    }
+
+    // Completion time and result of every search in one scheduling mode.
+    struct SchedulerRun {
+        double wallMs = 0;
+        std::vector<double> doneMs;
+        std::vector<long long> nodes;
+        std::vector<PackedMove> moves;
+        long long slices = 0;
+    };
+
+    std::vector<std::unique_ptr<Bot>> makeSchedulerBots(const std::vector<Board>& boards, int depth) {
+        std::vector<std::unique_ptr<Bot>> bots;
+        for (const Board& board : boards) {
+            bots.emplace_back(new Bot(board.currentPlayerColor));
+            bots.back()->setHashSize(1);
+            SearchLimits limits;
+            limits.maxDepth = depth;
+            limits.moveTimeMs = 0;
+            bots.back()->setSearchLimits(limits);
+        }
+        return bots;
+    }
+
+    double elapsedMs(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    void recordResult(SchedulerRun& run, size_t i, const Bot& bot, std::chrono::steady_clock::time_point start) {
+        run.doneMs[i] = elapsedMs(start);
+        run.nodes[i] = bot.getLastResult().nodes;
+        run.moves[i] = bot.getLastResult().bestMove;
+    }
+
+    // One OS thread per search: the kernel time-slices them.
+    SchedulerRun runThreadPerSearch(std::vector<Board> boards, int depth) {
+        std::vector<std::unique_ptr<Bot>> bots = makeSchedulerBots(boards, depth);
+        SchedulerRun run;
+        run.doneMs.resize(boards.size());
+        run.nodes.resize(boards.size());
+        run.moves.resize(boards.size());
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < boards.size(); ++i) {
+            threads.emplace_back([&, i] {
+                bots[i]->think(boards[i]);
+                recordResult(run, i, *bots[i], start);
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        run.wallMs = elapsedMs(start);
+        return run;
+    }
+
+    // Every search on the scheduler; deadlines are offsets from the start (all equal = round robin).
+    SchedulerRun runScheduled(const std::vector<Board>& boards, int depth, int workers, long long sliceNodes,
+        const std::vector<double>& deadlineMs) {
+        std::vector<std::unique_ptr<Bot>> bots = makeSchedulerBots(boards, depth);
+        SchedulerRun run;
+        run.doneMs.resize(boards.size());
+        run.nodes.resize(boards.size());
+        run.moves.resize(boards.size());
+        SearchScheduler scheduler(workers, sliceNodes);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < boards.size(); ++i) {
+            auto deadline = start + std::chrono::microseconds(static_cast<long long>(deadlineMs[i] * 1000));
+            scheduler.submit(*bots[i], boards[i], deadline, [&run, i, start](Bot& bot) {
+                recordResult(run, i, bot, start);
+            });
+        }
+        scheduler.wait();
+        run.wallMs = elapsedMs(start);
+        run.slices = scheduler.getSliceCount();
+        return run;
+    }
+
+    // Jain's index of the searches' progress rates: 1 = all advanced equally fast.
+    double fairnessIndex(const SchedulerRun& run) {
+        double sum = 0, sumSquares = 0;
+        for (size_t i = 0; i < run.nodes.size(); ++i) {
+            double rate = run.nodes[i] / std::max(run.doneMs[i], 0.001);
+            sum += rate;
+            sumSquares += rate * rate;
+        }
+        return sumSquares > 0 ? sum * sum / (run.nodes.size() * sumSquares) : 0.0;
+    }
+
+    void printSchedulerRun(const std::string& name, const SchedulerRun& run, const std::vector<double>& deadlineMs) {
+        long long total = 0;
+        int met = 0;
+        for (size_t i = 0; i < run.nodes.size(); ++i) {
+            total += run.nodes[i];
+            if (run.doneMs[i] <= deadlineMs[i]) ++met;
+        }
+        std::vector<double> done = run.doneMs;
+        std::sort(done.begin(), done.end());
+        std::cout << std::left << std::setw(18) << name << std::right << std::fixed << std::setprecision(0)
+            << std::setw(10) << run.wallMs
+            << std::setw(10) << (run.wallMs > 0 ? total / run.wallMs : 0.0)
+            << std::setw(10) << done[done.size() / 2]
+            << std::setw(10) << done.back()
+            << std::setw(8) << met << "/" << std::left << std::setw(5) << run.nodes.size() << std::right
+            << std::setw(9) << std::setprecision(3) << fairnessIndex(run) << "\n";
+    }
+}
+
+void runPruningBenchmark(int maxDepth) {
+    const Config configs[] = {
+        { "none",       false, false, false },
+        { "null move",  true,  false, false },
+        { "lmr",        false, true,  false },
+        { "futility",   false, false, true  },
+        { "all",        true,  true,  true  }
+    };
+
+    std::vector<Board> positions = benchPositions();
+
+    std::cout << "Pruning benchmark: " << positions.size() << " positions, nodes summed per depth\n";
+    std::cout << std::left << std::setw(12) << "config";
+    for (int d = 1; d <= maxDepth; ++d) {
+        std::cout << std::right << std::setw(12) << ("d" + std::to_string(d));
+    }
+    std::cout << std::setw(8) << "EBF" << std::setw(10) << "ms" << "\n";
+
+    for (const Config& config : configs) {
+        SearchParams params;
+        params.nullMove = config.nullMove;
+        params.lateMoveReductions = config.lmr;
+        params.futility = config.futility;
+        params.reverseFutility = config.futility;
+
+        std::vector<long long> nodesAtDepth(maxDepth + 1, 0);
+        auto start = std::chrono::steady_clock::now();
+        for (int d = 1; d <= maxDepth; ++d) {
+            for (Board& position : positions) {
+                // A fresh bot per search keeps the numbers independent of search order.
+                Bot bot(position.currentPlayerColor);
+                SearchLimits limits;
+                limits.maxDepth = d;
+                limits.moveTimeMs = 0;
+                bot.setSearchLimits(limits);
+                bot.setSearchParams(params);
+                bot.think(position);
+                nodesAtDepth[d] += bot.getNodeCount();
+            }
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::left << std::setw(12) << config.name << std::right;
+        for (int d = 1; d <= maxDepth; ++d) {
+            std::cout << std::setw(12) << nodesAtDepth[d];
+        }
+        // Effective branching factor over the last iteration.
+        double ebf = (maxDepth > 1 && nodesAtDepth[maxDepth - 1] > 0)
+            ? double(nodesAtDepth[maxDepth]) / double(nodesAtDepth[maxDepth - 1]) : 0.0;
+        std::cout << std::setw(8) << std::fixed << std::setprecision(2) << ebf
+            << std::setw(10) << ms << "\n";
+    }
+}
+
+void runSchedulerBenchmark(int searches, int depth, long long sliceNodes) {
+    std::vector<Board> positions = benchPositions();
+    if (positions.empty() || searches < 1) return;
+    std::vector<Board> boards;
+    for (int i = 0; i < searches; ++i) {
+        boards.push_back(positions[i % positions.size()]);
+    }
+    int workers = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << "Scheduler benchmark: " << searches << " searches to depth " << depth << ", "
+        << workers << " scheduler workers, slices of " << sliceNodes << " nodes\n";
+    SchedulerRun threads = runThreadPerSearch(boards, depth);
+
+    // Deadlines spread evenly over the time the thread-per-search run needed.
+    std::vector<double> deadlines(boards.size()), sameDeadline(boards.size(), 0.0);
+    for (size_t i = 0; i < boards.size(); ++i) {
+        deadlines[i] = threads.wallMs * double(i + 1) / double(boards.size());
+    }
+    SchedulerRun roundRobin = runScheduled(boards, depth, workers, sliceNodes, sameDeadline);
+    SchedulerRun deadlineFirst = runScheduled(boards, depth, workers, sliceNodes, deadlines);
+
+    std::cout << std::left << std::setw(18) << "mode" << std::right << std::setw(10) << "wall ms"
+        << std::setw(10) << "knps" << std::setw(10) << "p50 ms" << std::setw(10) << "max ms"
+        << std::setw(14) << "deadlines met" << std::setw(9) << "fairness" << "\n";
+    printSchedulerRun("thread per search", threads, deadlines);
+    printSchedulerRun("round robin", roundRobin, deadlines);
+    printSchedulerRun("deadline first", deadlineFirst, deadlines);
+
+    // Slicing must not change the search: same nodes and moves as the uninterrupted runs.
+    bool identical = threads.nodes == roundRobin.nodes && threads.nodes == deadlineFirst.nodes &&
+        threads.moves == roundRobin.moves && threads.moves == deadlineFirst.moves;
+    std::cout << "Slices run: " << roundRobin.slices << " (round robin), " << deadlineFirst.slices
+        << " (deadline first); results identical to unsliced searches: " << (identical ? "yes" : "NO") << std::endl;
+}
+
+std::vector<std::string> getBenchPositions() {
+    return std::vector<std::string>(std::begin(signatureFens), std::end(signatureFens));
+}
+
+void runBench(int depth) {
+    const int hashMb = 16;
+    int count = static_cast<int>(sizeof(signatureFens) / sizeof(signatureFens[0]));
+    std::shared_ptr<const NnueNetwork> network = NnueNetwork::getDefault();
+    std::cout << "Bench: " << count << " positions, depth " << depth << ", 1 thread, " << hashMb << " MB hash, "
+        << (network ? "NNUE" : "hand-written") << " evaluation" << std::endl;
+
+    long long totalNodes = 0;
+    double totalMs = 0;
+#ifdef CHESS_ALLOC_TRACKING
+    AllocTracker::Snapshot allocations;
+#endif
+    for (int i = 0; i < count; ++i) {
+        Board board;
+        board.loadFromFen(signatureFens[i]);
+        // A fresh bot per position, so the signature doesn't depend on what was searched before.
+        Bot bot(board.currentPlayerColor);
+        bot.setHashSize(hashMb);
+        SearchLimits limits;
+        limits.maxDepth = depth;
+        limits.moveTimeMs = 0;
+        bot.setSearchLimits(limits);
+
+        auto start = std::chrono::steady_clock::now();
+        PackedMove best = bot.think(board);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalNodes += bot.getNodeCount();
+        totalMs += ms;
+#ifdef CHESS_ALLOC_TRACKING
+        allocations += bot.getLastResult().allocations;
+#endif
+        std::cout << "Position " << std::setw(2) << (i + 1) << "/" << count << std::setw(12) << bot.getNodeCount()
+            << " nodes  " << (best ? packedMoveToString(best) : std::string("none")) << std::endl;
+    }
+
+    std::cout << "===========================\n"
+        << "Total time (ms) : " << static_cast<long long>(totalMs) << "\n"
+        << "Nodes searched  : " << totalNodes << "\n"
+        << "Nodes/second    : " << static_cast<long long>(totalMs > 0 ? totalNodes * 1000.0 / totalMs : 0.0) << std::endl;
+#ifdef CHESS_ALLOC_TRACKING
+    std::cout << "Allocations     : " << AllocTracker::report(allocations, totalNodes) << std::endl;
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Search a fixed set of positions to each depth with every pruning technique
+ *        switched on or off, and print node counts per depth.
+ * @param maxDepth Deepest iteration to measure.
+ *
+ * The positions and node counts are deterministic, so the table shows how much each of
+ * null move, late move reductions and futility pruning cuts the tree (the effective
+ * branching factor) independently of machine speed.
+ */
+void runPruningBenchmark(int maxDepth);
+
+/**
+ * @brief Run many fixed-depth searches concurrently, first one thread per search, then
+ *        time-sliced on a SearchScheduler with one worker per hardware thread.
+ * @param searches   Number of searches (the benchmark positions, repeated as needed).
+ * @param depth      Depth of every search.
+ * @param sliceNodes Nodes per scheduler slice.
+ *
+ * The scheduler runs twice: round robin (equal deadlines) and earliest deadline first, with
+ * deadlines spread evenly over the thread-per-search run's wall time. Each mode reports
+ * throughput, median and last completion time, deadlines met and Jain's fairness index of
+ * the searches' progress rates, and the sliced results are checked against the unsliced ones.
+ */
+void runSchedulerBenchmark(int searches, int depth, long long sliceNodes);
+
+/**
+ * @brief Search the embedded signature positions to a fixed depth on one thread and print
+ *        the total node count, time and nodes per second ("bench" mode).
+ * @param depth Depth of every search.
+ *
+ * Every search runs through Bot::think() with a fresh bot and hash table, so the total node
+ * count depends only on the search and evaluation code (and on the network, if one is
+ * loaded): a change that keeps it is a pure speed change, one that alters it changed what
+ * the engine does.
+ */
+void runBench(int depth);
+
+/**
+ * @brief The FEN positions of the bench signature, also the corpus of the microbenchmarks.
+ */
+std::vector<std::string> getBenchPositions();
+
+#endif // BENCH_H
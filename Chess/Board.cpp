@@ -5,15 +5,56 @@
  * This file provides the implementation of the Board class defined in Board.h, including
  * initialization of the board with pieces, move execution, check and checkmate detection,
  * and saving/loading game state to a file. The Board class uses advanced C++ features such as
- * STL containers (vector, array, stack) to manage collections of pieces and moves, and
+ * STL containers (vector, array) to manage collections of pieces and moves, and
  * an overloaded assignment operator for copying board state.
  */
 #include "Board.h"
+#include "Trace.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <stdexcept>
+#include <limits>
+#include <sstream>
+
+namespace {
+    // Zobrist keys indexed by [color][piece type][square], plus the side-to-move key. They are
+    // generated once from a fixed seed so hashes are reproducible between runs.
+    struct ZobristKeys {
+        std::uint64_t pieces[2][6][64];
+        std::uint64_t blackToMove;
+
+        ZobristKeys() {
+            std::uint64_t seed = 0x9E3779B97F4A7C15ULL;
+            auto next = [&seed]() {
+                // splitmix64
+                std::uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                return z ^ (z >> 31);
+                };
+            for (auto& color : pieces) {
+                for (auto& type : color) {
+                    for (auto& square : type) {
+                        square = next();
+                    }
+                }
+            }
+            blackToMove = next();
+        }
+    };
+
+    const ZobristKeys& zobrist() {
+        static const ZobristKeys keys;
+        return keys;
+    }
+
+    std::uint64_t pieceKey(Color color, PieceType type, int x, int y) {
+        return zobrist().pieces[static_cast<int>(color)][static_cast<int>(type)][y * 8 + x];
+    }
+}
 
 Board::Board() {
     // Initialize the board array with null pointers (no pieces placed yet).
@@ -70,9 +111,11 @@ Board::Board() {
     createAndPlacePiece(PieceType::BISHOP, Color::BLACK, idCounter++, 5, 0);
     createAndPlacePiece(PieceType::KNIGHT, Color::BLACK, idCounter++, 6, 0);
     createAndPlacePiece(PieceType::ROOK, Color::BLACK, idCounter++, 7, 0);
+    recomputeHashKey();
 }
 
 Board::Board(const Board& other) {
+    PROFILE_SCOPE(Phase::BOARD_COPY);
     // Copy basic state flags.
     gameRunning = other.gameRunning;
     currentPlayerColor = other.currentPlayerColor;
@@ -106,14 +149,18 @@ Board::Board(const Board& other) {
             }
         }
     }
-    // Copy move history stack (shallow copy of Moves, which is fine as they contain pointers and ids).
+    // Moves refer to pieces by id and slot, so the history copies as is.
     moveHistory = other.moveHistory;
+    trialMoves = other.trialMoves;
+    hashKey = other.hashKey;
+    pawnKey = other.pawnKey;
 }
 
 Board& Board::operator=(const Board& other) {
     if (this == &other) {
         return *this;
     }
+    PROFILE_SCOPE(Phase::BOARD_COPY);
     // Copy basic state flags.
     gameRunning = other.gameRunning;
     currentPlayerColor = other.currentPlayerColor;
@@ -147,10 +194,14 @@ Board& Board::operator=(const Board& other) {
         }
     }
     moveHistory = other.moveHistory;
+    trialMoves = other.trialMoves;
+    hashKey = other.hashKey;
+    pawnKey = other.pawnKey;
     return *this;
 }
 
 void Board::displayBoard() const {
+    PROFILE_SCOPE(Phase::BOARD_DISPLAY);
     // Display column labels
     std::cout << "  A B C D E F G H\n";
     for (int row = 0; row < 8; ++row) {
@@ -168,7 +219,7 @@ void Board::displayBoard() const {
     }
     std::cout << "Current Player: " << (currentPlayerColor == Color::WHITE ? "White" : "Black") << "\n";
     // Warn if current player's king is in check.
-    if (isPlayerInCheck(currentPlayerColor)) {
+    if (isPlayerChecked()) {
         std::cout << "You are in check!\n";
     }
 }
@@ -205,6 +256,24 @@ SquareStatus Board::getSquareStatus(int x, int y) const {
 }
 
 std::pair<bool, Piece*> Board::movePiece(int pieceId, int newX, int newY) {
+    PROFILE_SCOPE(Phase::MOVE_EXECUTION);
+    std::pair<bool, Piece*> result = applyMove(pieceId, newX, newY);
+    if (!result.first) {
+        return result;
+    }
+    // Check if this move has delivered checkmate to the opponent. The check test is kept with
+    // the move, for isPlayerChecked().
+    bool check = isPlayerInCheck(currentPlayerColor);
+    moveHistory.setLastCheck(check);
+    if (check && !hasLegalMove(currentPlayerColor)) {
+        gameRunning = false;
+        std::cout << (currentPlayerColor == Color::WHITE ? "Black" : "White") << " wins by checkmate!\n";
+    }
+    return result;
+}
+
+std::pair<bool, Piece*> Board::applyMove(int pieceId, int newX, int newY) {
+    PROFILE_SCOPE(Phase::MOVE_EXECUTION);
     // Find the piece by ID.
     Piece* piece = getPieceById(pieceId);
     if (!piece || !piece->isAlive()) {
@@ -220,35 +289,17 @@ std::pair<bool, Piece*> Board::movePiece(int pieceId, int newX, int newY) {
     if (it == validMoves.end()) {
         return { false, nullptr };  // Move not in list of valid moves.
     }
-    // Save original position.
-    int oldX = piece->getX();
-    int oldY = piece->getY();
-    // Check if there's a piece at the destination (potential capture).
-    Piece* capturedPiece = boardArray[newY][newX];
-    if (capturedPiece && capturedPiece->getColor() != piece->getColor()) {
-        // Capture the opponent's piece.
-        capturedPiece->setIsAlive(false);
-        // Remove the captured piece from the board.
-        boardArray[newY][newX] = nullptr;
+    // Execute the move (capture, relocation and auto-promotion) and record it in the move history,
+    // with a keyframe of the position before it every MoveHistory::KEYFRAME_INTERVAL plies.
+    if (moveHistory.needsKeyframe()) {
+        moveHistory.addKeyframe(makeKeyframe());
     }
-    // Move the piece: clear its old position and update its coordinates.
-    boardArray[oldY][oldX] = nullptr;
-    piece->setLocation(newX, newY);
-    boardArray[newY][newX] = piece;
-    // Pawn promotion: if a pawn reaches the opposite end, auto-promote to Queen by default.
-    if (piece->getType() == PieceType::PAWN && (newY == 0 || newY == 7)) {
-        piece->setType(PieceType::QUEEN);
-    }
-    // Record this move in the move history stack.
-    Move lastMove = { pieceId, {oldX, oldY}, {newX, newY}, capturedPiece };
-    moveHistory.push(lastMove);
+    Move lastMove;
+    placeMove(piece, newX, newY, lastMove);
+    Piece* capturedPiece = pieceInSlot(lastMove.capturedSlot);
+    moveHistory.record(lastMove);
     // Switch turn to the other player.
     currentPlayerColor = (currentPlayerColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
-    // Check if this move has delivered checkmate to the opponent.
-    if (isCheckmate(currentPlayerColor)) {
-        gameRunning = false;
-        std::cout << (currentPlayerColor == Color::WHITE ? "Black" : "White") << " wins by checkmate!\n";
-    }
     return { true, capturedPiece };
 }
 
@@ -269,96 +320,354 @@ Piece* Board::getPieceById(int pieceId) {
 }
 
 bool Board::isPlayerInCheck(Color playerColor) const {
-    // Locate the king of the given color.
-    Piece* king = nullptr;
-    const std::vector<Piece>& pieces = (playerColor == Color::WHITE) ? whitePieces : blackPieces;
-    for (const Piece& piece : pieces) {
-        if (piece.getType() == PieceType::KING && piece.isAlive()) {
-            king = const_cast<Piece*>(&piece);
-            break;
-        }
-    }
+    PROFILE_SCOPE(Phase::LEGALITY);
+    const Piece* king = findKing(playerColor);
     if (!king) {
         return false;
     }
-    // Check all enemy pieces to see if any can move to the king's position.
-    const std::vector<Piece>& enemyPieces = (playerColor == Color::WHITE) ? blackPieces : whitePieces;
-    for (const Piece& enemy : enemyPieces) {
-        if (enemy.isAlive()) {
-            std::vector<std::pair<int, int>> enemyMoves = enemy.getAllValidMoves(*this);
-            for (const auto& move : enemyMoves) {
-                if (move.first == king->getX() && move.second == king->getY()) {
-                    return true;
-                }
+    Color enemy = (playerColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    return isSquareAttacked(king->getX(), king->getY(), enemy, -1, -1);
+}
+
+bool Board::leavesKingInCheck(int fromX, int fromY, int toX, int toY) const {
+    PROFILE_SCOPE(Phase::LEGALITY);
+    const Piece* mover = getPieceAt(fromX, fromY);
+    if (!mover) {
+        return false;
+    }
+    Color side = mover->getColor();
+    Color enemy = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    if (mover->getType() == PieceType::KING) {
+        return isSquareAttacked(toX, toY, enemy, fromY * 8 + fromX, toY * 8 + toX);
+    }
+    const Piece* king = findKing(side);
+    return king && isSquareAttacked(king->getX(), king->getY(), enemy, fromY * 8 + fromX, toY * 8 + toX);
+}
+
+bool Board::hasLegalMove(Color playerColor) const {
+    const std::vector<Piece>& pieces = (playerColor == Color::WHITE) ? whitePieces : blackPieces;
+    std::vector<std::pair<int, int>> targets;
+    for (const Piece& piece : pieces) {
+        if (!piece.isAlive()) continue;
+        targets.clear();
+        piece.generateMoves(*this, MoveGenType::ALL, targets);
+        for (const auto& t : targets) {
+            if (!leavesKingInCheck(piece.getX(), piece.getY(), t.first, t.second)) {
+                return true;
             }
         }
     }
     return false;
 }
 
-bool Board::isCheckmate(Color playerColor) {
-    // If the player is not in check, it can't be checkmate.
-    if (!isPlayerInCheck(playerColor)) {
-        return false;
+bool Board::isCheckmate(Color playerColor) const {
+    PROFILE_SCOPE(Phase::CHECKMATE);
+    return isPlayerInCheck(playerColor) && !hasLegalMove(playerColor);
+}
+
+bool Board::isStalemate(Color playerColor) const {
+    PROFILE_SCOPE(Phase::CHECKMATE);
+    return !isPlayerInCheck(playerColor) && !hasLegalMove(playerColor);
+}
+
+const Piece* Board::findKing(Color color) const {
+    const std::vector<Piece>& pieces = (color == Color::WHITE) ? whitePieces : blackPieces;
+    for (const Piece& piece : pieces) {
+        if (piece.getType() == PieceType::KING && piece.isAlive()) {
+            return &piece;
+        }
     }
-    // Try all possible moves for all pieces of the player. If any move results in the player no longer being in check, it's not checkmate.
-    std::vector<Piece>& pieces = (playerColor == Color::WHITE) ? whitePieces : blackPieces;
-    for (Piece& piece : pieces) {
-        if (piece.isAlive()) {
-            std::vector<std::pair<int, int>> moves = piece.getAllValidMoves(*this);
-            for (const auto& move : moves) {
-                Piece* capturedPiece = makeMoveForCheck(piece.getId(), move.first, move.second);
-                bool stillInCheck = isPlayerInCheck(playerColor);
-                undoMoveForCheck();
-                if (!stillInCheck) {
-                    return false;  // Found a move that escapes check.
-                }
-            }
+    return nullptr;
+}
+
+bool Board::isSquareAttacked(int x, int y, Color by, int vacated, int occupied) const {
+    // The board as it would be with the piece on `vacated` moved to `occupied` (a capture
+    // there removes the captured piece, which therefore attacks nothing).
+    auto occupant = [&](int sx, int sy) -> const Piece* {
+        int square = sy * 8 + sx;
+        if (square == vacated) return nullptr;
+        if (square == occupied) return getPieceAt(vacated % 8, vacated / 8);
+        return getPieceAt(sx, sy);
+    };
+    auto attacker = [&](int sx, int sy, PieceType a, PieceType b) {
+        if (sx < 0 || sx > 7 || sy < 0 || sy > 7) return false;
+        const Piece* p = occupant(sx, sy);
+        return p && p->getColor() == by && (p->getType() == a || p->getType() == b);
+    };
+
+    // Pawns capture towards the opponent: a white pawn attacks from the rank below.
+    int pawnY = (by == Color::WHITE) ? y + 1 : y - 1;
+    if (attacker(x - 1, pawnY, PieceType::PAWN, PieceType::PAWN) ||
+        attacker(x + 1, pawnY, PieceType::PAWN, PieceType::PAWN)) {
+        return true;
+    }
+    static const int knightSteps[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+    static const int kingSteps[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+    for (int i = 0; i < 8; ++i) {
+        if (attacker(x + knightSteps[i][0], y + knightSteps[i][1], PieceType::KNIGHT, PieceType::KNIGHT) ||
+            attacker(x + kingSteps[i][0], y + kingSteps[i][1], PieceType::KING, PieceType::KING)) {
+            return true;
         }
     }
-    return true;  // No move can escape check: checkmate.
+    // Sliders: the first piece along each ray, orthogonal rays for rooks, diagonal for bishops.
+    for (int i = 0; i < 8; ++i) {
+        int dx = kingSteps[i][0], dy = kingSteps[i][1];
+        PieceType slider = (dx == 0 || dy == 0) ? PieceType::ROOK : PieceType::BISHOP;
+        for (int sx = x + dx, sy = y + dy; sx >= 0 && sx < 8 && sy >= 0 && sy < 8; sx += dx, sy += dy) {
+            if (!occupant(sx, sy)) continue;
+            if (attacker(sx, sy, slider, PieceType::QUEEN)) return true;
+            break;
+        }
+    }
+    return false;
 }
 
 Piece* Board::makeMoveForCheck(int pieceId, int newX, int newY) {
-    // Similar to movePiece but used for hypothetical moves (does not switch turn or permanently update moveHistory beyond this function).
+    // Similar to movePiece but used for hypothetical moves (does not switch turn or touch moveHistory).
     Piece* piece = getPieceById(pieceId);
     if (!piece) {
         return nullptr;
     }
+    Move tempMove;
+    placeMove(piece, newX, newY, tempMove);
+    // Keep this hypothetical move for undoMoveForCheck.
+    trialMoves.push_back(tempMove);
+    return pieceInSlot(tempMove.capturedSlot);
+}
+
+void Board::placeMove(Piece* piece, int newX, int newY, Move& record) {
+    // Save original position.
     int oldX = piece->getX();
     int oldY = piece->getY();
+    record.pieceId = piece->getId();
+    record.from = { oldX, oldY };
+    record.to = { newX, newY };
+    record.capturedSlot = -1;
+    record.promoted = false;
+    record.promotedTo = PieceType::QUEEN;
+    // Check if there's a piece at the destination (potential capture).
     Piece* capturedPiece = boardArray[newY][newX];
     if (capturedPiece && capturedPiece->getColor() != piece->getColor()) {
+        // Capture the opponent's piece and remove it from the board.
         capturedPiece->setIsAlive(false);
         boardArray[newY][newX] = nullptr;
+        toggleKey(capturedPiece->getColor(), capturedPiece->getType(), newX, newY);
+        record.capturedSlot = slotOf(capturedPiece);
     }
+    // Move the piece: clear its old position and update its coordinates.
     boardArray[oldY][oldX] = nullptr;
     piece->setLocation(newX, newY);
     boardArray[newY][newX] = piece;
-    // Push this hypothetical move on the stack for undo.
-    Move tempMove = { pieceId, {oldX, oldY}, {newX, newY}, capturedPiece };
-    moveHistory.push(tempMove);
-    return capturedPiece;
+    toggleKey(piece->getColor(), piece->getType(), oldX, oldY);
+    // Pawn promotion: if a pawn reaches the opposite end, auto-promote to Queen by default.
+    if (piece->getType() == PieceType::PAWN && (newY == 0 || newY == 7)) {
+        piece->setType(PieceType::QUEEN);
+        record.promoted = true;
+    }
+    toggleKey(piece->getColor(), piece->getType(), newX, newY);
 }
 
 void Board::undoMoveForCheck() {
-    if (moveHistory.empty()) {
+    if (trialMoves.empty()) {
         return;
     }
-    Move lastMove = moveHistory.top();
-    moveHistory.pop();
-    Piece* piece = getPieceById(lastMove.pieceId);
+    Move lastMove = trialMoves.back();
+    trialMoves.pop_back();
+    unplaceMove(lastMove);
+}
+
+void Board::unplaceMove(const Move& record) {
+    Piece* piece = getPieceById(record.pieceId);
     if (!piece) {
         return;
     }
-    // Restore piece's original position.
-    boardArray[lastMove.to.second][lastMove.to.first] = nullptr;
-    piece->setLocation(lastMove.from.first, lastMove.from.second);
-    boardArray[lastMove.from.second][lastMove.from.first] = piece;
+    // Restore piece's original position (and type, if the move promoted it).
+    toggleKey(piece->getColor(), piece->getType(), record.to.first, record.to.second);
+    if (record.promoted) {
+        piece->setType(PieceType::PAWN);
+    }
+    boardArray[record.to.second][record.to.first] = nullptr;
+    piece->setLocation(record.from.first, record.from.second);
+    boardArray[record.from.second][record.from.first] = piece;
+    toggleKey(piece->getColor(), piece->getType(), record.from.first, record.from.second);
     // Revive any captured piece (undo capture).
-    if (lastMove.capturedPiece) {
-        lastMove.capturedPiece->setIsAlive(true);
-        boardArray[lastMove.to.second][lastMove.to.first] = lastMove.capturedPiece;
+    if (Piece* captured = pieceInSlot(record.capturedSlot)) {
+        captured->setIsAlive(true);
+        boardArray[record.to.second][record.to.first] = captured;
+        toggleKey(captured->getColor(), captured->getType(), record.to.first, record.to.second);
+    }
+}
+
+void Board::replayMove(const Move& record) {
+    Piece* piece = getPieceById(record.pieceId);
+    if (!piece) {
+        return;
+    }
+    Move replayed;
+    placeMove(piece, record.to.first, record.to.second, replayed);
+    if (record.promoted && record.promotedTo != piece->getType()) {
+        toggleKey(piece->getColor(), piece->getType(), piece->getX(), piece->getY());
+        piece->setType(record.promotedTo);
+        toggleKey(piece->getColor(), piece->getType(), piece->getX(), piece->getY());
+    }
+}
+
+Piece* Board::pieceInSlot(int slot) {
+    if (slot < 0) {
+        return nullptr;
+    }
+    return slot < 16 ? &whitePieces[slot] : &blackPieces[slot - 16];
+}
+
+int Board::slotOf(const Piece* piece) const {
+    if (piece->getColor() == Color::WHITE) {
+        return static_cast<int>(piece - whitePieces.data());
+    }
+    return 16 + static_cast<int>(piece - blackPieces.data());
+}
+
+PositionKeyframe Board::makeKeyframe() const {
+    PositionKeyframe keyframe;
+    // Captured pieces may stand off the board at (-1,-1) (see loadFromFile); that gets a flag of its
+    // own so it cannot spill into the other fields.
+    auto pack = [](const Piece& p) {
+        bool onBoard = p.getX() >= 0 && p.getX() < 8 && p.getY() >= 0 && p.getY() < 8;
+        int square = onBoard ? p.getX() | (p.getY() << 3) : 0;
+        return static_cast<std::uint16_t>(square | (static_cast<int>(p.getType()) << 6)
+            | ((p.isAlive() ? 1 : 0) << 9) | ((onBoard ? 0 : 1) << 10));
+    };
+    for (std::size_t i = 0; i < whitePieces.size(); ++i) {
+        keyframe.slots[i] = pack(whitePieces[i]);
+    }
+    for (std::size_t i = 0; i < blackPieces.size(); ++i) {
+        keyframe.slots[16 + i] = pack(blackPieces[i]);
+    }
+    keyframe.sideToMove = currentPlayerColor;
+    return keyframe;
+}
+
+void Board::restoreKeyframe(const PositionKeyframe& keyframe) {
+    // The slots are the same pieces as when the keyframe was taken: pieces are only added on loading,
+    // which clears the history.
+    for (auto& row : boardArray) {
+        row.fill(nullptr);
+    }
+    auto unpack = [this](Piece& p, std::uint16_t state) {
+        if ((state >> 10) & 1) {
+            p.setLocation(-1, -1);
+        }
+        else {
+            p.setLocation(state & 7, (state >> 3) & 7);
+        }
+        p.setType(static_cast<PieceType>((state >> 6) & 7));
+        p.setIsAlive(((state >> 9) & 1) != 0);
+        if (p.isAlive()) {
+            boardArray[p.getY()][p.getX()] = &p;
+        }
+    };
+    for (std::size_t i = 0; i < whitePieces.size(); ++i) {
+        unpack(whitePieces[i], keyframe.slots[i]);
+    }
+    for (std::size_t i = 0; i < blackPieces.size(); ++i) {
+        unpack(blackPieces[i], keyframe.slots[16 + i]);
+    }
+    currentPlayerColor = keyframe.sideToMove;
+    recomputeHashKey();
+}
+
+int Board::getPly() const {
+    return moveHistory.ply();
+}
+
+void Board::jumpToPly(int ply) {
+    if (ply < 0 || ply > moveHistory.length()) {
+        throw std::out_of_range("No position at ply " + std::to_string(ply) + " of this game.");
+    }
+    // Restoring a keyframe costs about as much as a few unmakes; otherwise step from wherever is
+    // closest: the current position, the keyframe at or below the target, or the one above it.
+    const int RESTORE_COST = 4;
+    const int interval = MoveHistory::KEYFRAME_INTERVAL;
+    int start = moveHistory.ply();
+    int cost = std::abs(ply - start);
+    int keyframe = -1;
+    int below = std::min(ply / interval, moveHistory.keyframeCount() - 1);
+    if (below >= 0 && RESTORE_COST + ply - below * interval < cost) {
+        keyframe = below;
+        cost = RESTORE_COST + ply - below * interval;
+    }
+    int above = (ply + interval - 1) / interval;
+    if (above > below && above < moveHistory.keyframeCount() && RESTORE_COST + above * interval - ply < cost) {
+        keyframe = above;
+    }
+    if (keyframe >= 0) {
+        restoreKeyframe(moveHistory.keyframe(keyframe));
+        start = keyframe * interval;
+    }
+    for (int i = start; i < ply; ++i) {
+        replayMove(moveHistory[i]);
+    }
+    for (int i = start; i > ply; --i) {
+        unplaceMove(moveHistory[i - 1]);
+    }
+    if ((start - ply) % 2 != 0) {
+        currentPlayerColor = (currentPlayerColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    }
+    moveHistory.setPly(ply);
+}
+
+bool Board::takeBack() {
+    if (moveHistory.empty()) {
+        return false;
+    }
+    jumpToPly(moveHistory.ply() - 1);
+    return true;
+}
+
+void Board::promotePiece(int pieceId, PieceType newType) {
+    // Change the type of a piece on the board (e.g. an under-promotion chosen by the player).
+    Piece* piece = getPieceById(pieceId);
+    if (!piece) {
+        return;
+    }
+    toggleKey(piece->getColor(), piece->getType(), piece->getX(), piece->getY());
+    piece->setType(newType);
+    toggleKey(piece->getColor(), piece->getType(), piece->getX(), piece->getY());
+    if (trialMoves.empty() && moveHistory.ply() > 0 && moveHistory.back().pieceId == pieceId) {
+        moveHistory.setLastPromotion(newType);
+    }
+}
+
+std::uint64_t Board::getHashKey() const {
+    return hashKey;
+}
+
+std::uint64_t Board::getPositionKey(Color sideToMove) const {
+    // The piece placement key plus the side to move, as used by the transposition table.
+    return hashKey ^ (sideToMove == Color::BLACK ? zobrist().blackToMove : 0);
+}
+
+std::uint64_t Board::getPawnKey() const {
+    return pawnKey;
+}
+
+void Board::toggleKey(Color color, PieceType type, int x, int y) {
+    std::uint64_t key = pieceKey(color, type, x, y);
+    hashKey ^= key;
+    if (type == PieceType::PAWN) {
+        pawnKey ^= key;
+    }
+}
+
+void Board::recomputeHashKey() {
+    hashKey = 0;
+    pawnKey = 0;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            Piece* piece = getPieceAt(x, y);
+            if (piece) {
+                toggleKey(piece->getColor(), piece->getType(), x, y);
+            }
+        }
     }
 }
 
@@ -370,12 +679,20 @@ bool Board::isGameRunning() const {
     return gameRunning;
 }
 
-bool Board::isPlayerChecked() {
-    // Convenience function to check current player's check status.
+bool Board::isPlayerChecked() const {
+    // Convenience function to check current player's check status. movePiece already tested the
+    // position after the last move; its answer holds while that move is still the last on the board.
+    if (trialMoves.empty() && !moveHistory.empty() && moveHistory.back().givesCheck >= 0) {
+        const Move& last = moveHistory.back();
+        const Piece* moved = getPieceAt(last.to.first, last.to.second);
+        if (moved && moved->getId() == last.pieceId && moved->getColor() != currentPlayerColor) {
+            return last.givesCheck != 0;
+        }
+    }
     return isPlayerInCheck(currentPlayerColor);
 }
 
-bool Board::checkMate() {
+bool Board::checkMate() const {
     // Convenience function to check current player's checkmate status.
     return isCheckmate(currentPlayerColor);
 }
@@ -403,6 +720,7 @@ std::string Board::getSymbol(const Piece& piece) const {
 }
 
 void Board::saveToFile(const std::string& filename) const {
+    PROFILE_SCOPE(Phase::SAVE_LOAD);
     std::ofstream outFile(filename);
     if (!outFile.is_open()) {
         throw std::runtime_error("Failed to open file for saving: " + filename);
@@ -448,6 +766,7 @@ void Board::saveToFile(const std::string& filename) const {
 }
 
 void Board::loadFromFile(const std::string& filename) {
+    PROFILE_SCOPE(Phase::SAVE_LOAD);
     std::ifstream inFile(filename);
     if (!inFile.is_open()) {
         throw std::runtime_error("Failed to open file for loading: " + filename);
@@ -462,9 +781,8 @@ void Board::loadFromFile(const std::string& filename) {
     blackPieces.clear();
     whitePieces.reserve(16);
     blackPieces.reserve(16);
-    while (!moveHistory.empty()) {
-        moveHistory.pop();
-    }
+    moveHistory.clear();
+    trialMoves.clear();
 
     std::string line;
     // Read current player line.
@@ -490,94 +808,211 @@ void Board::loadFromFile(const std::string& filename) {
         throw std::runtime_error("Save file format error: invalid player color.");
     }
 
+    // Read one color's pieces, one "ID TYPE ALIVE X Y" line each, up to `endLabel` (or the end
+    // of the file). Saves of games list all 16 pieces; positions set up from a FEN list fewer.
+    auto readPieces = [&](Color color, const char* endLabel) {
+        const char* side = color == Color::WHITE ? "white" : "black";
+        std::vector<Piece>& pieces = color == Color::WHITE ? whitePieces : blackPieces;
+        while (std::getline(inFile, line)) {
+            if (endLabel && line.find(endLabel) != std::string::npos) return;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            std::istringstream fields(line);
+            int id, aliveFlag, x, y;
+            std::string typeStr;
+            if (!(fields >> id >> typeStr >> aliveFlag >> x >> y)) {
+                throw std::runtime_error(std::string("Save file format error: bad ") + side + " piece line '" + line + "'.");
+            }
+            // Convert type string to PieceType.
+            PieceType type;
+            if (typeStr == "PAWN") type = PieceType::PAWN;
+            else if (typeStr == "KNIGHT") type = PieceType::KNIGHT;
+            else if (typeStr == "BISHOP") type = PieceType::BISHOP;
+            else if (typeStr == "ROOK") type = PieceType::ROOK;
+            else if (typeStr == "QUEEN") type = PieceType::QUEEN;
+            else if (typeStr == "KING") type = PieceType::KING;
+            else {
+                throw std::runtime_error("Save file format error: unknown piece type '" + typeStr + "'.");
+            }
+            bool isAlive = (aliveFlag == 1);
+            if (pieces.size() >= 16) {
+                throw std::runtime_error(std::string("Save file format error: more than 16 ") + side + " pieces.");
+            }
+            if (isAlive && (x < 0 || x > 7 || y < 0 || y > 7 || boardArray[y][x])) {
+                throw std::runtime_error(std::string("Save file format error: bad ") + side + " piece square.");
+            }
+            Piece piece;
+            piece.setId(id);
+            piece.setType(type);
+            piece.setColor(color);
+            piece.setIsAlive(isAlive);
+            // Captured pieces keep the -1,-1 placeholder location.
+            piece.setLocation(x, y);
+            pieces.push_back(piece);
+            if (isAlive) {
+                boardArray[y][x] = &pieces.back();
+            }
+        }
+        if (endLabel) {
+            throw std::runtime_error(std::string("Save file format error: missing ") + endLabel + " section.");
+        }
+    };
+
     // Expect "WhitePieces:" label.
     if (!std::getline(inFile, line) || line.find("WhitePieces:") == std::string::npos) {
         throw std::runtime_error("Save file format error: missing WhitePieces section.");
     }
-    // Read 16 white pieces.
-    for (int i = 0; i < 16; ++i) {
-        int id, aliveFlag, x, y;
-        std::string typeStr;
-        if (!(inFile >> id >> typeStr >> aliveFlag >> x >> y)) {
-            throw std::runtime_error("Save file format error: insufficient white piece data.");
-        }
-        // Convert type string to PieceType.
-        PieceType type;
-        if (typeStr == "PAWN") type = PieceType::PAWN;
-        else if (typeStr == "KNIGHT") type = PieceType::KNIGHT;
-        else if (typeStr == "BISHOP") type = PieceType::BISHOP;
-        else if (typeStr == "ROOK") type = PieceType::ROOK;
-        else if (typeStr == "QUEEN") type = PieceType::QUEEN;
-        else if (typeStr == "KING") type = PieceType::KING;
-        else {
-            throw std::runtime_error("Save file format error: unknown piece type '" + typeStr + "'.");
-        }
-        bool isAlive = (aliveFlag == 1);
-        Piece piece;
-        piece.setId(id);
-        piece.setType(type);
-        piece.setColor(Color::WHITE);
-        piece.setIsAlive(isAlive);
-        // If piece is alive, set its location and place it on board; if not alive, use -1,-1 as placeholder location.
-        if (isAlive) {
-            piece.setLocation(x, y);
-            boardArray[y][x] = &piece;
+    readPieces(Color::WHITE, "BlackPieces:");
+    readPieces(Color::BLACK, nullptr);
+    requireKings("Save file format error");
+    // Set game as running since we loaded a game in progress (the player whose turn is currentPlayerColor will move next).
+    gameRunning = true;
+    recomputeHashKey();
+    inFile.close();
+}
+
+const MoveHistory& Board::getMoveHistory() const {
+    return moveHistory;
+}
+
+const Move* Board::getLastMove() const {
+    return moveHistory.empty() ? nullptr : &moveHistory.back();
+}
+
+void Board::loadFromFen(const std::string& fen) {
+    std::istringstream in(fen);
+    std::string placement, side;
+    if (!(in >> placement >> side)) {
+        throw std::runtime_error("FEN error: expected piece placement and side to move.");
+    }
+    // Castling rights, en passant square and move counters are accepted but not used:
+    // this engine doesn't implement castling or en passant.
+
+    clearPieces();
+
+    static const std::unordered_map<char, PieceType> letterToType = {
+        {'p', PieceType::PAWN}, {'n', PieceType::KNIGHT}, {'b', PieceType::BISHOP},
+        {'r', PieceType::ROOK}, {'q', PieceType::QUEEN}, {'k', PieceType::KING}
+    };
+    int x = 0, y = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (x != 8) {
+                throw std::runtime_error("FEN error: rank " + std::to_string(8 - y) + " does not have 8 files.");
+            }
+            ++y;
+            x = 0;
+            continue;
         }
-        else {
-            piece.setLocation(x, y);
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            x += c - '0';
+            continue;
         }
-        whitePieces.push_back(piece);
-        // After push_back, update the board pointer to this piece (address might have changed).
-        if (isAlive) {
-            boardArray[y][x] = &whitePieces.back();
+        auto it = letterToType.find(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        if (it == letterToType.end() || x >= 8 || y >= 8) {
+            throw std::runtime_error(std::string("FEN error: unexpected '") + c + "' in piece placement.");
         }
+        Color color = std::isupper(static_cast<unsigned char>(c)) ? Color::WHITE : Color::BLACK;
+        addPiece(it->second, color, x, y, "FEN error");
+        ++x;
+    }
+    if (y != 7 || x != 8) {
+        throw std::runtime_error("FEN error: piece placement does not cover 8 ranks.");
     }
-    inFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // consume the rest of the line if any
+    requireKings("FEN error");
 
-    // Expect "BlackPieces:" label.
-    if (!std::getline(inFile, line) || line.find("BlackPieces:") == std::string::npos) {
-        throw std::runtime_error("Save file format error: missing BlackPieces section.");
+    if (side == "w") {
+        currentPlayerColor = Color::WHITE;
     }
-    // Read 16 black pieces.
-    for (int i = 0; i < 16; ++i) {
-        int id, aliveFlag, x, y;
-        std::string typeStr;
-        if (!(inFile >> id >> typeStr >> aliveFlag >> x >> y)) {
-            throw std::runtime_error("Save file format error: insufficient black piece data.");
-        }
-        PieceType type;
-        if (typeStr == "PAWN") type = PieceType::PAWN;
-        else if (typeStr == "KNIGHT") type = PieceType::KNIGHT;
-        else if (typeStr == "BISHOP") type = PieceType::BISHOP;
-        else if (typeStr == "ROOK") type = PieceType::ROOK;
-        else if (typeStr == "QUEEN") type = PieceType::QUEEN;
-        else if (typeStr == "KING") type = PieceType::KING;
-        else {
-            throw std::runtime_error("Save file format error: unknown piece type '" + typeStr + "'.");
-        }
-        bool isAlive = (aliveFlag == 1);
-        Piece piece;
-        piece.setId(id);
-        piece.setType(type);
-        piece.setColor(Color::BLACK);
-        piece.setIsAlive(isAlive);
-        if (isAlive) {
-            piece.setLocation(x, y);
-            boardArray[y][x] = &piece;
-        }
-        else {
-            piece.setLocation(x, y);
-        }
-        blackPieces.push_back(piece);
-        if (isAlive) {
-            boardArray[y][x] = &blackPieces.back();
+    else if (side == "b") {
+        currentPlayerColor = Color::BLACK;
+    }
+    else {
+        throw std::runtime_error("FEN error: side to move must be 'w' or 'b'.");
+    }
+    gameRunning = true;
+    recomputeHashKey();
+}
+
+void Board::loadFromSquares(const std::uint8_t* squares, Color sideToMove) {
+    clearPieces();
+    for (int square = 0; square < 64; ++square) {
+        std::uint8_t code = squares[square];
+        if (code == 0) continue;
+        int type = (code & 7) - 1;
+        if (type < 0 || type > static_cast<int>(PieceType::KING) || code > 15) {
+            throw std::runtime_error("Position error: bad piece code " + std::to_string(code) + ".");
         }
+        addPiece(static_cast<PieceType>(type), (code & 8) ? Color::BLACK : Color::WHITE, square % 8, square / 8,
+            "Position error");
     }
-    // Set game as running since we loaded a game in progress (the player whose turn is currentPlayerColor will move next).
+    requireKings("Position error");
+    currentPlayerColor = sideToMove;
     gameRunning = true;
-    inFile.close();
+    recomputeHashKey();
 }
 
-std::stack<Move> Board::getMoveHistory() const {
-    return moveHistory;
+void Board::clearPieces() {
+    for (auto& row : boardArray) {
+        row.fill(nullptr);
+    }
+    whitePieces.clear();
+    blackPieces.clear();
+    // Board squares point into these vectors, so they must never reallocate.
+    whitePieces.reserve(16);
+    blackPieces.reserve(16);
+    moveHistory.clear();
+    trialMoves.clear();
+}
+
+void Board::addPiece(PieceType type, Color color, int x, int y, const char* context) {
+    std::vector<Piece>& pieces = (color == Color::WHITE) ? whitePieces : blackPieces;
+    if (pieces.size() >= 16) {
+        throw std::runtime_error(std::string(context) + ": more than 16 pieces for one side.");
+    }
+    Piece piece;
+    piece.setType(type);
+    piece.setColor(color);
+    piece.setId(static_cast<int>(pieces.size()) + (color == Color::WHITE ? 1 : 17));
+    piece.setLocation(x, y);
+    piece.setIsAlive(true);
+    pieces.push_back(piece);
+    boardArray[y][x] = &pieces.back();
+}
+
+void Board::requireKings(const char* context) const {
+    auto hasKing = [](const std::vector<Piece>& pieces) {
+        return std::any_of(pieces.begin(), pieces.end(),
+            [](const Piece& p) { return p.getType() == PieceType::KING; });
+        };
+    if (!hasKing(whitePieces) || !hasKing(blackPieces)) {
+        throw std::runtime_error(std::string(context) + ": each side needs a king.");
+    }
+}
+
+std::string Board::toFen() const {
+    std::string fen;
+    for (int y = 0; y < 8; ++y) {
+        int empty = 0;
+        for (int x = 0; x < 8; ++x) {
+            Piece* piece = getPieceAt(x, y);
+            if (!piece) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            fen += getSymbol(*piece);
+        }
+        if (empty > 0) {
+            fen += static_cast<char>('0' + empty);
+        }
+        if (y < 7) {
+            fen += '/';
+        }
+    }
+    fen += (currentPlayerColor == Color::WHITE) ? " w" : " b";
+    fen += " - - 0 1";
+    return fen;
 }
@@ -6,8 +6,9 @@
 #include <utility>
 #include <unordered_map>
 #include <string>
-#include <stack>
+#include <cstdint>
 #include "Piece.h"
+#include "MoveHistory.h"
 
 struct SquareStatus {
     bool           isOccupied = false;
@@ -16,12 +17,26 @@ struct SquareStatus {
     int            pieceId = 0;
 };
 
-struct Move {
-    int                      pieceId;
-    std::pair<int, int>       from;
-    std::pair<int, int>       to;
-    Piece* capturedPiece = nullptr;
-};
+// Compact from/to encoding used by the search and the transposition table (0 = no move).
+using PackedMove = std::uint16_t;
+
+inline PackedMove packMove(int fromX, int fromY, int toX, int toY) {
+    return static_cast<PackedMove>((fromY * 8 + fromX) | ((toY * 8 + toX) << 6));
+}
+inline int packedFromX(PackedMove m) { return m & 7; }
+inline int packedFromY(PackedMove m) { return (m >> 3) & 7; }
+inline int packedToX(PackedMove m) { return (m >> 6) & 7; }
+inline int packedToY(PackedMove m) { return (m >> 9) & 7; }
+
+// Coordinate notation ("e2e4") of a packed move.
+inline std::string packedMoveToString(PackedMove m) {
+    std::string s(4, ' ');
+    s[0] = static_cast<char>('a' + packedFromX(m));
+    s[1] = static_cast<char>('8' - packedFromY(m));
+    s[2] = static_cast<char>('a' + packedToX(m));
+    s[3] = static_cast<char>('8' - packedToY(m));
+    return s;
+}
 
 class Board {
 public:
@@ -37,10 +52,27 @@ public:
 
     // move execution & validation
     std::pair<bool, Piece*> movePiece(int pieceId, int newX, int newY);
-    bool isPlayerInCheck(Color playerColor) const;
-    bool isCheckmate(Color playerColor);
-    Piece* makeMoveForCheck(int pieceId, int newX, int newY);
+    std::pair<bool, Piece*> applyMove(int pieceId, int newX, int newY);  // movePiece without checkmate detection/output
+    Piece* makeMoveForCheck(int pieceId, int newX, int newY);  // hypothetical: kept off the game's history
     void undoMoveForCheck();
+    void promotePiece(int pieceId, PieceType newType);
+
+    // navigating the game's history (no hypothetical moves may be pending)
+    int getPly() const;                          // moves played to reach this position
+    void jumpToPly(int ply);                     // 0 to getMoveHistory().length(); throws std::out_of_range
+    bool takeBack();                             // jump back one move; false at the start
+
+    // read-only queries: they never modify the board, so many threads may share one Board
+    bool isPlayerInCheck(Color playerColor) const;
+    bool leavesKingInCheck(int fromX, int fromY, int toX, int toY) const;  // would this move expose its own king?
+    bool hasLegalMove(Color playerColor) const;
+    bool isCheckmate(Color playerColor) const;
+    bool isStalemate(Color playerColor) const;
+
+    // hashing (Zobrist keys of the piece placement, maintained incrementally)
+    std::uint64_t getHashKey() const;
+    std::uint64_t getPositionKey(Color sideToMove) const;
+    std::uint64_t getPawnKey() const;      // pawns only, for the evaluation's pawn hash
 
     // control
     void setGameRunning(bool running);
@@ -51,11 +83,17 @@ public:
     Piece* getPieceById(int pieceId);
     void saveToFile(const std::string& filename) const;
     void loadFromFile(const std::string& filename);
-    std::stack<Move> getMoveHistory() const;
+    void loadFromFen(const std::string& fen);   // throws std::runtime_error on malformed input
+    std::string toFen() const;
+    // 64 square codes from a8 to h1: 0 = empty, 1-6 = white P N B R Q K, 9-14 = black.
+    // Throws std::runtime_error like loadFromFen; reuses the board's storage.
+    void loadFromSquares(const std::uint8_t* squares, Color sideToMove);
+    const MoveHistory& getMoveHistory() const;  // the moves up to this position, iterable without copying
+    const Move* getLastMove() const;            // nullptr before the first move
 
-    // convenience wrappers (must be NON‑CONST to match Board.cpp)
-    bool isPlayerChecked();
-    bool checkMate();
+    // convenience wrappers for the side to move
+    bool isPlayerChecked() const;               // reuses movePiece's check test of the last move
+    bool checkMate() const;
 
     // board state
     std::vector<Piece>                      whitePieces;
@@ -65,7 +103,26 @@ public:
 
 private:
     bool gameRunning{ true };
-    std::stack<Move> moveHistory;
+    MoveHistory moveHistory;
+    std::vector<Move> trialMoves;   // makeMoveForCheck's moves, undone in reverse
+    std::uint64_t hashKey{ 0 };
+    std::uint64_t pawnKey{ 0 };
+
+    void placeMove(Piece* piece, int newX, int newY, Move& record);
+    void unplaceMove(const Move& record);
+    void replayMove(const Move& record);        // placeMove of a recorded move, with its promotion
+    Piece* pieceInSlot(int slot);
+    int slotOf(const Piece* piece) const;
+    PositionKeyframe makeKeyframe() const;
+    void restoreKeyframe(const PositionKeyframe& keyframe);
+    void toggleKey(Color color, PieceType type, int x, int y);
+    void recomputeHashKey();
+    void clearPieces();
+    void addPiece(PieceType type, Color color, int x, int y, const char* context);  // throws when a side is full
+    void requireKings(const char* context) const;
+    const Piece* findKing(Color color) const;
+    // Is (x, y) attacked by `by` once the piece on square `vacated` (y * 8 + x, -1 = none) stands on `occupied`?
+    bool isSquareAttacked(int x, int y, Color by, int vacated, int occupied) const;
 };
 
 #endif // BOARD_H
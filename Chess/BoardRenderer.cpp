@@ -0,0 +1,124 @@
+/**
+ * @file BoardRenderer.cpp
+ * @brief ANSI escape sequences for BoardRenderer's full and differential frames.
+ */
+#include "BoardRenderer.h"
+#include "Trace.h"
+#ifdef _WIN32
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#endif
+
+namespace {
+    // Screen layout (1-based rows): file letters, eight ranks, the side to move, the check
+    // warning; text scrolls below.
+    const int RANK_ROW = 2;          // row of rank 8
+    const int STATUS_ROW = 10;
+    const int WARNING_ROW = 11;
+    const int TEXT_ROW = 12;
+
+    // Windows consoles interpret escape sequences only when asked to.
+    void enableEscapes() {
+#ifdef _WIN32
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (console != INVALID_HANDLE_VALUE && GetConsoleMode(console, &mode)) {
+            SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        }
+#endif
+    }
+}
+
+BoardRenderer::BoardRenderer(std::ostream& out) : out(out) {
+    frame.reserve(1024);
+}
+
+BoardRenderer::~BoardRenderer() {
+    release();
+}
+
+void BoardRenderer::moveTo(int row, int column) {
+    frame += "\x1b[";
+    frame += std::to_string(row);
+    frame += ';';
+    frame += std::to_string(column);
+    frame += 'H';
+}
+
+void BoardRenderer::invalidate() {
+    drawn = false;
+}
+
+void BoardRenderer::release() {
+    if (!drawn) {
+        return;
+    }
+    out << "\x1b[r" << std::flush;   // scroll region back to the whole screen
+    drawn = false;
+}
+
+void BoardRenderer::render(const Board& board) {
+    PROFILE_SCOPE(Phase::BOARD_DISPLAY);
+    frame.clear();
+    bool full = !drawn;
+    if (full) {
+        enableEscapes();
+        // Clear the screen and draw the labels, then let the differential pass draw the rest.
+        frame += "\x1b[r\x1b[2J\x1b[H  A B C D E F G H";
+        for (int row = 0; row < 8; ++row) {
+            moveTo(RANK_ROW + row, 1);
+            frame += static_cast<char>('8' - row);
+        }
+        shown.fill(0);
+        shownStatus.clear();
+        shownWarning.clear();
+    }
+    else {
+        frame += "\x1b" "7";   // save the cursor of the text area
+    }
+    for (int y = 0; y < 8; ++y) {
+        int next = -1;   // file the cursor stands before after the last write, if on this rank
+        for (int x = 0; x < 8; ++x) {
+            Piece* piece = board.getPieceAt(x, y);
+            char symbol = piece ? board.getSymbol(*piece)[0] : '.';
+            if (shown[y * 8 + x] == symbol) {
+                continue;
+            }
+            // Right after the previous square only the separating space is between: cheaper than an escape.
+            if (x == next) {
+                frame += ' ';
+            }
+            else {
+                moveTo(RANK_ROW + y, 3 + 2 * x);
+            }
+            frame += symbol;
+            shown[y * 8 + x] = symbol;
+            next = x + 1;
+        }
+    }
+    std::string status = std::string("Current Player: ") + (board.currentPlayerColor == Color::WHITE ? "White" : "Black");
+    if (status != shownStatus) {
+        moveTo(STATUS_ROW, 1);
+        frame += "\x1b[2K" + status;
+        shownStatus = status;
+    }
+    std::string warning = board.isPlayerChecked() ? "You are in check!" : "";
+    if (full || warning != shownWarning) {
+        moveTo(WARNING_ROW, 1);
+        frame += "\x1b[2K" + warning;
+        shownWarning = warning;
+    }
+    if (full) {
+        // Text scrolls in the rows below the board; setting the region homes the cursor.
+        frame += "\x1b[" + std::to_string(TEXT_ROW) + "r";
+        moveTo(TEXT_ROW, 1);
+        drawn = true;
+    }
+    else {
+        frame += "\x1b" "8";
+    }
+    out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+    out.flush();
+}
@@ -0,0 +1,40 @@
+#ifndef BOARD_RENDERER_H
+#define BOARD_RENDERER_H
+
+#include <array>
+#include <ostream>
+#include <string>
+#include "Board.h"
+
+/**
+ * @class BoardRenderer
+ * @brief Keeps the board drawn at the top of an ANSI terminal, redrawing only what changed.
+ *
+ * The first render clears the screen, draws the board and its status lines, and makes the rest
+ * of the screen a scrolling region for prompts and engine output, so that text never moves the
+ * board. Later renders remember what is on screen and rewrite only the squares and status lines
+ * that differ, with cursor-positioning escapes, leaving the cursor where the text left it. Every
+ * frame is built in one buffer and handed to the stream in a single write. The check warning
+ * uses Board::isPlayerChecked(), which reuses the check test made when the move was played.
+ */
+class BoardRenderer {
+public:
+    explicit BoardRenderer(std::ostream& out);
+    ~BoardRenderer();
+
+    void render(const Board& board);
+    void invalidate();   ///< Redraw everything next time (e.g. after the screen was cleared).
+    void release();      ///< Give the whole screen back to scrolling text.
+
+private:
+    std::ostream& out;
+    bool drawn = false;
+    std::array<char, 64> shown{};   ///< Symbol on screen per square, a8 to h1; 0 = unknown.
+    std::string shownStatus;         ///< The "Current Player" line on screen.
+    std::string shownWarning;        ///< The check line on screen ("" = blank).
+    std::string frame;               ///< Escape sequences of the frame being built, reused.
+
+    void moveTo(int row, int column);
+};
+
+#endif // BOARD_RENDERER_H
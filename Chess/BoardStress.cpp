@@ -0,0 +1,215 @@
+/**
+ * @file BoardStress.cpp
+ * @brief Concurrent read-only queries against shared Boards, checked against single-threaded answers.
+ */
+#include "BoardStress.h"
+#include "Board.h"
+#include "Bot.h"
+#include "Notation.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    const char* const extraFens[] = {
+        "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w - - 1 3",   // checkmate
+        "R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1",                            // back-rank mate
+        "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",                               // stalemate
+        "4k3/8/8/8/8/8/4Q3/4K3 b - - 0 1",                              // check with escapes
+        "4k3/4r3/8/8/8/8/4B3/4K3 w - - 0 1"                             // pinned bishop
+    };
+
+    // Everything the threads are asked about one position.
+    struct Answers {
+        bool check = false;
+        bool checkmate = false;
+        bool stalemate = false;
+        std::vector<PackedMove> moves;
+        int eval = 0;
+
+        bool operator==(const Answers& o) const {
+            return check == o.check && checkmate == o.checkmate && stalemate == o.stalemate &&
+                moves == o.moves && eval == o.eval;
+        }
+    };
+
+    Answers query(const Board& board, Bot& bot) {
+        Color side = board.currentPlayerColor;
+        Answers a;
+        a.check = board.isPlayerInCheck(side);
+        a.checkmate = board.isCheckmate(side);
+        a.stalemate = board.isStalemate(side);
+        a.moves = generateLegalMoves(board, side);
+        a.eval = bot.evaluate(board);
+        return a;
+    }
+
+    // Positions along random games from a fixed seed, so every run checks the same ones.
+    std::vector<Board> stressPositions() {
+        std::vector<Board> positions;
+        std::mt19937 rng(20240611);
+        for (int game = 0; game < 24; ++game) {
+            Board board;
+            for (int ply = 0; ply < 160; ++ply) {
+                std::vector<PackedMove> moves = generateLegalMoves(board, board.currentPlayerColor);
+                if (ply % 3 == 0 || moves.empty()) positions.push_back(board);
+                if (moves.empty()) break;
+                PackedMove move = moves[rng() % moves.size()];
+                Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+                board.applyMove(piece->getId(), packedToX(move), packedToY(move));
+            }
+        }
+        for (const char* fen : extraFens) {
+            positions.emplace_back();
+            positions.back().loadFromFen(fen);
+        }
+        return positions;
+    }
+
+    // Play a random game with random under-promotions, then walk its history with takeBack() and
+    // jumpToPly() and compare every position reached with the one recorded while playing.
+    // Returns the number of positions that differed.
+    int checkHistory(Board board, std::mt19937& rng, int plies) {
+        std::vector<std::string> fens{ board.toFen() };
+        std::vector<std::uint64_t> keys{ board.getPositionKey(board.currentPlayerColor) };
+        for (int ply = 0; ply < plies; ++ply) {
+            std::vector<PackedMove> moves = generateLegalMoves(board, board.currentPlayerColor);
+            if (moves.empty()) break;
+            PackedMove move = moves[rng() % moves.size()];
+            int id = board.getPieceAt(packedFromX(move), packedFromY(move))->getId();
+            board.applyMove(id, packedToX(move), packedToY(move));
+            if (board.getLastMove()->promoted && rng() % 2) {
+                board.promotePiece(id, PieceType::KNIGHT);
+            }
+            fens.push_back(board.toFen());
+            keys.push_back(board.getPositionKey(board.currentPlayerColor));
+        }
+        int last = static_cast<int>(fens.size()) - 1;
+        int wrong = 0;
+        auto compare = [&](int ply) {
+            if (board.getPly() != ply || board.toFen() != fens[ply] ||
+                board.getPositionKey(board.currentPlayerColor) != keys[ply]) {
+                if (wrong++ == 0) {
+                    std::cerr << "boardstress: ply " << ply << " of history replays as " << board.toFen()
+                        << ", played as " << fens[ply] << std::endl;
+                }
+            }
+        };
+        while (board.takeBack()) {
+            compare(board.getPly());
+        }
+        for (int i = 0; i < 4 * last; ++i) {
+            board.jumpToPly(static_cast<int>(rng() % (last + 1)));
+            compare(board.getPly());
+        }
+        board.jumpToPly(last);
+        compare(last);
+        return wrong;
+    }
+
+    // History round trips from the start position, a FEN, and a saved game whose captured pieces
+    // are stored off the board.
+    int checkHistories() {
+        std::mt19937 rng(20240612);
+        int wrong = 0;
+        for (int game = 0; game < 16; ++game) {
+            wrong += checkHistory(Board(), rng, 200);
+        }
+        Board fen;
+        fen.loadFromFen("4k3/1P4P1/8/8/8/8/1p4p1/4K3 w - - 0 1");
+        wrong += checkHistory(fen, rng, 60);
+
+        Board played;
+        for (int ply = 0; ply < 40; ++ply) {
+            std::vector<PackedMove> moves = generateLegalMoves(played, played.currentPlayerColor);
+            if (moves.empty()) break;
+            PackedMove move = moves[0];
+            for (PackedMove m : moves) {
+                if (played.getPieceAt(packedToX(m), packedToY(m))) move = m;   // prefer captures
+            }
+            Piece* piece = played.getPieceAt(packedFromX(move), packedFromY(move));
+            played.applyMove(piece->getId(), packedToX(move), packedToY(move));
+        }
+        const char* saveFile = "boardstress_history.sav";
+        played.saveToFile(saveFile);
+        Board loaded;
+        loaded.loadFromFile(saveFile);
+        std::remove(saveFile);
+        for (int game = 0; game < 4; ++game) {
+            wrong += checkHistory(loaded, rng, 120);
+        }
+        return wrong;
+    }
+}
+
+int runBoardStress(int threads, int seconds) {
+    if (threads <= 0) threads = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+    const std::vector<Board> positions = stressPositions();
+
+    std::vector<Answers> expected;
+    std::vector<std::string> fens;
+    std::vector<std::uint64_t> keys;
+    int mates = 0, stalemates = 0, checks = 0;
+    {
+        Bot bot(Color::WHITE);
+        bot.setHashSize(1);
+        for (const Board& board : positions) {
+            expected.push_back(query(board, bot));
+            fens.push_back(board.toFen());
+            keys.push_back(board.getPositionKey(board.currentPlayerColor));
+            mates += expected.back().checkmate;
+            stalemates += expected.back().stalemate;
+            checks += expected.back().check;
+        }
+    }
+    int historyErrors = checkHistories();
+    std::cout << "Move history: " << historyErrors << " positions differ after takeBack/jumpToPly" << std::endl;
+    std::cout << "Board stress: " << positions.size() << " positions (" << checks << " in check, " << mates
+        << " mate, " << stalemates << " stalemate), " << threads << " threads, " << seconds << " s" << std::endl;
+
+    std::atomic<bool> done(false);
+    std::atomic<long long> queries(0), mismatches(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::unique_ptr<Bot> bot(new Bot(Color::WHITE));
+            bot->setHashSize(1);
+            // Each thread walks the positions from a different offset so that several
+            // threads are inside the same board at any moment.
+            size_t i = static_cast<size_t>(t) * positions.size() / threads;
+            long long count = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (!(query(positions[i], *bot) == expected[i])) {
+                    if (mismatches.fetch_add(1) == 0) {
+                        std::cerr << "boardstress: thread " << t << " got a different answer for " << fens[i] << std::endl;
+                    }
+                }
+                ++count;
+                i = (i + 1) % positions.size();
+            }
+            queries += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    done = true;
+    for (std::thread& w : workers) {
+        w.join();
+    }
+
+    int changed = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (positions[i].toFen() != fens[i] || positions[i].getPositionKey(positions[i].currentPlayerColor) != keys[i]) {
+            if (changed++ == 0) std::cerr << "boardstress: board changed: " << fens[i] << std::endl;
+        }
+    }
+    std::cout << queries.load() << " queries, " << mismatches.load() << " mismatches, " << changed
+        << " boards changed" << std::endl;
+    return mismatches.load() == 0 && changed == 0 && historyErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#ifndef BOARD_STRESS_H
+#define BOARD_STRESS_H
+
+/**
+ * @brief Query shared positions from many threads at once and check every answer
+ *        ("boardstress" mode).
+ * @param threads Number of querying threads (0 = one per hardware thread, at least 4).
+ * @param seconds How long the threads keep querying.
+ * @return 0 if every answer and history position matched and no board changed, 1 otherwise.
+ *
+ * The positions (random games from a fixed seed plus a few mates and stalemates) are
+ * answered once on a single thread: check, checkmate, stalemate, the legal move list and
+ * the static evaluation. Then all threads ask the same questions of the same const Boards,
+ * each with its own Bot for the evaluation, and compare. Afterwards every board must still
+ * have its original FEN and hash key. Build with -fsanitize=thread to have the race
+ * detector watch the shared reads as well. Before that, random games (from the start, a FEN and
+ * a reloaded save with captured pieces) are walked back and forth with Board::takeBack() and
+ * Board::jumpToPly(), and every position must match the one reached while playing.
+ */
+int runBoardStress(int threads, int seconds);
+
+#endif // BOARD_STRESS_H
@@ -1,52 +1,347 @@
 #include "Bot.h"
+#include "MovePicker.h"
+#include "Trace.h"
 #include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
 
 /*
-   Simple minimax?style AI:
-   - validMoves(): generate all safe moves (wont leave own king in check)
-   - makeMove(): test each move to depth=2, pick highest score
+   Alpha-beta AI:
+   - advanceRoot(): iterative deepening up to SearchLimits::maxDepth / moveTimeMs
+   - stepNode(): negamax alpha-beta; moves come from a staged MovePicker
+     (hash move, captures, killers, quiets) and are legality-checked one at a
+     time right after they are made on a single working board
+   - quiescence (Q_ steps): captures-only search so leaves are not scored mid-exchange
+   - forward pruning (each switchable in SearchParams): null move, late move
+     reductions and (reverse) futility pruning near the leaves
+   - evaluation: hand-written material/pawn terms, or an NNUE network whose
+     accumulators are updated incrementally by makeSearchMove/undoSearchMove
+   - principal variation search: full window for the first move, zero windows
+     for the rest; aspiration windows at the root; a triangular PV table
+     records the expected line, reported through getLastResult()
+   - stop()/ponderHit() may be called from another thread; the search polls
+     them with the clock. setThreads() adds Lazy SMP helpers that search the
+     same root on their own threads and share the transposition table
+   - the search is resumable: nodes live on an explicit stack of Frames, each
+     recording the step to continue at, so runSlice() can return after a node
+     budget and pick up exactly where it left off. think() is one unbounded slice
 */
 
-// Execute the best move found
-bool Bot::makeMove(Board& board)
+namespace {
+    const int INF_SCORE = Bot::MATE_SCORE + 1;
+
+    Color opposite(Color c) {
+        return c == Color::WHITE ? Color::BLACK : Color::WHITE;
+    }
+
+    bool isMateScore(int score) {
+        return score >= Bot::MATE_SCORE - Bot::MAX_PLY || score <= -Bot::MATE_SCORE + Bot::MAX_PLY;
+    }
+
+    // Mate scores are stored relative to the node, not the root, so they stay
+    // correct when the position is reached again at a different ply.
+    int scoreToTT(int score, int ply) {
+        if (score >= Bot::MATE_SCORE - Bot::MAX_PLY) return score + ply;
+        if (score <= -Bot::MATE_SCORE + Bot::MAX_PLY) return score - ply;
+        return score;
+    }
+
+    int scoreFromTT(int score, int ply) {
+        if (score >= Bot::MATE_SCORE - Bot::MAX_PLY) return score - ply;
+        if (score <= -Bot::MATE_SCORE + Bot::MAX_PLY) return score + ply;
+        return score;
+    }
+
+    bool isQuietMove(const Board& b, PackedMove move) {
+        if (b.getPieceAt(packedToX(move), packedToY(move))) return false;
+        Piece* p = b.getPieceAt(packedFromX(move), packedFromY(move));
+        int toY = packedToY(move);
+        return !(p && p->getType() == PieceType::PAWN && (toY == 0 || toY == 7));
+    }
+
+    // A side with only king and pawns is the classic zugzwang case where passing
+    // (the null move) is not a lower bound on the real score.
+    bool hasNonPawnMaterial(const Board& b, Color side) {
+        const std::vector<Piece>& pieces = (side == Color::WHITE) ? b.whitePieces : b.blackPieces;
+        for (const Piece& p : pieces) {
+            if (p.isAlive() && p.getType() != PieceType::PAWN && p.getType() != PieceType::KING)
+                return true;
+        }
+        return false;
+    }
+
+    std::atomic<bool> statsLogging{ false };
+}
+
+long long SearchStats::nps() const
+{
+    return timeMs > 0 ? nodes * 1000 / timeMs : nodes;
+}
+
+double SearchStats::ttHitRate() const
+{
+    return ttProbes > 0 ? 100.0 * ttHits / ttProbes : 0.0;
+}
+
+double SearchStats::firstMoveCutoffRate() const
+{
+    return betaCutoffs > 0 ? 100.0 * firstMoveCutoffs / betaCutoffs : 0.0;
+}
+
+void SearchStats::merge(const SearchStats& other)
+{
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    betaCutoffs += other.betaCutoffs;
+    firstMoveCutoffs += other.firstMoveCutoffs;
+}
+
+// "nodes 81234 (q 41.2%) nps 593000 tt 38.5% of 40213 cut 6102 fmc 90.1% ebf 3.10 2.45 ms 0 1 3"
+std::string SearchStats::summary() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "nodes " << nodes << " (q " << (nodes > 0 ? 100.0 * qnodes / nodes : 0.0) << "%)"
+        << " nps " << nps()
+        << " tt " << ttHitRate() << "% of " << ttProbes << " cut " << ttCutoffs
+        << " fmc " << firstMoveCutoffRate() << "%" << std::setprecision(2) << " ebf";
+    for (size_t i = 1; i < iterations.size(); ++i)
+        out << " " << iterations[i].branching;
+    out << " ms";
+    for (const IterationStats& it : iterations)
+        out << " " << it.timeMs;
+    return out.str();
+}
+
+// Also re-arms stop() and ponderHit() for the next search
+void Bot::setSearchLimits(const SearchLimits& newLimits)
+{
+    limits = newLimits;
+    stopRequested = false;
+    pondering = limits.ponder;
+}
+
+const SearchLimits& Bot::getSearchLimits() const
+{
+    return limits;
+}
+
+void Bot::setSearchParams(const SearchParams& newParams)
+{
+    params = newParams;
+    buildReductionTable();
+}
+
+const SearchParams& Bot::getSearchParams() const
 {
-    auto allMoves = validMoves(board, getColor());
-    if (allMoves.empty()) return false;
-
-    int  bestPiece = -1;
-    std::pair<int, int> bestDest;
-    int  bestScore = INT_MIN;
-    Color me = getColor();
-
-    // Traditional iteration (no structured bindings)
-    for (auto it = allMoves.begin(); it != allMoves.end(); ++it) {
-        int id = it->first;
-        const auto& moves = it->second;
-        for (size_t i = 0; i < moves.size(); ++i) {
-            int nx = moves[i].first, ny = moves[i].second;
-            Board tmp = board;
-            if (!tmp.movePiece(id, nx, ny).first) continue;
-            Color next = (me == Color::WHITE ? Color::BLACK : Color::WHITE);
-            int score = evaluateMove(tmp, 2, next);
-            if (score > bestScore) {
-                bestScore = score;
-                bestPiece = id;
-                bestDest = moves[i];
+    return params;
+}
+
+long long Bot::getNodeCount() const
+{
+    return nodes;
+}
+
+void Bot::setNetwork(std::shared_ptr<const NnueNetwork> net)
+{
+    network = net;
+    if (network)
+        nnue.reset(new NnueEvaluator(network, MAX_PLY + 1));
+    else
+        nnue.reset();
+}
+
+std::shared_ptr<const NnueNetwork> Bot::getNetwork() const
+{
+    return network;
+}
+
+void Bot::clearHash()
+{
+    tt->clear();
+    pawnHash.clear();
+}
+
+void Bot::stop()
+{
+    stopRequested = true;
+}
+
+void Bot::ponderHit()
+{
+    pondering = false;
+}
+
+void Bot::setInfoCallback(std::function<void(const SearchResult&)> callback)
+{
+    infoCallback = callback;
+}
+
+void Bot::setThreads(int threads)
+{
+    helpers.clear();
+    for (int i = 1; i < threads; ++i)
+        helpers.emplace_back(new Bot(getColor(), tt));
+}
+
+int Bot::getThreads() const
+{
+    return int(helpers.size()) + 1;
+}
+
+void Bot::setHashSize(std::size_t sizeMb)
+{
+    tt->resize(sizeMb);
+}
+
+// The table is lock-free, so bots on different threads may share one
+void Bot::setHashTable(std::shared_ptr<TranspositionTable> table)
+{
+    tt = table;
+}
+
+const SearchResult& Bot::getLastResult() const
+{
+    return lastResult;
+}
+
+std::string Bot::formatScore(int score)
+{
+    if (isMateScore(score)) {
+        // Moves (not plies) to mate, negative when being mated.
+        int plies = MATE_SCORE - std::abs(score);
+        int moves = (plies + 1) / 2;
+        return std::string("mate ") + (score < 0 ? "-" : "") + std::to_string(moves);
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%+.2f", score / 100.0);
+    return buf;
+}
+
+// Global, like the default network: set once from the command line
+void Bot::setStatsLogging(bool enabled)
+{
+    statsLogging = enabled;
+}
+
+// Spread the clock over the remaining moves, keeping a margin for communication
+int Bot::allocateTime(long long remainingMs, long long incrementMs, int movesToGo)
+{
+    long long mtg = movesToGo > 0 ? movesToGo : 30;
+    long long budget = remainingMs / mtg + incrementMs * 3 / 4;
+    budget = std::min(budget, remainingMs - 50);
+    return int(std::max(budget, 10LL));
+}
+
+PackedMove Bot::think(Board& board)
+{
+    PROFILE_SCOPE(Phase::BOT_MOVE);
+#ifdef CHESS_ALLOC_TRACKING
+    AllocTracker::Snapshot allocationsBefore = AllocTracker::snapshot();
+#endif
+    // Helpers run until the main search finishes; half of them start one ply deeper
+    // so the threads don't all walk the same iterations in lockstep.
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < helpers.size(); ++i) {
+        Bot& h = *helpers[i];
+        SearchLimits helperLimits = limits;
+        helperLimits.infinite = true;
+        helperLimits.ponder = false;
+        helperLimits.maxNodes = 0;
+        h.setColor(getColor());
+        h.setSearchParams(params);
+        h.setSearchLimits(helperLimits);
+        if (h.network != network) h.setNetwork(network);
+        h.tt = tt;
+        h.startDepth = 1 + int((i + 1) % 2);
+        h.beginSearch(board);
+        threads.emplace_back([&h] {
+            PROFILE_SCOPE(Phase::BOT_MOVE);
+            h.runSlice(0);
+        });
+    }
+
+    beginSearch(board);
+    runSlice(0);
+
+    for (auto& h : helpers)
+        h->stop();
+    for (auto& t : threads)
+        t.join();
+    for (auto& h : helpers) {
+        lastResult.nodes += h->nodes;
+        lastResult.stats.merge(h->lastResult.stats);
+    }
+#ifdef CHESS_ALLOC_TRACKING
+    lastResult.allocations = AllocTracker::snapshot() - allocationsBefore;
+#endif
+    return lastResult.bestMove;
+}
+
+// LMR depth reduction, growing with both remaining depth and move number
+void Bot::buildReductionTable()
+{
+    for (int d = 0; d < MAX_PLY; ++d) {
+        for (int m = 0; m < 64; ++m) {
+            if (d == 0 || m == 0) {
+                reductions[d][m] = 0;
+                continue;
             }
+            double r = params.lmrBase + std::log(double(d)) * std::log(double(m)) / params.lmrDivisor;
+            reductions[d][m] = std::max(0, int(r));
         }
     }
+}
 
-    if (bestPiece < 0) return false;
-    auto res = board.movePiece(bestPiece, bestDest.first, bestDest.second);
+// Execute the best move found
+bool Bot::makeMove(Board& board)
+{
+    // Search on a private copy so the real board (and its history) is untouched.
+    PackedMove best = think(board);
+    return playMove(board, best);
+}
+
+// Execute an already searched move, reporting it with the last search's score and PV
+bool Bot::playMove(Board& board, PackedMove best)
+{
+    if (!best) return false;
+
+    int fx = packedFromX(best), fy = packedFromY(best);
+    int tx = packedToX(best), ty = packedToY(best);
+    Piece* piece = board.getPieceAt(fx, fy);
+    if (!piece) return false;
+    auto res = board.movePiece(piece->getId(), tx, ty);
     if (!res.first) return false;
 
-    // Report the move
-    char f1 = 'A' + board.getPieceById(bestPiece)->getX();
-    int  r1 = 8 - board.getPieceById(bestPiece)->getY();
-    char f2 = 'A' + bestDest.first;
-    int  r2 = 8 - bestDest.second;
+    // Report the move, with the score and expected continuation
+    char f1 = 'A' + fx;
+    int  r1 = 8 - fy;
+    char f2 = 'A' + tx;
+    int  r2 = 8 - ty;
     std::cout << "Bot moves " << f1 << r1 << " to " << f2 << r2 << std::endl;
+    std::cout << "  score " << formatScore(lastResult.score) << "  depth " << lastResult.depth << "  pv";
+    for (PackedMove m : lastResult.pv)
+        std::cout << " " << packedMoveToString(m);
+    std::cout << std::endl;
+    double pawnHitRate = lastResult.pawnHashProbes > 0
+        ? 100.0 * lastResult.pawnHashHits / lastResult.pawnHashProbes : 0.0;
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "  nodes " << lastResult.nodes << "  time " << lastResult.timeMs << " ms  pawn hash hits "
+        << std::fixed << std::setprecision(1) << pawnHitRate << "%" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    if (statsLogging.load(std::memory_order_relaxed))
+        std::cout << "  stats " << lastResult.stats.summary() << std::endl;
+#ifdef CHESS_ALLOC_TRACKING
+    std::cout << "  allocs " << AllocTracker::report(lastResult.allocations, lastResult.nodes) << std::endl;
+#endif
 
     if (res.second)
         addCapturedPiece(res.second);
@@ -54,70 +349,546 @@ bool Bot::makeMove(Board& board)
     return true;
 }
 
-// Recursive minimax to given depth
-int Bot::evaluateMove(Board& b, int depth, Color side)
-{
-    if (depth == 0 || !b.isGameRunning())
-        return evaluateBoard(b);
-
-    auto allMoves = validMoves(b, side);
-    if (allMoves.empty()) {
-        // no moves ? stalemate or checkmate
-        if (b.isPlayerInCheck(side))
-            // side is mated
-            return (side == getColor() ? INT_MIN : INT_MAX);
-        return 0;
-    }
-
-    int best = (side == getColor() ? INT_MIN : INT_MAX);
-    for (auto it = allMoves.begin(); it != allMoves.end(); ++it) {
-        int id = it->first;
-        const auto& moves = it->second;
-        for (size_t i = 0; i < moves.size(); ++i) {
-            int nx = moves[i].first, ny = moves[i].second;
-            Board tmp = b;
-            if (!tmp.movePiece(id, nx, ny).first) continue;
-            Color next = (side == Color::WHITE ? Color::BLACK : Color::WHITE);
-            int v = evaluateMove(tmp, depth - 1, next);
-            if (side == getColor()) {
-                if (v > best) best = v;
+// Reset the per-search state; the search itself runs in runSlice()
+void Bot::beginSearch(const Board& board)
+{
+    searchBoard = board;
+    if (frames.empty()) {
+        frames.reserve(2 * MAX_PLY);
+        for (int i = 0; i < 2 * MAX_PLY; ++i)
+            frames.emplace_back(searchBoard);
+    }
+    top = -1;
+    searchStart = std::chrono::steady_clock::now();
+    budgetStart = searchStart;
+    nodes = 0;
+    sharedNodes = 0;
+    stats = SearchStats();
+    iterationStartNodes = 0;
+    iterationStartMs = 0;
+    stopped = false;
+    suspended = false;
+    ponderActive = pondering;
+    pawnHash.resetStats();
+    if (nnue) nnue->reset(searchBoard);
+    for (auto& k : killers) {
+        k[0] = k[1] = 0;
+    }
+
+    lastResult = SearchResult();
+    searchBest = 0;
+    prevScore = 0;
+    rootDepth = startDepth;
+    rootStep = RootStep::START_ITERATION;
+}
+
+// Step the search until it finishes or has used its node budget
+bool Bot::runSlice(long long nodeBudget)
+{
+    if (rootStep == RootStep::DONE) return true;
+    if (suspended) {
+        // Time spent suspended belongs to other searches, not to this move's budget.
+        budgetStart += std::chrono::steady_clock::now() - suspendedAt;
+        suspended = false;
+    }
+    long long sliceEnd = nodeBudget > 0 ? nodes + nodeBudget : LLONG_MAX;
+    while (rootStep != RootStep::DONE) {
+        if (top < 0) {
+            advanceRoot();
+        }
+        else if (nodes >= sliceEnd) {
+            suspended = true;
+            suspendedAt = std::chrono::steady_clock::now();
+            sharedNodes.store(nodes, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            stepNode(frames[top]);
+        }
+    }
+    finishSearch();
+    return true;
+}
+
+bool Bot::isSearching() const
+{
+    return rootStep != RootStep::DONE;
+}
+
+// Iterative deepening: each iteration seeds the next with its hash moves
+void Bot::advanceRoot()
+{
+    if (rootStep == RootStep::START_ITERATION) {
+        if (rootDepth > limits.maxDepth || rootDepth >= MAX_PLY) {
+            rootStep = RootStep::DONE;
+            return;
+        }
+        rootBestMove = 0;
+        // Aspiration: search a narrow window around the last score, widening on failure.
+        rootDelta = params.aspirationWindow;
+        bool aspirate = params.aspiration && rootDepth >= params.aspirationMinDepth && !isMateScore(prevScore);
+        rootAlpha = aspirate ? prevScore - rootDelta : -INF_SCORE;
+        rootBeta = aspirate ? prevScore + rootDelta : INF_SCORE;
+        PROFILE_MARK(iterationTraceStart);
+        pushNode(rootDepth, 0, rootAlpha, rootBeta, getColor(), false);
+        rootStep = RootStep::IN_TREE;
+        return;
+    }
+
+    // A tree search of the current iteration just returned.
+    int score = childScore;
+    if (!stopped) {
+        bool research = false;
+        if (score <= rootAlpha && rootAlpha > -INF_SCORE) {
+            rootAlpha = std::max(score - rootDelta, -INF_SCORE);
+            research = true;
+        }
+        else if (score >= rootBeta && rootBeta < INF_SCORE) {
+            rootBeta = std::min(score + rootDelta, INF_SCORE);
+            research = true;
+        }
+        if (research) {
+            rootDelta *= 2;
+            pushNode(rootDepth, 0, rootAlpha, rootBeta, getColor(), false);
+            return;
+        }
+    }
+    rootStep = RootStep::DONE;
+    PROFILE_COMPLETE(Phase::SEARCH_ITERATION, iterationTraceStart, "depth", rootDepth);
+    if (stopped) {
+        // Only trust a partial iteration if nothing completed at all.
+        if (!searchBest) searchBest = rootBestMove;
+        if (lastResult.pv.empty() && searchBest) lastResult.pv.push_back(searchBest);
+        return;
+    }
+    searchBest = rootBestMove;
+    prevScore = score;
+    lastResult.bestMove = searchBest;
+    lastResult.score = score;
+    lastResult.depth = rootDepth;
+    lastResult.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+    lastResult.nodes = nodes;
+    for (auto& h : helpers)
+        lastResult.nodes += h->sharedNodes.load(std::memory_order_relaxed);
+    lastResult.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - searchStart).count();
+    IterationStats iteration;
+    iteration.depth = rootDepth;
+    iteration.nodes = nodes - iterationStartNodes;
+    iteration.timeMs = lastResult.timeMs - iterationStartMs;
+    if (!stats.iterations.empty() && stats.iterations.back().nodes > 0)
+        iteration.branching = double(iteration.nodes) / double(stats.iterations.back().nodes);
+    stats.iterations.push_back(iteration);
+    iterationStartNodes = nodes;
+    iterationStartMs = lastResult.timeMs;
+    if (infoCallback) {
+        lastResult.stats = stats;
+        lastResult.stats.nodes = nodes;
+        lastResult.stats.timeMs = lastResult.timeMs;
+        infoCallback(lastResult);
+    }
+    if (!searchBest) return;
+    pollSearchState();
+    if (stopped) return;
+    // Infinite and ponder searches keep going until told otherwise.
+    if (!limits.infinite && !ponderActive) {
+        if (isMateScore(score)) return;
+        // Another iteration takes several times longer than this one; don't start it late.
+        if (limits.moveTimeMs > 0) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - budgetStart).count();
+            if (elapsed * 2 >= limits.moveTimeMs) return;
+        }
+    }
+    ++rootDepth;
+    rootStep = RootStep::START_ITERATION;
+}
+
+void Bot::finishSearch()
+{
+    lastResult.bestMove = searchBest;
+    lastResult.nodes = nodes;
+    lastResult.pawnHashProbes = pawnHash.getProbes();
+    lastResult.pawnHashHits = pawnHash.getHits();
+    lastResult.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - searchStart).count();
+    lastResult.stats = stats;
+    lastResult.stats.nodes = nodes;
+    lastResult.stats.timeMs = lastResult.timeMs;
+}
+
+void Bot::pushNode(int depth, int ply, int alpha, int beta, Color side, bool allowNull)
+{
+    Frame& f = frames[++top];
+    f.step = depth > 0 ? Frame::Step::ENTER : Frame::Step::Q_ENTER;
+    f.depth = depth;
+    f.ply = ply;
+    f.alpha = alpha;
+    f.beta = beta;
+    f.side = side;
+    f.allowNull = allowNull;
+}
+
+void Bot::leaveNode(int score)
+{
+    childScore = score;
+    --top;
+}
+
+// Negamax alpha-beta and quiescence, one resumable step at a time
+void Bot::stepNode(Frame& f)
+{
+    Board& b = searchBoard;
+    switch (f.step) {
+    case Frame::Step::ENTER: {
+        ++nodes;
+        pvLength[f.ply] = f.ply;
+        if (timeUp()) return leaveNode(0);
+        if (f.ply >= MAX_PLY - 1)
+            return leaveNode(staticEval(b, f.side));
+
+        f.pvNode = f.beta - f.alpha > 1;
+        f.key = b.getPositionKey(f.side);
+        f.hashMove = 0;
+        TTEntry entry;
+        ++stats.ttProbes;
+        if (tt->probe(f.key, entry)) {
+            ++stats.ttHits;
+            f.hashMove = entry.bestMove;
+            // PV nodes don't take hash cutoffs, so the principal variation stays complete.
+            if (!f.pvNode && entry.depth >= f.depth) {
+                int ttScore = scoreFromTT(entry.score, f.ply);
+                if (entry.bound == BoundType::EXACT ||
+                    (entry.bound == BoundType::LOWER && ttScore >= f.beta) ||
+                    (entry.bound == BoundType::UPPER && ttScore <= f.alpha)) {
+                    ++stats.ttCutoffs;
+                    return leaveNode(ttScore);
+                }
+            }
+        }
+
+        f.inCheck = b.isPlayerInCheck(f.side);
+        f.eval = staticEval(b, f.side);
+        bool mateBounds = isMateScore(f.alpha) || isMateScore(f.beta);
+
+        // Reverse futility: far enough above beta near the leaves, assume a quiet move holds it.
+        if (params.reverseFutility && !f.pvNode && !f.inCheck && !mateBounds &&
+            f.depth <= params.reverseFutilityMaxDepth &&
+            f.eval - params.reverseFutilityMargin * f.depth >= f.beta)
+            return leaveNode(f.eval);
+
+        // Null move: if passing still fails high at reduced depth, a real move will too.
+        if (params.nullMove && f.allowNull && !f.pvNode && !f.inCheck && !mateBounds &&
+            f.depth >= params.nullMoveMinDepth && f.eval >= f.beta && hasNonPawnMaterial(b, f.side)) {
+            f.reduction = params.nullMoveReduction + (f.depth >= 6 ? 1 : 0);
+            f.step = Frame::Step::AFTER_NULL;
+            pushNode(f.depth - 1 - f.reduction, f.ply + 1, -f.beta, -f.beta + 1, opposite(f.side), false);
+            return;
+        }
+        return startMoves(f);
+    }
+    case Frame::Step::AFTER_NULL: {
+        if (stopped) return leaveNode(0);
+        int nullScore = -childScore;
+        if (nullScore >= f.beta) {
+            if (isMateScore(nullScore)) nullScore = f.beta;
+            // Zugzwang guard: at higher depths confirm with a reduced search that may not pass again.
+            if (!params.nullMoveVerify || f.depth < params.nullMoveVerifyDepth)
+                return leaveNode(nullScore);
+            f.nullScore = nullScore;
+            f.step = Frame::Step::AFTER_VERIFY;
+            pushNode(f.depth - 1 - f.reduction, f.ply, f.beta - 1, f.beta, f.side, false);
+            return;
+        }
+        return startMoves(f);
+    }
+    case Frame::Step::AFTER_VERIFY:
+        if (stopped) return leaveNode(0);
+        if (childScore >= f.beta) return leaveNode(f.nullScore);
+        return startMoves(f);
+    case Frame::Step::NEXT_MOVE: {
+        PackedMove move;
+        while ((move = f.picker.nextMove()) != 0) {
+            bool quiet = isQuietMove(b, move);
+            bool killer = (move == killers[f.ply][0] || move == killers[f.ply][1]);
+            if (f.futile && quiet && f.legalMoves > 0)
+                continue;
+            makeSearchMove(b, move);
+            // Legality is only paid for moves that are actually searched.
+            if (b.isPlayerInCheck(f.side)) {
+                undoSearchMove(b);
+                continue;
+            }
+            ++f.legalMoves;
+            f.move = move;
+            f.quiet = quiet;
+
+            // Late move reductions: quiet moves ordered late are searched shallower first and
+            // only re-searched at full depth if they unexpectedly beat alpha.
+            f.reduction = 0;
+            if (params.lateMoveReductions && quiet && !killer && !f.inCheck && move != f.hashMove &&
+                f.depth >= params.lmrMinDepth && f.legalMoves > params.lmrMinMoves) {
+                f.reduction = reductions[std::min(f.depth, MAX_PLY - 1)][std::min(f.legalMoves, 63)];
+                f.reduction = std::min(f.reduction, f.depth - 2);
+            }
+            Color next = opposite(f.side);
+            if (f.legalMoves == 1) {
+                // PVS: the first move is expected to be best and gets the full window.
+                f.step = Frame::Step::AFTER_SEARCH;
+                pushNode(f.depth - 1, f.ply + 1, -f.beta, -f.alpha, next, true);
             }
             else {
-                if (v < best) best = v;
+                // The rest only need to be proven worse, which a zero window does cheaply.
+                f.step = Frame::Step::AFTER_REDUCED;
+                pushNode(f.depth - 1 - f.reduction, f.ply + 1, -f.alpha - 1, -f.alpha, next, true);
+            }
+            return;
+        }
+        return finishNode(f);
+    }
+    case Frame::Step::AFTER_REDUCED: {
+        int score = -childScore;
+        if (score > f.alpha && f.reduction > 0 && !stopped) {
+            f.step = Frame::Step::AFTER_ZERO_WINDOW;
+            pushNode(f.depth - 1, f.ply + 1, -f.alpha - 1, -f.alpha, opposite(f.side), true);
+            return;
+        }
+    }
+        // fall through
+    case Frame::Step::AFTER_ZERO_WINDOW: {
+        int score = -childScore;
+        // Fail high inside a PV node: re-search with the full window for an exact score.
+        if (score > f.alpha && score < f.beta && !stopped) {
+            f.step = Frame::Step::AFTER_SEARCH;
+            pushNode(f.depth - 1, f.ply + 1, -f.beta, -f.alpha, opposite(f.side), true);
+            return;
+        }
+        return afterMove(f, score);
+    }
+    case Frame::Step::AFTER_SEARCH:
+        return afterMove(f, -childScore);
+
+    case Frame::Step::Q_ENTER: {
+        // Captures-only search: stand pat on the static score or improve it by capturing
+        ++nodes;
+        ++stats.qnodes;
+        pvLength[f.ply] = f.ply;
+        if (timeUp()) return leaveNode(0);
+
+        int standPat = staticEval(b, f.side);
+        if (standPat >= f.beta || f.ply >= MAX_PLY - 1) return leaveNode(standPat);
+        if (standPat > f.alpha) f.alpha = standPat;
+        f.picker.resetCaptures(f.side, 0);
+        f.best = standPat;
+        f.step = Frame::Step::Q_NEXT;
+    }
+        // fall through
+    case Frame::Step::Q_NEXT: {
+        PackedMove move;
+        while ((move = f.picker.nextMove()) != 0) {
+            makeSearchMove(b, move);
+            if (b.isPlayerInCheck(f.side)) {
+                undoSearchMove(b);
+                continue;
+            }
+            f.step = Frame::Step::Q_AFTER_SEARCH;
+            pushNode(0, f.ply + 1, -f.beta, -f.alpha, opposite(f.side), false);
+            return;
+        }
+        return leaveNode(f.best);
+    }
+    case Frame::Step::Q_AFTER_SEARCH: {
+        int score = -childScore;
+        undoSearchMove(b);
+        if (stopped) return leaveNode(0);
+        if (score > f.best) {
+            f.best = score;
+            if (score > f.alpha) {
+                f.alpha = score;
+                if (f.alpha >= f.beta) return leaveNode(f.best);
+            }
+        }
+        f.step = Frame::Step::Q_NEXT;
+        return;
+    }
+    }
+}
+
+// Pruning decided; set up the move loop of a full-width node
+void Bot::startMoves(Frame& f)
+{
+    // Futility: near the leaves, quiet moves can't lift a hopeless static score above alpha.
+    bool mateBounds = isMateScore(f.alpha) || isMateScore(f.beta);
+    f.futile = params.futility && !f.pvNode && !f.inCheck && !mateBounds &&
+        f.depth <= params.futilityMaxDepth &&
+        f.eval + params.futilityMargin * f.depth <= f.alpha;
+
+    f.picker.reset(f.side, f.hashMove, killers[f.ply][0], killers[f.ply][1]);
+    f.alphaOrig = f.alpha;
+    f.best = -INF_SCORE;
+    f.bestMove = 0;
+    f.legalMoves = 0;
+    f.step = Frame::Step::NEXT_MOVE;
+}
+
+// A move's subtree is done: take back the move and update the node's best line
+void Bot::afterMove(Frame& f, int score)
+{
+    undoSearchMove(searchBoard);
+    if (stopped) return leaveNode(0);
+
+    f.step = Frame::Step::NEXT_MOVE;
+    if (score > f.best) {
+        f.best = score;
+        f.bestMove = f.move;
+        if (score > f.alpha) {
+            f.alpha = score;
+            if (f.ply == 0) rootBestMove = f.move;
+            // Triangular PV: this move followed by the child's line.
+            pvTable[f.ply][f.ply] = f.move;
+            for (int i = f.ply + 1; i < pvLength[f.ply + 1]; ++i)
+                pvTable[f.ply][i] = pvTable[f.ply + 1][i];
+            pvLength[f.ply] = std::max(pvLength[f.ply + 1], f.ply + 1);
+            if (f.alpha >= f.beta) {
+                ++stats.betaCutoffs;
+                if (f.legalMoves == 1) ++stats.firstMoveCutoffs;
+                if (f.quiet) updateKillers(f.ply, f.move);
+                return finishNode(f);
             }
         }
     }
-    return best;
 }
 
-// Simple material count heuristic
+// All moves tried (or a cutoff): store the result and return it
+void Bot::finishNode(Frame& f)
+{
+    if (f.legalMoves == 0) {
+        // no moves: side is mated or stalemated
+        return leaveNode(f.inCheck ? -MATE_SCORE + f.ply : 0);
+    }
+
+    BoundType bound = f.best >= f.beta ? BoundType::LOWER
+        : (f.best > f.alphaOrig ? BoundType::EXACT : BoundType::UPPER);
+    tt->store(f.key, f.depth, scoreToTT(f.best, f.ply), bound, f.bestMove);
+    leaveNode(f.best);
+}
+
+// Board make/undo for the search, keeping the NNUE accumulators in step
+void Bot::makeSearchMove(Board& b, PackedMove move)
+{
+    Piece* piece = b.getPieceAt(packedFromX(move), packedFromY(move));
+    if (nnue) nnue->push(b, move);
+    b.makeMoveForCheck(piece->getId(), packedToX(move), packedToY(move));
+}
+
+void Bot::undoSearchMove(Board& b)
+{
+    b.undoMoveForCheck();
+    if (nnue) nnue->pop();
+}
+
+// Static score for `side`: the network when one is loaded, else the hand-written terms
+int Bot::staticEval(Board& b, Color side)
+{
+    PROFILE_SCOPE(Phase::EVALUATION);
+    if (nnue) return nnue->evaluate(b, side);
+    int eval = evaluateBoard(b);
+    return side == getColor() ? eval : -eval;
+}
+
+// Static score of a position for its side to move, outside any search
+int Bot::evaluate(const Board& b)
+{
+    PROFILE_SCOPE(Phase::EVALUATION);
+    if (nnue) {
+        nnue->reset(b);
+        return nnue->evaluate(b, b.currentPlayerColor);
+    }
+    int eval = evaluateBoard(b);
+    return b.currentPlayerColor == getColor() ? eval : -eval;
+}
+
+bool Bot::timeUp()
+{
+    if (stopped) return true;
+    if (limits.maxNodes > 0 && nodes >= limits.maxNodes) {
+        stopped = true;
+        return true;
+    }
+    // 1024 nodes take well under a millisecond, so stop() is answered promptly.
+    if ((nodes & 1023) == 0) pollSearchState();
+    return stopped;
+}
+
+// Clock, stop request and ponder hit; also publishes the node count
+void Bot::pollSearchState()
+{
+    sharedNodes.store(nodes, std::memory_order_relaxed);
+    if (stopRequested.load(std::memory_order_relaxed)) stopped = true;
+    auto now = std::chrono::steady_clock::now();
+    if (ponderActive && !pondering) {
+        // The predicted move was played: from here on we're on our own clock.
+        ponderActive = false;
+        budgetStart = now;
+    }
+    if (!ponderActive && !limits.infinite && limits.moveTimeMs > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - budgetStart).count();
+        if (elapsed >= limits.moveTimeMs) stopped = true;
+    }
+}
+
+// Quiet moves that caused a cutoff are tried early at the same ply elsewhere in the tree
+void Bot::updateKillers(int ply, PackedMove move)
+{
+    if (killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+}
+
+// Material plus pawn structure; the pawn terms come from the pawn hash
 int Bot::evaluateBoard(const Board& b)
 {
+    // Centipawns; kings are never captured so they don't count.
     static const std::unordered_map<PieceType, int> values = {
-        {PieceType::PAWN,1},
-        {PieceType::KNIGHT,3},
-        {PieceType::BISHOP,3},
-        {PieceType::ROOK,5},
-        {PieceType::QUEEN,9},
-        {PieceType::KING,1000}
+        {PieceType::PAWN,100},
+        {PieceType::KNIGHT,320},
+        {PieceType::BISHOP,330},
+        {PieceType::ROOK,500},
+        {PieceType::QUEEN,900},
+        {PieceType::KING,0}
     };
+    const int PAWN_DEFENDED_MINOR = 10;
 
-    int score = 0;
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Piece* p = b.getPieceAt(x, y);
-            if (!p) continue;
-            int v = values.at(p->getType());
-            score += (p->getColor() == getColor() ? +v : -v);
+    const PawnEntry& pawns = pawnHash.probe(b);
+    int white = pawns.score;  // from White's point of view until the end
+    for (int c = 0; c < 2; ++c) {
+        const std::vector<Piece>& pieces = (c == 0) ? b.whitePieces : b.blackPieces;
+        int sign = (c == 0) ? 1 : -1;
+        int backRank = (c == 0) ? 7 : 0;
+        for (const Piece& p : pieces) {
+            if (!p.isAlive()) continue;
+            int score = values.at(p.getType());
+            std::uint64_t square = 1ULL << (p.getY() * 8 + p.getX());
+            if ((p.getType() == PieceType::KNIGHT || p.getType() == PieceType::BISHOP) &&
+                (pawns.attacks[c] & square))
+                score += PAWN_DEFENDED_MINOR;
+            // Pawn shelter only matters while the king is still at home.
+            if (p.getType() == PieceType::KING && std::abs(p.getY() - backRank) <= 1) {
+                int zone = p.getX() <= 2 ? 0 : (p.getX() <= 4 ? 1 : 2);
+                score += pawns.shield[c][zone];
+            }
+            white += sign * score;
         }
     }
-    return score;
+    return getColor() == Color::WHITE ? white : -white;
 }
 
 // Generate all legal moves for a given side (no leaving self in check)
 std::unordered_map<int, std::vector<std::pair<int, int>>>
 Bot::validMoves(const Board& b, Color side) const
 {
+    PROFILE_SCOPE(Phase::LEGALITY);
     std::unordered_map<int, std::vector<std::pair<int, int>>> out;
 
     for (int y = 0; y < 8; ++y) {
@@ -128,10 +899,7 @@ Bot::validMoves(const Board& b, Color side) const
             auto candidates = p->getAllValidMoves(b);
             std::vector<std::pair<int, int>> legals;
             for (size_t i = 0; i < candidates.size(); ++i) {
-                int nx = candidates[i].first, ny = candidates[i].second;
-                Board tmp = b;
-                if (!tmp.movePiece(p->getId(), nx, ny).first) continue;
-                if (!tmp.isPlayerInCheck(side))
+                if (!b.leavesKingInCheck(x, y, candidates[i].first, candidates[i].second))
                     legals.push_back(candidates[i]);
             }
             if (!legals.empty())
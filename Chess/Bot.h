@@ -5,28 +5,264 @@
 #include <utility>
 #include <unordered_map>
 #include <climits>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <thread>
 #include "Board.h"
 #include "Player.h"
+#include "TranspositionTable.h"
+#include "PawnHash.h"
+#include "Nnue.h"
+#include "MovePicker.h"
+#include "AllocTracker.h"
+
+/**
+ * @struct SearchLimits
+ * @brief Bounds on one Bot search: iterative deepening stops at whichever is hit first.
+ */
+struct SearchLimits {
+    int maxDepth = 32;      ///< Deepest iteration to search.
+    int moveTimeMs = 2000;  ///< Wall-clock budget per move in milliseconds (0 = unlimited).
+    long long maxNodes = 0; ///< Node budget of the main search thread (0 = unlimited).
+    bool infinite = false;  ///< Ignore the time budget; only stop() ends the search.
+    bool ponder = false;    ///< Start pondering: the time budget runs from ponderHit().
+};
+
+/**
+ * @struct SearchParams
+ * @brief Forward-pruning switches and tuning knobs (depths in plies, margins in centipawns).
+ */
+struct SearchParams {
+    bool nullMove = true;              ///< Null-move pruning.
+    int nullMoveMinDepth = 3;          ///< Shallowest depth to try a null move at.
+    int nullMoveReduction = 2;         ///< R: extra depth removed from the null-move search (+1 from depth 6).
+    bool nullMoveVerify = true;        ///< Re-check null-move cutoffs with a real search (zugzwang guard).
+    int nullMoveVerifyDepth = 6;       ///< Shallowest depth at which cutoffs are verified.
+
+    bool lateMoveReductions = true;    ///< Reduce late quiet moves.
+    int lmrMinDepth = 3;               ///< Shallowest depth to reduce at.
+    int lmrMinMoves = 3;               ///< Moves searched at full depth before reducing.
+    double lmrBase = 0.75;             ///< Reduction = base + ln(depth) * ln(moveNumber) / divisor.
+    double lmrDivisor = 2.25;
+
+    bool futility = true;              ///< Skip quiet moves that can't raise a low score to alpha.
+    int futilityMaxDepth = 2;
+    int futilityMargin = 150;          ///< Per ply of remaining depth.
+
+    bool reverseFutility = true;       ///< Cut nodes whose static score is far above beta.
+    int reverseFutilityMaxDepth = 3;
+    int reverseFutilityMargin = 120;   ///< Per ply of remaining depth.
+
+    bool aspiration = true;            ///< Root aspiration windows around the last iteration's score.
+    int aspirationMinDepth = 4;        ///< First iteration to use a narrow window.
+    int aspirationWindow = 50;         ///< Initial half-width; doubled on every fail high/low.
+};
+
+/**
+ * @struct IterationStats
+ * @brief One completed iteration of iterative deepening.
+ */
+struct IterationStats {
+    int depth = 0;
+    long long nodes = 0;               ///< Nodes of this iteration alone (main thread: helpers don't iterate in step).
+    long long timeMs = 0;              ///< Time of this iteration alone.
+    double branching = 0;              ///< Effective branching factor: nodes / previous iteration's nodes.
+};
+
+/**
+ * @struct SearchStats
+ * @brief Counters of one search. Each thread counts its own; think() adds the helpers' in.
+ */
+struct SearchStats {
+    long long nodes = 0;               ///< Full-width and quiescence nodes.
+    long long qnodes = 0;              ///< ...of which quiescence nodes.
+    long long ttProbes = 0;            ///< Transposition table lookups (full-width nodes).
+    long long ttHits = 0;              ///< ...that found an entry for the position.
+    long long ttCutoffs = 0;           ///< ...whose entry answered the node without a search.
+    long long betaCutoffs = 0;         ///< Full-width nodes that failed high on a move.
+    long long firstMoveCutoffs = 0;    ///< ...on their first legal move (move ordering quality).
+    long long timeMs = 0;
+    std::vector<IterationStats> iterations;  ///< Main thread's completed iterations.
+
+    long long nps() const;             ///< Nodes per second over the whole search.
+    double ttHitRate() const;          ///< Percent of probes that hit.
+    double firstMoveCutoffRate() const;  ///< Percent of beta cutoffs on the first move.
+    void merge(const SearchStats& other);  ///< Add another thread's counters (not its iterations).
+    std::string summary() const;       ///< The counters and per-iteration figures on one line.
+};
+
+/**
+ * @struct SearchResult
+ * @brief Outcome of the last completed iteration of a Bot search.
+ */
+struct SearchResult {
+    PackedMove bestMove = 0;
+    int score = 0;                     ///< Centipawns for the side to move, or +/-(MATE_SCORE - plies).
+    int depth = 0;                     ///< Deepest completed iteration.
+    std::vector<PackedMove> pv;        ///< Principal variation, starting with bestMove.
+    long long nodes = 0;
+    long long timeMs = 0;
+    long long pawnHashProbes = 0;      ///< Pawn-structure lookups made by the evaluation.
+    long long pawnHashHits = 0;        ///< ...of which were answered from the pawn hash.
+    SearchStats stats;                 ///< Complete once the search has finished.
+#ifdef CHESS_ALLOC_TRACKING
+    AllocTracker::Snapshot allocations;  ///< Heap allocations of all threads during think().
+#endif
+};
 
 /**
  * @class Bot
- * @brief Simple AI player using minimax-like evaluation.
+ * @brief AI player using an iterative-deepening alpha-beta search.
  */
 class Bot : public Player {
 public:
     Bot(Color color)
-        : Player(color, false) {
-    }      ///< Initialize as AI for given color.
+        : Bot(color, std::make_shared<TranspositionTable>()) {
+    }      ///< Initialize as AI for given color (with the default network, if one is loaded).
+    Bot(Color color, std::shared_ptr<TranspositionTable> table)
+        : Player(color, false), tt(std::move(table)) {
+        buildReductionTable();
+        setNetwork(NnueNetwork::getDefault());
+    }      ///< Same, searching with a hash table shared with other bots (no table of its own is allocated).
 
     bool makeMove(Board& board) override;  ///< Choose and execute best move.
-
-private:
-    int evaluateMove(Board& board, int depth, Color currentPlayer);
-    ///< Recursively score moves.
-    int evaluateBoard(const Board& board); ///< Heuristic board scoring.
+    PackedMove think(Board& board);        ///< Search without moving; 0 if no legal move.
+    bool playMove(Board& board, PackedMove move);  ///< Execute a move found by think() and report it.
+    void beginSearch(const Board& board);  ///< Set up a resumable search of a copy of `board`.
+    bool runSlice(long long nodeBudget);   ///< Search about nodeBudget more nodes (0 = to the end); true once finished.
+    bool isSearching() const;              ///< beginSearch() was called and the search hasn't finished.
+    int evaluate(const Board& board);      ///< Static score (no search) for the side to move, in centipawns.
+    int evaluateBoard(const Board& board); ///< Hand-written evaluation (material, pawn structure), for this bot's color.
     std::unordered_map<int, std::vector<std::pair<int, int>>>
         validMoves(const Board& board, Color color) const;
-    ///< Moves for specified color.
+    ///< Legal moves of `color`'s pieces, by piece id.
+
+    void setSearchLimits(const SearchLimits& limits);  ///< Depth/time bounds for makeMove.
+    const SearchLimits& getSearchLimits() const;
+    void setSearchParams(const SearchParams& params);  ///< Pruning switches and margins.
+    const SearchParams& getSearchParams() const;
+    long long getNodeCount() const;        ///< Nodes visited by the last search.
+    void stop();                           ///< Ask a running search to return soon (any thread).
+    void ponderHit();                      ///< The pondered move was played: start the clock (any thread).
+    void setInfoCallback(std::function<void(const SearchResult&)> callback);
+    ///< Called on the searching thread after every completed iteration.
+    void setThreads(int threads);          ///< Search threads (helpers share the hash table).
+    int getThreads() const;
+    void setHashSize(std::size_t sizeMb);  ///< Resize (and clear) the transposition table.
+    void setHashTable(std::shared_ptr<TranspositionTable> table);  ///< Search with a table shared with other bots.
+    const SearchResult& getLastResult() const;  ///< Score, depth and PV of the last search.
+    static std::string formatScore(int score);  ///< "+0.35" or "mate 3" style score text.
+    static void setStatsLogging(bool enabled);  ///< Print SearchStats::summary() with every move played.
+    static int allocateTime(long long remainingMs, long long incrementMs, int movesToGo = 0);
+    ///< Move time to spend from a clock (movesToGo 0 = sudden death).
+    void clearHash();                      ///< Empty the transposition table.
+    void setNetwork(std::shared_ptr<const NnueNetwork> network);  ///< NNUE evaluation (nullptr = hand-written).
+    std::shared_ptr<const NnueNetwork> getNetwork() const;
+
+    static const int MATE_SCORE = 100000;  ///< Score of being mated now (minus ply count).
+    static const int MAX_PLY = 64;         ///< Deepest ply the search tracks state for.
+
+private:
+    // One node of the explicit search stack: its arguments, its locals and the step to resume at.
+    struct Frame {
+        enum class Step : std::uint8_t {
+            ENTER, AFTER_NULL, AFTER_VERIFY, NEXT_MOVE, AFTER_REDUCED, AFTER_ZERO_WINDOW, AFTER_SEARCH,
+            Q_ENTER, Q_NEXT, Q_AFTER_SEARCH
+        };
+
+        MovePicker picker;
+        Step step{ Step::ENTER };
+        Color side{ Color::WHITE };
+        bool allowNull{ false };
+        bool pvNode{ false };
+        bool inCheck{ false };
+        bool futile{ false };
+        bool quiet{ false };
+        int depth{ 0 };
+        int ply{ 0 };
+        int alpha{ 0 };
+        int beta{ 0 };
+        int alphaOrig{ 0 };
+        int best{ 0 };
+        int eval{ 0 };
+        int legalMoves{ 0 };
+        int reduction{ 0 };                ///< Null-move R, later the LMR reduction of `move`.
+        int nullScore{ 0 };
+        std::uint64_t key{ 0 };
+        PackedMove hashMove{ 0 };
+        PackedMove bestMove{ 0 };
+        PackedMove move{ 0 };              ///< Move whose subtree is being searched.
+
+        explicit Frame(const Board& board) : picker(board) {}
+    };
+
+    enum class RootStep : std::uint8_t { START_ITERATION, IN_TREE, DONE };
+
+    void pushNode(int depth, int ply, int alpha, int beta, Color side, bool allowNull);
+    ///< Alpha-beta (or, at depth 0, quiescence) search of a child; score from `side`'s point of view.
+    void leaveNode(int score);             ///< Pop the top frame, handing its score to the parent.
+    void stepNode(Frame& frame);           ///< Run the top frame until it pushes a child or returns.
+    void startMoves(Frame& frame);
+    void afterMove(Frame& frame, int score);
+    void finishNode(Frame& frame);
+    void advanceRoot();                    ///< Iterative deepening and aspiration between tree searches.
+    void finishSearch();
+    int staticEval(Board& board, Color side);     ///< Active evaluator, from `side`'s point of view.
+    void makeSearchMove(Board& board, PackedMove move);
+    void undoSearchMove(Board& board);
+
+    bool timeUp();                         ///< Polls node budget, clock and stop requests.
+    void pollSearchState();
+    void updateKillers(int ply, PackedMove move);
+    void buildReductionTable();
+
+    // Resumable search state: everything a suspended search needs lives here, not on the C++ stack.
+    Board searchBoard;
+    std::vector<Frame> frames;             ///< Preallocated; the node at ply p uses at most two frames.
+    int top{ -1 };                         ///< Index of the frame being searched.
+    int childScore{ 0 };                   ///< Score the last popped frame returned.
+    RootStep rootStep{ RootStep::DONE };
+    int rootDepth{ 0 };
+    int rootAlpha{ 0 };
+    int rootBeta{ 0 };
+    int rootDelta{ 0 };
+    int prevScore{ 0 };
+    PackedMove searchBest{ 0 };            ///< Best move of the deepest completed iteration.
+    bool suspended{ false };
+    std::chrono::steady_clock::time_point suspendedAt;
+
+    SearchLimits limits;
+    SearchParams params;
+    int reductions[MAX_PLY][64];
+    std::shared_ptr<TranspositionTable> tt;
+    PawnHashTable pawnHash;
+    std::shared_ptr<const NnueNetwork> network;
+    std::unique_ptr<NnueEvaluator> nnue;
+    PackedMove killers[MAX_PLY][2] = {};
+    PackedMove rootBestMove{ 0 };
+    PackedMove pvTable[MAX_PLY][MAX_PLY] = {};  ///< Row ply holds the PV from that ply on.
+    int pvLength[MAX_PLY] = {};
+    SearchResult lastResult;
+    SearchStats stats;                     ///< This thread's counters; `nodes` is kept separately.
+    long long iterationStartNodes{ 0 };
+    long long iterationStartMs{ 0 };
+    std::int64_t iterationTraceStart{ 0 };  ///< Trace timestamp of the iteration's start (CHESS_TRACE builds).
+    long long nodes{ 0 };
+    bool stopped{ false };
+    bool ponderActive{ false };            ///< Search thread's view of `pondering`.
+    std::chrono::steady_clock::time_point searchStart;
+    std::chrono::steady_clock::time_point budgetStart;  ///< Time budget runs from here (ponder hit).
+    std::atomic<bool> stopRequested{ false };
+    std::atomic<bool> pondering{ false };
+    std::atomic<long long> sharedNodes{ 0 };   ///< `nodes`, published for other threads.
+    std::function<void(const SearchResult&)> infoCallback;
+
+    // Lazy SMP: helpers search the same root with their own heuristics, feeding the shared table.
+    std::vector<std::unique_ptr<Bot>> helpers;
+    int startDepth{ 1 };
 };
 
 #endif // BOT_H
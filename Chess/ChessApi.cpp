@@ -0,0 +1,294 @@
+/**
+ * @file ChessApi.cpp
+ * @brief The C interface of ChessApi.h on top of Board, move generation and Bot.
+ *
+ * Positions are loaded into a Board that is reused for every item (one per thread, or the
+ * engine's), so a batch costs no allocation beyond what the Board keeps between calls.
+ * Exceptions stop at this layer and become error codes.
+ */
+#include "ChessApi.h"
+#include "Board.h"
+#include "Bot.h"
+#include <mutex>
+#include <new>
+#include <cstring>
+#include <algorithm>
+
+struct ChessEngine {
+    std::mutex mutex;
+    Bot bot{ Color::WHITE };
+    Board board;
+};
+
+namespace {
+    struct Scratch {
+        Board board;
+        std::vector<std::pair<int, int>> targets;
+
+        Scratch() { targets.reserve(32); }
+    };
+
+    Scratch& scratch() {
+        thread_local Scratch s;
+        return s;
+    }
+
+    int loadPosition(Board& board, const ChessPosition& position) {
+        if (position.blackToMove > 1) return CHESS_ERROR_INVALID_POSITION;
+        try {
+            board.loadFromSquares(position.squares, position.blackToMove ? Color::BLACK : Color::WHITE);
+        }
+        catch (const std::exception&) {
+            return CHESS_ERROR_INVALID_POSITION;
+        }
+        return CHESS_OK;
+    }
+
+    void storePosition(const Board& board, ChessPosition& position) {
+        std::memset(&position, 0, sizeof(position));
+        for (const std::vector<Piece>* pieces : { &board.whitePieces, &board.blackPieces }) {
+            for (const Piece& p : *pieces) {
+                if (!p.isAlive()) continue;
+                position.squares[p.getY() * 8 + p.getX()] = static_cast<std::uint8_t>(
+                    static_cast<int>(p.getType()) + 1 + (p.getColor() == Color::BLACK ? 8 : 0));
+            }
+        }
+        position.blackToMove = board.currentPlayerColor == Color::BLACK ? 1 : 0;
+    }
+
+    // Legal moves of the side to move; counts past `capacity` but stores only that many.
+    std::uint32_t collectLegalMoves(const Board& board, std::vector<std::pair<int, int>>& targets,
+        ChessMove* moves, std::size_t capacity) {
+        Color side = board.currentPlayerColor;
+        const std::vector<Piece>& pieces = side == Color::WHITE ? board.whitePieces : board.blackPieces;
+        std::uint32_t count = 0;
+        for (std::size_t i = 0; i < pieces.size(); ++i) {
+            if (!pieces[i].isAlive()) continue;
+            int fx = pieces[i].getX(), fy = pieces[i].getY();
+            targets.clear();
+            pieces[i].generateMoves(board, MoveGenType::ALL, targets);
+            for (const auto& t : targets) {
+                if (board.leavesKingInCheck(fx, fy, t.first, t.second)) continue;
+                if (count < capacity) moves[count] = packMove(fx, fy, t.first, t.second);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // Play a move on the board if it is legal for the side to move.
+    int playMove(Board& board, std::vector<std::pair<int, int>>& targets, ChessMove move) {
+        Color side = board.currentPlayerColor;
+        int tx = packedToX(move), ty = packedToY(move);
+        Piece* piece = move ? board.getPieceAt(packedFromX(move), packedFromY(move)) : nullptr;
+        if (!piece || piece->getColor() != side || (move >> 12) != 0) return CHESS_ERROR_ILLEGAL_MOVE;
+        targets.clear();
+        piece->generateMoves(board, MoveGenType::ALL, targets);
+        if (std::find(targets.begin(), targets.end(), std::make_pair(tx, ty)) == targets.end()) {
+            return CHESS_ERROR_ILLEGAL_MOVE;
+        }
+        if (board.leavesKingInCheck(packedFromX(move), packedFromY(move), tx, ty)) return CHESS_ERROR_ILLEGAL_MOVE;
+        board.makeMoveForCheck(piece->getId(), tx, ty);
+        board.currentPlayerColor = side == Color::WHITE ? Color::BLACK : Color::WHITE;
+        return CHESS_OK;
+    }
+
+    // Record one item's outcome and keep the first failure as the batch result.
+    void report(int code, std::size_t i, int32_t* status, int& result) {
+        if (status) status[i] = code;
+        if (code != CHESS_OK && result == CHESS_OK) result = code;
+    }
+}
+
+extern "C" {
+
+int chess_api_version(void) {
+    return CHESS_API_VERSION;
+}
+
+const char* chess_error_string(int code) {
+    switch (code) {
+    case CHESS_OK: return "ok";
+    case CHESS_ERROR_INVALID_ARGUMENT: return "invalid argument";
+    case CHESS_ERROR_INVALID_POSITION: return "invalid position";
+    case CHESS_ERROR_ILLEGAL_MOVE: return "illegal move";
+    case CHESS_ERROR_BUFFER_TOO_SMALL: return "buffer too small";
+    case CHESS_ERROR_INTERNAL: return "internal error";
+    default: return "unknown error";
+    }
+}
+
+int chess_position_from_fen(const char* fen, ChessPosition* position) {
+    if (!fen || !position) return CHESS_ERROR_INVALID_ARGUMENT;
+    try {
+        Board& board = scratch().board;
+        board.loadFromFen(fen);
+        storePosition(board, *position);
+    }
+    catch (const std::exception&) {
+        return CHESS_ERROR_INVALID_POSITION;
+    }
+    return CHESS_OK;
+}
+
+int chess_position_to_fen(const ChessPosition* position, char* buffer, size_t size) {
+    if (!position || !buffer) return CHESS_ERROR_INVALID_ARGUMENT;
+    Board& board = scratch().board;
+    int code = loadPosition(board, *position);
+    if (code != CHESS_OK) return code;
+    try {
+        std::string fen = board.toFen();
+        if (fen.size() + 1 > size) return CHESS_ERROR_BUFFER_TOO_SMALL;
+        std::memcpy(buffer, fen.c_str(), fen.size() + 1);
+    }
+    catch (const std::exception&) {
+        return CHESS_ERROR_INTERNAL;
+    }
+    return CHESS_OK;
+}
+
+int chess_move_to_string(ChessMove move, char buffer[5]) {
+    if (!buffer || !move) return CHESS_ERROR_INVALID_ARGUMENT;
+    std::string text = packedMoveToString(move);
+    std::memcpy(buffer, text.data(), 4);
+    buffer[4] = '\0';
+    return CHESS_OK;
+}
+
+int chess_legal_moves_batch(const ChessPosition* positions, size_t count, ChessMove* moves, size_t stride,
+    uint32_t* moveCounts, int32_t* status) {
+    if ((!positions || !moveCounts || (!moves && stride > 0)) && count > 0) return CHESS_ERROR_INVALID_ARGUMENT;
+    Scratch& s = scratch();
+    int result = CHESS_OK;
+    for (size_t i = 0; i < count; ++i) {
+        int code = loadPosition(s.board, positions[i]);
+        moveCounts[i] = 0;
+        if (code == CHESS_OK) {
+            moveCounts[i] = collectLegalMoves(s.board, s.targets, moves + i * stride, stride);
+            if (moveCounts[i] > stride) code = CHESS_ERROR_BUFFER_TOO_SMALL;
+        }
+        report(code, i, status, result);
+    }
+    return result;
+}
+
+int chess_apply_moves_batch(ChessPosition* positions, const ChessMove* moves, size_t count,
+    uint64_t* hashes, int32_t* status) {
+    if ((!positions || !moves) && count > 0) return CHESS_ERROR_INVALID_ARGUMENT;
+    Scratch& s = scratch();
+    int result = CHESS_OK;
+    for (size_t i = 0; i < count; ++i) {
+        int code = loadPosition(s.board, positions[i]);
+        if (code == CHESS_OK) code = playMove(s.board, s.targets, moves[i]);
+        if (code == CHESS_OK) storePosition(s.board, positions[i]);
+        if (hashes) hashes[i] = code == CHESS_OK ? s.board.getPositionKey(s.board.currentPlayerColor) : 0;
+        report(code, i, status, result);
+    }
+    return result;
+}
+
+int chess_play_moves(ChessPosition* position, const ChessMove* moves, size_t count, uint64_t* hashes) {
+    if (!position || (!moves && count > 0)) return CHESS_ERROR_INVALID_ARGUMENT;
+    Scratch& s = scratch();
+    int code = loadPosition(s.board, *position);
+    if (code != CHESS_OK) return code;
+    for (size_t i = 0; i < count && code == CHESS_OK; ++i) {
+        code = playMove(s.board, s.targets, moves[i]);
+        if (code != CHESS_OK) {
+            // The rejected move was never made, so the board holds the position before it.
+            break;
+        }
+        if (hashes) hashes[i] = s.board.getPositionKey(s.board.currentPlayerColor);
+    }
+    storePosition(s.board, *position);
+    return code;
+}
+
+int chess_hash_batch(const ChessPosition* positions, size_t count, uint64_t* hashes, int32_t* status) {
+    if ((!positions || !hashes) && count > 0) return CHESS_ERROR_INVALID_ARGUMENT;
+    Board& board = scratch().board;
+    int result = CHESS_OK;
+    for (size_t i = 0; i < count; ++i) {
+        int code = loadPosition(board, positions[i]);
+        hashes[i] = code == CHESS_OK ? board.getPositionKey(board.currentPlayerColor) : 0;
+        report(code, i, status, result);
+    }
+    return result;
+}
+
+ChessEngine* chess_engine_create(size_t hashMb) {
+    try {
+        ChessEngine* engine = new ChessEngine();
+        if (hashMb > 0) engine->bot.setHashSize(hashMb);
+        return engine;
+    }
+    catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void chess_engine_destroy(ChessEngine* engine) {
+    delete engine;
+}
+
+int chess_engine_clear_hash(ChessEngine* engine) {
+    if (!engine) return CHESS_ERROR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    engine->bot.clearHash();
+    return CHESS_OK;
+}
+
+int chess_engine_stop(ChessEngine* engine) {
+    if (!engine) return CHESS_ERROR_INVALID_ARGUMENT;
+    engine->bot.stop();
+    return CHESS_OK;
+}
+
+int chess_evaluate_batch(ChessEngine* engine, const ChessPosition* positions, size_t count,
+    int32_t* scores, int32_t* status) {
+    if (!engine || ((!positions || !scores) && count > 0)) return CHESS_ERROR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    int result = CHESS_OK;
+    for (size_t i = 0; i < count; ++i) {
+        int code = loadPosition(engine->board, positions[i]);
+        scores[i] = code == CHESS_OK ? engine->bot.evaluate(engine->board) : 0;
+        report(code, i, status, result);
+    }
+    return result;
+}
+
+int chess_search_batch(ChessEngine* engine, const ChessPosition* positions, size_t count,
+    const ChessSearchLimits* limits, ChessSearchResult* results, int32_t* status) {
+    if (!engine || !limits || ((!positions || !results) && count > 0)) return CHESS_ERROR_INVALID_ARGUMENT;
+    if (limits->depth <= 0 && limits->moveTimeMs <= 0 && limits->nodes <= 0) return CHESS_ERROR_INVALID_ARGUMENT;
+    SearchLimits searchLimits;
+    searchLimits.maxDepth = limits->depth > 0 ? std::min<int>(limits->depth, Bot::MAX_PLY - 1) : Bot::MAX_PLY - 1;
+    searchLimits.moveTimeMs = std::max<int>(limits->moveTimeMs, 0);
+    searchLimits.maxNodes = std::max<int64_t>(limits->nodes, 0);
+
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    int result = CHESS_OK;
+    for (size_t i = 0; i < count; ++i) {
+        std::memset(&results[i], 0, sizeof(results[i]));
+        int code = loadPosition(engine->board, positions[i]);
+        if (code == CHESS_OK) {
+            try {
+                engine->bot.setColor(engine->board.currentPlayerColor);
+                engine->bot.setSearchLimits(searchLimits);
+                results[i].bestMove = engine->bot.think(engine->board);
+                const SearchResult& r = engine->bot.getLastResult();
+                results[i].score = r.score;
+                results[i].depth = r.depth;
+                results[i].nodes = r.nodes;
+                results[i].timeMs = r.timeMs;
+            }
+            catch (const std::exception&) {
+                code = CHESS_ERROR_INTERNAL;
+            }
+        }
+        report(code, i, status, result);
+    }
+    return result;
+}
+
+}
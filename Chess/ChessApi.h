@@ -0,0 +1,139 @@
+#ifndef CHESS_API_H
+#define CHESS_API_H
+
+/**
+ * @file ChessApi.h
+ * @brief Stable C interface to the engine, for programs that link the ChessLib library.
+ *
+ * Positions, moves and results are plain structs in arrays the caller owns; no call
+ * allocates memory the caller has to free, and the batch calls take N items at once so a
+ * service pays the call overhead once per batch rather than once per position.
+ *
+ * Thread safety: calls that take no ChessEngine may run on any number of threads at once
+ * (each thread works on its own scratch board). Calls on one ChessEngine are serialised;
+ * create one engine per thread to evaluate or search in parallel. chess_engine_stop() may
+ * be called from any thread. Nothing here throws: failures are CHESS_ERROR_* codes.
+ *
+ * The rules are this engine's: no castling or en passant, and promotions are always to a
+ * queen.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHESS_API_VERSION 1
+#define CHESS_MAX_MOVES 256          /**< More than the legal moves of any position. */
+#define CHESS_MATE_SCORE 100000      /**< Scores within CHESS_MAX_PLY of +-this are mates. */
+#define CHESS_MAX_PLY 64
+#define CHESS_FEN_BUFFER 96          /**< Enough for any FEN chess_position_to_fen() writes. */
+
+enum {
+    CHESS_OK = 0,
+    CHESS_ERROR_INVALID_ARGUMENT = -1,
+    CHESS_ERROR_INVALID_POSITION = -2,
+    CHESS_ERROR_ILLEGAL_MOVE = -3,
+    CHESS_ERROR_BUFFER_TOO_SMALL = -4,
+    CHESS_ERROR_INTERNAL = -5
+};
+
+/** Codes of ChessPosition::squares: bit 3 set for Black, low bits the piece type plus one. */
+enum {
+    CHESS_EMPTY = 0,
+    CHESS_WHITE_PAWN = 1, CHESS_WHITE_KNIGHT, CHESS_WHITE_BISHOP, CHESS_WHITE_ROOK, CHESS_WHITE_QUEEN, CHESS_WHITE_KING,
+    CHESS_BLACK_PAWN = 9, CHESS_BLACK_KNIGHT, CHESS_BLACK_BISHOP, CHESS_BLACK_ROOK, CHESS_BLACK_QUEEN, CHESS_BLACK_KING
+};
+
+/** A position: squares from a8 (0), b8, ... to h1 (63), and the side to move. */
+typedef struct ChessPosition {
+    uint8_t squares[64];
+    uint8_t blackToMove;             /**< 0 = White to move, 1 = Black. */
+    uint8_t reserved[7];             /**< Set to zero. */
+} ChessPosition;
+
+/** from | to << 6, squares numbered as in ChessPosition; 0 = no move. */
+typedef uint16_t ChessMove;
+
+/** Bounds of one search; at least one must be set. */
+typedef struct ChessSearchLimits {
+    int32_t depth;                   /**< Deepest iteration (0 = up to CHESS_MAX_PLY - 1). */
+    int32_t moveTimeMs;              /**< 0 = no time limit. */
+    int64_t nodes;                   /**< 0 = no node limit. */
+} ChessSearchLimits;
+
+typedef struct ChessSearchResult {
+    ChessMove bestMove;              /**< 0 if the side to move has no legal move. */
+    uint16_t reserved;
+    int32_t score;                   /**< Centipawns for the side to move. */
+    int32_t depth;                   /**< Deepest completed iteration. */
+    int32_t reserved2;
+    int64_t nodes;
+    int64_t timeMs;
+} ChessSearchResult;
+
+/** Owns a search (transposition table, evaluation caches); see the thread-safety note. */
+typedef struct ChessEngine ChessEngine;
+
+int chess_api_version(void);                 /**< CHESS_API_VERSION of the library. */
+const char* chess_error_string(int code);    /**< Static text for a CHESS_* code. */
+
+int chess_position_from_fen(const char* fen, ChessPosition* position);
+int chess_position_to_fen(const ChessPosition* position, char* buffer, size_t size);
+int chess_move_to_string(ChessMove move, char buffer[5]);   /**< "e2e4", not terminated. */
+
+/*
+ * Batch calls. `status` may be NULL; otherwise status[i] receives the outcome of item i.
+ * The return value is CHESS_OK if every item succeeded, else the code of the first failure.
+ */
+
+/**
+ * Legal moves of positions[i] go to moves[i * stride] onwards and their number to
+ * moveCounts[i]. A count above `stride` means the moves did not fit (only `stride` were
+ * stored, CHESS_ERROR_BUFFER_TOO_SMALL); a stride of CHESS_MAX_MOVES always suffices.
+ */
+int chess_legal_moves_batch(const ChessPosition* positions, size_t count, ChessMove* moves, size_t stride,
+    uint32_t* moveCounts, int32_t* status);
+
+/**
+ * Play moves[i] in positions[i], in place, and store the Zobrist key of the new position
+ * (side to move included) in hashes[i] (may be NULL). An illegal move leaves its position
+ * unchanged and its hash 0.
+ */
+int chess_apply_moves_batch(ChessPosition* positions, const ChessMove* moves, size_t count,
+    uint64_t* hashes, int32_t* status);
+
+/**
+ * Play a game's moves one after another from `position` (updated in place), storing the
+ * key after each move in hashes[i] (may be NULL). Stops at the first illegal move, leaving
+ * the position before it, and returns CHESS_ERROR_ILLEGAL_MOVE.
+ */
+int chess_play_moves(ChessPosition* position, const ChessMove* moves, size_t count, uint64_t* hashes);
+
+/** Zobrist key of each position, side to move included, as the search's hash table uses it. */
+int chess_hash_batch(const ChessPosition* positions, size_t count, uint64_t* hashes, int32_t* status);
+
+/** NULL if the table cannot be allocated. hashMb 0 uses the engine default. */
+ChessEngine* chess_engine_create(size_t hashMb);
+void chess_engine_destroy(ChessEngine* engine);
+int chess_engine_clear_hash(ChessEngine* engine);
+int chess_engine_stop(ChessEngine* engine);  /**< End the search in progress early (any thread). */
+
+/** Static evaluation (no search) of each position, centipawns for its side to move. */
+int chess_evaluate_batch(ChessEngine* engine, const ChessPosition* positions, size_t count,
+    int32_t* scores, int32_t* status);
+
+/**
+ * Search each position under the same limits. The hash table is kept between positions;
+ * call chess_engine_clear_hash() first for results that do not depend on earlier searches.
+ */
+int chess_search_batch(ChessEngine* engine, const ChessPosition* positions, size_t count,
+    const ChessSearchLimits* limits, ChessSearchResult* results, int32_t* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHESS_API_H */
@@ -0,0 +1,780 @@
+/**
+ * @file Distributed.cpp
+ * @brief Coordinator and worker processes for jobs too large for one machine.
+ *
+ * The coordinator cuts a job into units up front, keeps every unit's text, and hands units
+ * out over one socket per worker from a single poll loop. A unit stays assigned to its
+ * worker until a verified result arrives; everything a lost worker held is re-queued, so the
+ * job finishes as long as some worker is left. Results are kept per unit and only combined
+ * at the end, which makes the outcome independent of which worker did what.
+ */
+#include "Distributed.h"
+#include "Board.h"
+#include "Bot.h"
+#include "Epd.h"
+#include "Match.h"
+#include "Notation.h"
+#include "Socket.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    const int heartbeatMs = 1000;
+    const int maxAttempts = 3;
+
+#ifdef _WIN32
+    typedef HANDLE ProcessHandle;
+#else
+    typedef pid_t ProcessHandle;
+#endif
+
+    struct CoordinatorOptions {
+        std::string bind = "127.0.0.1";
+        int port = 7880;
+        int spawn = 0;
+        int timeoutMs = 10000;
+        int prefetch = 2;
+        int split = 2;
+        int batch = 10;
+        std::string outFile;
+        int crashAfter = 0;
+        int corruptEvery = 0;
+    };
+
+    struct WorkerOptions {
+        std::string host = "127.0.0.1";
+        int port = 7880;
+        std::string name;
+        std::size_t hashMb = 16;
+        int retrySeconds = 10;
+        int crashAfter = 0;
+        int corruptEvery = 0;
+    };
+
+    struct Unit {
+        std::string text;       ///< "KIND<TAB>FIELD..." as sent after "unit ID ".
+        std::string label;      ///< perft: the root move the unit belongs to.
+        std::string payload;    ///< The verified result.
+        std::string lastError;
+        int attempts = 0;
+        bool done = false;
+    };
+
+    struct RemoteWorker {
+        SocketHandle socket;
+        LineReader reader;
+        std::string name;
+        std::vector<std::size_t> assigned;
+        Clock::time_point lastHeard;
+        int completed = 0;
+
+        explicit RemoteWorker(SocketHandle s) : socket(s), reader(s), lastHeard(Clock::now()) {}
+    };
+
+    std::string checksum(const std::string& id, const std::string& payload) {
+        std::uint64_t hash = 14695981039346656037ULL;
+        std::string text = id + " " + payload;
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return out.str();
+    }
+
+    std::vector<std::string> splitFields(const std::string& text) {
+        std::vector<std::string> fields;
+        std::istringstream in(text);
+        std::string field;
+        while (std::getline(in, field, '\t')) {
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    // Fields are tab separated, so tabs inside them become spaces.
+    void addField(std::string& text, const std::string& field) {
+        if (!text.empty()) text += '\t';
+        std::string clean = field;
+        std::replace(clean.begin(), clean.end(), '\t', ' ');
+        text += clean;
+    }
+
+    std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+    }
+
+    std::string executablePath() {
+#ifdef _WIN32
+        char path[MAX_PATH];
+        DWORD n = GetModuleFileNameA(nullptr, path, MAX_PATH);
+        return std::string(path, n);
+#else
+        return "/proc/self/exe";
+#endif
+    }
+
+    std::string defaultWorkerName() {
+#ifdef _WIN32
+        char host[MAX_COMPUTERNAME_LENGTH + 1];
+        DWORD size = sizeof(host);
+        std::string name = GetComputerNameA(host, &size) ? std::string(host, size) : "worker";
+        return name + ":" + std::to_string(GetCurrentProcessId());
+#else
+        char host[256] = {};
+        std::string name = gethostname(host, sizeof(host) - 1) == 0 ? std::string(host) : "worker";
+        return name + ":" + std::to_string(getpid());
+#endif
+    }
+
+    // Start this executable with `args` (the mode first).
+    bool spawnProcess(const std::vector<std::string>& args, ProcessHandle& process) {
+        std::string exe = executablePath();
+#ifdef _WIN32
+        std::string commandLine = "\"" + exe + "\"";
+        for (const std::string& a : args) commandLine += " \"" + a + "\"";
+        STARTUPINFOA startup;
+        PROCESS_INFORMATION info;
+        ZeroMemory(&startup, sizeof(startup));
+        startup.cb = sizeof(startup);
+        if (!CreateProcessA(exe.c_str(), &commandLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info)) {
+            return false;
+        }
+        CloseHandle(info.hThread);
+        process = info.hProcess;
+        return true;
+#else
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(exe.c_str()));
+        for (const std::string& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        pid_t pid = fork();
+        if (pid < 0) return false;
+        if (pid == 0) {
+            execv(exe.c_str(), argv.data());
+            _exit(127);
+        }
+        process = pid;
+        return true;
+#endif
+    }
+
+    bool processRunning(ProcessHandle process) {
+#ifdef _WIN32
+        return WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+#else
+        int status;
+        return waitpid(process, &status, WNOHANG) == 0;
+#endif
+    }
+
+    void waitProcess(ProcessHandle process) {
+#ifdef _WIN32
+        WaitForSingleObject(process, INFINITE);
+        CloseHandle(process);
+#else
+        int status;
+        waitpid(process, &status, 0);
+#endif
+    }
+
+    // Units of each job kind, built by the coordinator.
+    bool perftUnits(const std::vector<std::string>& job, int split, std::vector<Unit>& units,
+        std::vector<std::string>& rootMoves, int& depth, std::string& error) {
+        if (job.size() < 2 || (depth = std::atoi(job[1].c_str())) < 1) {
+            error = "perft needs a depth of at least 1";
+            return false;
+        }
+        Board root;
+        if (job.size() > 2) {
+            std::string fen;
+            for (size_t i = 2; i < job.size(); ++i) fen += (i > 2 ? " " : "") + job[i];
+            try {
+                root.loadFromFen(fen);
+            }
+            catch (const std::exception& e) {
+                error = e.what();
+                return false;
+            }
+        }
+        split = std::max(0, std::min(split, depth - 1));
+        // Breadth-first expansion to `split` plies, each position remembering its root move.
+        std::vector<std::pair<Board, std::string>> frontier(1, std::make_pair(root, std::string()));
+        for (int ply = 0; ply < split; ++ply) {
+            std::vector<std::pair<Board, std::string>> next;
+            for (const auto& node : frontier) {
+                for (PackedMove move : generateLegalMoves(node.first, node.first.currentPlayerColor)) {
+                    Board child = node.first;
+                    Piece* piece = child.getPieceAt(packedFromX(move), packedFromY(move));
+                    child.applyMove(piece->getId(), packedToX(move), packedToY(move));
+                    std::string label = ply == 0 ? packedMoveToString(move) : node.second;
+                    if (ply == 0) rootMoves.push_back(label);
+                    next.push_back(std::make_pair(child, label));
+                }
+            }
+            frontier.swap(next);
+        }
+        for (const auto& node : frontier) {
+            Unit unit;
+            addField(unit.text, "perft");
+            addField(unit.text, std::to_string(depth - split));
+            addField(unit.text, node.first.toFen());
+            unit.label = node.second;
+            units.push_back(unit);
+        }
+        return true;
+    }
+
+    bool epdUnits(const std::vector<std::string>& job, int batch, std::vector<Unit>& units, std::string& error) {
+        if (job.size() < 2) {
+            error = "epd needs an input file";
+            return false;
+        }
+        std::string limit = "depth", amount = "8";
+        for (size_t i = 2; i < job.size(); i += 2) {
+            if (i + 1 >= job.size()) {
+                error = "missing value for " + job[i];
+                return false;
+            }
+            if (job[i] == "--depth" || job[i] == "--nodes" || job[i] == "--movetime") {
+                limit = job[i].substr(2);
+                amount = job[i + 1];
+            }
+            else {
+                error = "unknown epd option " + job[i];
+                return false;
+            }
+        }
+        std::ifstream in(job[1]);
+        if (!in) {
+            error = "cannot open " + job[1];
+            return false;
+        }
+        std::string line;
+        int lineNumber = 0, inUnit = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            line = trim(line);
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream fields(line);
+            std::string field;
+            int count = 0;
+            while (count < 4 && fields >> field) ++count;
+            if (count < 4) {
+                std::cerr << "coordinator: line " << lineNumber << " is not an EPD record" << std::endl;
+                continue;
+            }
+            if (inUnit == 0) {
+                units.push_back(Unit());
+                addField(units.back().text, "epd");
+                addField(units.back().text, limit);
+                addField(units.back().text, amount);
+            }
+            addField(units.back().text, std::to_string(lineNumber));
+            addField(units.back().text, line);
+            inUnit = (inUnit + 1) % batch;
+        }
+        return true;
+    }
+
+    bool selfPlayUnits(const std::vector<std::string>& job, int batch, std::vector<Unit>& units, std::string& error) {
+        int games = 1000;
+        for (size_t i = 1; i + 1 < job.size(); ++i) {
+            if (job[i] == "--games") games = std::atoi(job[i + 1].c_str());
+        }
+        if (games < 1) {
+            error = "selfplay needs at least one game";
+            return false;
+        }
+        for (int first = 0; first < games; first += batch) {
+            Unit unit;
+            addField(unit.text, "selfplay");
+            addField(unit.text, std::to_string(first));
+            addField(unit.text, std::to_string(std::min(batch, games - first)));
+            for (size_t i = 1; i < job.size(); ++i) addField(unit.text, job[i]);
+            units.push_back(unit);
+        }
+        return true;
+    }
+
+    // Worker side: run one unit and produce its payload.
+    bool runUnit(const std::vector<std::string>& fields, std::unique_ptr<Bot>& bot, const WorkerOptions& o,
+        std::string& payload, std::string& error) {
+        const std::string kind = fields.empty() ? "" : fields[0];
+        if (kind == "perft" && fields.size() == 3) {
+            Board board;
+            board.loadFromFen(fields[2]);
+            payload = std::to_string(perft(board, std::atoi(fields[1].c_str())));
+            return true;
+        }
+        if (kind == "epd" && fields.size() >= 3 && fields.size() % 2 == 1) {
+            SearchLimits limits;
+            limits.moveTimeMs = 0;
+            long long amount = std::atoll(fields[2].c_str());
+            if (fields[1] == "depth") limits.maxDepth = int(amount);
+            else if (fields[1] == "nodes") { limits.maxNodes = amount; limits.maxDepth = Bot::MAX_PLY - 1; }
+            else { limits.moveTimeMs = int(amount); limits.maxDepth = Bot::MAX_PLY - 1; }
+            if (!bot) {
+                bot.reset(new Bot(Color::WHITE));
+                bot->setHashSize(o.hashMb);
+            }
+            payload.clear();
+            for (size_t i = 3; i + 1 < fields.size(); i += 2) {
+                EpdResult result;
+                analyseEpdRecord(*bot, std::atoi(fields[i].c_str()), fields[i + 1], limits, result);
+                addField(payload, result.tested ? "1" : "0");
+                addField(payload, result.solved ? "1" : "0");
+                addField(payload, std::to_string(result.nodes));
+                addField(payload, result.text);
+            }
+            return true;
+        }
+        if (kind == "selfplay" && fields.size() >= 3) {
+            std::vector<std::string> args(fields.begin() + 3, fields.end());
+            int wins = 0, draws = 0, losses = 0;
+            if (!playMatchGames(args, std::atoi(fields[1].c_str()), std::atoi(fields[2].c_str()),
+                wins, draws, losses, error)) {
+                return false;
+            }
+            payload = std::to_string(wins) + "\t" + std::to_string(draws) + "\t" + std::to_string(losses);
+            return true;
+        }
+        error = "malformed unit";
+        return false;
+    }
+
+    bool isNumber(const std::string& s) {
+        return !s.empty() && s.find_first_not_of("0123456789") == std::string::npos;
+    }
+
+    // A payload the coordinator can combine, checked before the unit counts as done.
+    bool validPayload(const std::string& kind, const std::string& payload) {
+        std::vector<std::string> f = splitFields(payload);
+        if (kind == "perft") return f.size() == 1 && isNumber(f[0]);
+        if (kind == "selfplay") return f.size() == 3 && isNumber(f[0]) && isNumber(f[1]) && isNumber(f[2]);
+        return f.size() % 4 == 0;
+    }
+}
+
+int runCoordinator(const std::vector<std::string>& args) {
+    CoordinatorOptions o;
+    size_t i = 0;
+    for (; i < args.size() && args[i].compare(0, 2, "--") == 0; i += 2) {
+        const std::string& a = args[i];
+        if (i + 1 >= args.size()) {
+            std::cerr << "coordinator: missing value for " << a << std::endl;
+            return 1;
+        }
+        const std::string& v = args[i + 1];
+        int n = std::atoi(v.c_str());
+        if (a == "--bind") o.bind = v;
+        else if (a == "--port") o.port = n;
+        else if (a == "--spawn") o.spawn = std::max(0, n);
+        else if (a == "--timeout") o.timeoutMs = std::max(heartbeatMs * 2, n);
+        else if (a == "--prefetch") o.prefetch = std::max(1, n);
+        else if (a == "--split") o.split = std::max(0, n);
+        else if (a == "--batch") o.batch = std::max(1, n);
+        else if (a == "--out") o.outFile = v;
+        else if (a == "--crash-after") o.crashAfter = n;
+        else if (a == "--corrupt-every") o.corruptEvery = n;
+        else {
+            std::cerr << "coordinator: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+    std::vector<std::string> job(args.begin() + i, args.end());
+    std::string kind = job.empty() ? "" : job[0];
+
+    std::vector<Unit> units;
+    std::vector<std::string> rootMoves;
+    int perftDepth = 0;
+    std::string error;
+    bool ok;
+    if (kind == "perft") ok = perftUnits(job, o.split, units, rootMoves, perftDepth, error);
+    else if (kind == "epd") ok = epdUnits(job, o.batch, units, error);
+    else if (kind == "selfplay") ok = selfPlayUnits(job, o.batch, units, error);
+    else {
+        ok = false;
+        error = "expected a job: perft DEPTH [FEN] | epd FILE [limit] | selfplay [options]";
+    }
+    if (!ok) {
+        std::cerr << "coordinator: " << error << std::endl;
+        return 1;
+    }
+    std::ofstream file;
+    if (!o.outFile.empty()) {
+        file.open(o.outFile);
+        if (!file) {
+            std::cerr << "coordinator: cannot write " << o.outFile << std::endl;
+            return 1;
+        }
+    }
+    if (!initSockets()) {
+        std::cerr << "coordinator: socket library initialisation failed" << std::endl;
+        return 1;
+    }
+    SocketHandle listener = listenOn(o.bind, o.port, o.port);
+    if (listener == INVALID_SOCKET_HANDLE) {
+        std::cerr << "coordinator: cannot listen on " << o.bind << ":" << o.port << std::endl;
+        return 1;
+    }
+    std::cout << "Coordinator: " << kind << " job in " << units.size() << " units, listening on "
+        << o.bind << ":" << o.port << std::endl;
+
+    std::vector<ProcessHandle> processes;
+    std::string workerHost = o.bind == "0.0.0.0" ? "127.0.0.1" : o.bind;
+    for (int w = 0; w < o.spawn; ++w) {
+        std::vector<std::string> workerArgs = { "worker", "--host", workerHost, "--port", std::to_string(o.port),
+            "--name", "local-" + std::to_string(w + 1) };
+        if (w == 0 && o.crashAfter > 0) {
+            workerArgs.push_back("--crash-after");
+            workerArgs.push_back(std::to_string(o.crashAfter));
+        }
+        if (w == 0 && o.corruptEvery > 0) {
+            workerArgs.push_back("--corrupt-every");
+            workerArgs.push_back(std::to_string(o.corruptEvery));
+        }
+        ProcessHandle process;
+        if (!spawnProcess(workerArgs, process)) {
+            std::cerr << "coordinator: cannot start a local worker" << std::endl;
+            break;
+        }
+        processes.push_back(process);
+    }
+
+    std::deque<std::size_t> queue;
+    for (std::size_t u = 0; u < units.size(); ++u) queue.push_back(u);
+    std::size_t remaining = units.size();
+    std::vector<std::unique_ptr<RemoteWorker>> workers;
+    std::map<std::string, int> completedBy;    // survives the worker, for the report
+    int requeued = 0, badChecksums = 0, lostWorkers = 0;
+    bool failed = false;
+    Clock::time_point start = Clock::now(), lastProgress = start;
+
+    auto dropWorker = [&](std::size_t w, const std::string& why) {
+        RemoteWorker& worker = *workers[w];
+        std::cerr << "coordinator: worker " << (worker.name.empty() ? "?" : worker.name) << " " << why;
+        if (!worker.assigned.empty()) std::cerr << ", re-queueing " << worker.assigned.size() << " units";
+        std::cerr << std::endl;
+        for (auto it = worker.assigned.rbegin(); it != worker.assigned.rend(); ++it) queue.push_front(*it);
+        requeued += int(worker.assigned.size());
+        ++lostWorkers;
+        closeSocket(worker.socket);
+        workers.erase(workers.begin() + long(w));
+    };
+
+    std::vector<SocketHandle> sockets;
+    std::vector<bool> readable;
+    std::vector<std::string> lines;
+    while (remaining > 0 && !failed) {
+        sockets.assign(1, listener);
+        for (const auto& worker : workers) sockets.push_back(worker->socket);
+        pollReadable(sockets, readable, 200);
+        Clock::time_point now = Clock::now();
+
+        if (readable[0]) {
+            SocketHandle client = acceptClient(listener);
+            if (client != INVALID_SOCKET_HANDLE) workers.emplace_back(new RemoteWorker(client));
+        }
+        // Walk backwards so dropping a worker does not disturb the flags still to look at.
+        for (std::size_t w = std::min(workers.size(), readable.size() - 1); w-- > 0;) {
+            if (!readable[w + 1]) continue;
+            RemoteWorker& worker = *workers[w];
+            lines.clear();
+            if (!worker.reader.readLines(lines)) {
+                dropWorker(w, "disconnected");
+                continue;
+            }
+            worker.lastHeard = now;
+            for (const std::string& line : lines) {
+                std::istringstream in(line);
+                std::string verb, id;
+                in >> verb;
+                if (verb == "hello") {
+                    std::getline(in >> std::ws, worker.name);
+                    std::cout << "Worker " << worker.name << " joined" << std::endl;
+                    continue;
+                }
+                if (verb != "result" && verb != "failed") continue;
+                in >> id;
+                std::size_t u = std::size_t(std::atoll(id.c_str()));
+                auto mine = std::find(worker.assigned.begin(), worker.assigned.end(), u);
+                if (mine == worker.assigned.end()) continue;
+                worker.assigned.erase(mine);
+                Unit& unit = units[u];
+                std::string rest;
+                std::getline(in >> std::ws, rest);
+                if (verb == "failed") {
+                    unit.lastError = rest;
+                    std::cerr << "coordinator: unit " << u << " failed on " << worker.name << ": " << rest << std::endl;
+                    queue.push_front(u);
+                    ++requeued;
+                    continue;
+                }
+                size_t space = rest.find(' ');
+                std::string sum = rest.substr(0, space);
+                std::string payload = space == std::string::npos ? "" : rest.substr(space + 1);
+                if (sum != checksum(id, payload) || !validPayload(unit.text.substr(0, unit.text.find('\t')), payload)) {
+                    unit.lastError = "bad checksum";
+                    std::cerr << "coordinator: unit " << u << " from " << worker.name << " failed its checksum" << std::endl;
+                    queue.push_front(u);
+                    ++requeued;
+                    ++badChecksums;
+                    continue;
+                }
+                unit.payload = payload;
+                unit.done = true;
+                --remaining;
+                ++worker.completed;
+                ++completedBy[worker.name];
+            }
+        }
+        for (std::size_t w = workers.size(); w-- > 0;) {
+            if (now - workers[w]->lastHeard > std::chrono::milliseconds(o.timeoutMs)) {
+                dropWorker(w, "timed out");
+            }
+        }
+
+        // Hand out units; a unit that already went wrong on maxAttempts workers ends the job.
+        for (const auto& worker : workers) {
+            std::string batch;
+            while (!worker->name.empty() && !queue.empty() && int(worker->assigned.size()) < o.prefetch) {
+                std::size_t u = queue.front();
+                queue.pop_front();
+                if (units[u].done) continue;
+                if (units[u].attempts >= maxAttempts) {
+                    std::cerr << "coordinator: unit " << u << " failed " << maxAttempts << " times"
+                        << (units[u].lastError.empty() ? "" : " (" + units[u].lastError + ")") << ", giving up" << std::endl;
+                    failed = true;
+                    break;
+                }
+                ++units[u].attempts;
+                worker->assigned.push_back(u);
+                batch += "unit " + std::to_string(u) + " " + units[u].text + "\n";
+            }
+            // A failed send shows up as a hang-up on the next poll.
+            if (!batch.empty()) sendAll(worker->socket, batch);
+        }
+
+        if (!processes.empty() && workers.empty() &&
+            std::none_of(processes.begin(), processes.end(), processRunning)) {
+            std::cerr << "coordinator: every local worker has exited" << std::endl;
+            failed = true;
+        }
+        if (now - lastProgress >= std::chrono::seconds(5)) {
+            lastProgress = now;
+            std::cout << "Units " << units.size() - remaining << " / " << units.size() << "  workers "
+                << workers.size() << "  re-queued " << requeued << std::endl;
+        }
+    }
+
+    for (const auto& worker : workers) {
+        sendAll(worker->socket, "bye\n");
+        closeSocket(worker->socket);
+    }
+    closeSocket(listener);
+    for (ProcessHandle process : processes) {
+        waitProcess(process);
+    }
+    if (failed) return 1;
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "Finished " << units.size() << " units in " << std::fixed << std::setprecision(1) << seconds
+        << " s on " << completedBy.size() << " workers, " << requeued << " re-queued (" << lostWorkers
+        << " workers lost, " << badChecksums << " bad checksums)" << std::endl;
+    for (const auto& entry : completedBy) {
+        std::cout << "  " << entry.first << ": " << entry.second << " units" << std::endl;
+    }
+    if (kind == "perft") {
+        std::map<std::string, long long> perMove;
+        long long total = 0;
+        for (const Unit& unit : units) {
+            long long n = std::atoll(unit.payload.c_str());
+            perMove[unit.label] += n;
+            total += n;
+        }
+        for (const std::string& move : rootMoves) {
+            std::cout << move << ": " << perMove[move] << "\n";
+        }
+        std::cout << "Perft " << perftDepth << ": " << total << " nodes  " << std::setprecision(0)
+            << (seconds > 0 ? total / seconds : 0.0) << " nodes/s" << std::endl;
+    }
+    else if (kind == "epd") {
+        std::ostream& out = o.outFile.empty() ? std::cout : file;
+        int positions = 0, tested = 0, solved = 0;
+        long long nodes = 0;
+        for (const Unit& unit : units) {
+            std::vector<std::string> f = splitFields(unit.payload);
+            for (size_t r = 0; r + 3 < f.size(); r += 4) {
+                ++positions;
+                tested += f[r] == "1";
+                solved += f[r + 1] == "1";
+                nodes += std::atoll(f[r + 2].c_str());
+                out << f[r + 3] << "\n";
+            }
+        }
+        out.flush();
+        std::cout << "Positions " << positions << "  nodes " << nodes << "  nps " << std::setprecision(0)
+            << (seconds > 0 ? nodes / seconds : 0.0) << std::endl;
+        if (tested > 0) {
+            std::cout << "Solved " << solved << " / " << tested << std::setprecision(1)
+                << " (" << 100.0 * solved / tested << "%)" << std::endl;
+        }
+    }
+    else {
+        int wins = 0, draws = 0, losses = 0;
+        for (const Unit& unit : units) {
+            std::vector<std::string> f = splitFields(unit.payload);
+            wins += std::atoi(f[0].c_str());
+            draws += std::atoi(f[1].c_str());
+            losses += std::atoi(f[2].c_str());
+        }
+        double diff, margin;
+        estimateElo(wins, draws, losses, diff, margin);
+        std::cout << "Games " << wins + draws + losses << ": A vs B +" << wins << " =" << draws << " -" << losses
+            << std::setprecision(1) << ", Elo " << diff << " +/- " << margin << std::endl;
+    }
+    return 0;
+}
+
+int runWorker(const std::vector<std::string>& args) {
+    WorkerOptions o;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        const std::string& a = args[i];
+        const std::string& v = args[i + 1];
+        int n = std::atoi(v.c_str());
+        if (a == "--host") o.host = v;
+        else if (a == "--port") o.port = n;
+        else if (a == "--name") o.name = v;
+        else if (a == "--hash") o.hashMb = std::size_t(std::max(1, n));
+        else if (a == "--retry") o.retrySeconds = std::max(0, n);
+        else if (a == "--crash-after") o.crashAfter = n;
+        else if (a == "--corrupt-every") o.corruptEvery = n;
+        else {
+            std::cerr << "worker: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+    if (args.size() % 2 != 0) {
+        std::cerr << "worker: missing value for " << args.back() << std::endl;
+        return 1;
+    }
+    if (o.name.empty()) o.name = defaultWorkerName();
+    if (!initSockets()) {
+        std::cerr << "worker: socket library initialisation failed" << std::endl;
+        return 1;
+    }
+    Clock::time_point giveUp = Clock::now() + std::chrono::seconds(o.retrySeconds);
+    SocketHandle socket;
+    while ((socket = connectTo(o.host, o.port)) == INVALID_SOCKET_HANDLE && Clock::now() < giveUp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    if (socket == INVALID_SOCKET_HANDLE) {
+        std::cerr << "worker: cannot connect to " << o.host << ":" << o.port << std::endl;
+        return 1;
+    }
+
+    std::mutex sendMutex;
+    auto send = [&](const std::string& line) {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sendAll(socket, line + "\n");
+    };
+    send("hello " + o.name);
+
+    // Heartbeats go out from their own thread so a long unit doesn't look like a dead worker.
+    bool stopping = false;
+    std::mutex beatMutex;
+    std::condition_variable beatWake;
+    std::thread heartbeat([&] {
+        std::unique_lock<std::mutex> lock(beatMutex);
+        while (!beatWake.wait_for(lock, std::chrono::milliseconds(heartbeatMs), [&] { return stopping; })) {
+            send("beat");
+        }
+    });
+
+    LineReader reader(socket);
+    std::deque<std::string> queue;     // "ID FIELDS" of received units
+    std::vector<std::string> lines;
+    std::vector<SocketHandle> sockets(1, socket);
+    std::vector<bool> readable;
+    std::unique_ptr<Bot> bot;
+    int received = 0, finished = 0;
+    bool bye = false, lost = false;
+    while (!bye) {
+        if (queue.empty() || pollReadable(sockets, readable, 0) > 0) {
+            if (!reader.readLines(lines)) {
+                lost = true;
+                break;
+            }
+        }
+        for (const std::string& line : lines) {
+            if (line == "bye") bye = true;
+            if (line.compare(0, 5, "unit ") != 0) continue;
+            if (++received == o.crashAfter) std::_Exit(3);
+            queue.push_back(line.substr(5));
+        }
+        lines.clear();
+        if (bye || queue.empty()) continue;
+
+        std::string unit = queue.front();
+        queue.pop_front();
+        size_t space = unit.find(' ');
+        std::string id = unit.substr(0, space);
+        std::string payload, error;
+        bool ok;
+        try {
+            ok = runUnit(splitFields(space == std::string::npos ? "" : unit.substr(space + 1)), bot, o, payload, error);
+        }
+        catch (const std::exception& e) {
+            ok = false;
+            error = e.what();
+        }
+        if (!ok) {
+            send("failed " + id + " " + error);
+            continue;
+        }
+        ++finished;
+        std::string sum = checksum(id, o.corruptEvery > 0 && finished % o.corruptEvery == 0 ? payload + "?" : payload);
+        send("result " + id + " " + sum + " " + payload);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(beatMutex);
+        stopping = true;
+    }
+    beatWake.notify_one();
+    heartbeat.join();
+    closeSocket(socket);
+    if (lost) {
+        std::cerr << "worker " << o.name << ": coordinator closed the connection" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Split a large job into work units and farm them out to worker processes
+ *        ("coordinator" mode).
+ * @param args Command-line arguments after the mode name: coordinator options, then the job.
+ * @return Process exit code.
+ *
+ * Jobs:
+ *   perft DEPTH [FEN]        One unit per position SPLIT plies below the root; the report
+ *                            lists the count per root move and the total.
+ *   epd FILE [--depth D | --nodes N | --movetime MS]
+ *                            BATCH records per unit; lines are printed in file order.
+ *   selfplay [options]       BATCH games per unit of the match "selfplay" would play with
+ *                            the same options (opening files must exist on every worker).
+ *
+ * Workers connect whenever they like and receive up to PREFETCH units at a time. A worker
+ * that disconnects or stays silent longer than the timeout is dropped and its units go back
+ * to the front of the queue; so does a unit whose result fails its checksum or that the
+ * worker reports as failed. A unit that fails on three workers aborts the job.
+ *
+ * Options:
+ *   --bind ADDR         Address to listen on (default 127.0.0.1; 0.0.0.0 for remote workers).
+ *   --port P            Port (default 7880, 0 = any free port).
+ *   --spawn N           Start N local worker processes of this executable (default 0).
+ *   --timeout MS        Silence after which a worker counts as dead (default 10000).
+ *   --prefetch N        Units outstanding per worker (default 2).
+ *   --split PLIES       perft: plies expanded by the coordinator (default 2).
+ *   --batch N           epd records or selfplay games per unit (default 10).
+ *   --out FILE          epd: write the per-position lines there instead of stdout.
+ *   --crash-after N     Fault injection: the first spawned worker dies on its Nth unit.
+ *   --corrupt-every N   Fault injection: the first spawned worker garbles every Nth checksum.
+ *
+ * Protocol (one line each way, fields after the unit kind separated by tabs):
+ *   worker: hello NAME | beat | result ID CHECKSUM PAYLOAD | failed ID REASON
+ *   coordinator: unit ID KIND<TAB>FIELD... | bye
+ * CHECKSUM is the 64-bit FNV-1a hash of "ID PAYLOAD" in hex.
+ */
+int runCoordinator(const std::vector<std::string>& args);
+
+/**
+ * @brief Work off the units a coordinator sends until it says goodbye ("worker" mode).
+ * @param args Command-line arguments after the mode name.
+ * @return 0 after "bye", 1 if the coordinator cannot be reached or goes away.
+ *
+ * Units run one at a time; start one worker per core. A heartbeat line every second keeps
+ * the coordinator from declaring a worker dead during a long unit.
+ *
+ * Options:
+ *   --host H            Coordinator host (default 127.0.0.1).
+ *   --port P            Coordinator port (default 7880).
+ *   --name NAME         Name in the coordinator's report (default host:pid).
+ *   --hash MB           Transposition table for epd units (default 16).
+ *   --retry S           Keep trying to connect for S seconds (default 10).
+ *   --crash-after N     Exit without a word on receiving the Nth unit.
+ *   --corrupt-every N   Send a wrong checksum with every Nth result.
+ */
+int runWorker(const std::vector<std::string>& args);
+
+#endif // DISTRIBUTED_H
@@ -0,0 +1,243 @@
+/**
+ * @file Epd.cpp
+ * @brief EPD test-suite runner on top of Bot::think, spread over a ThreadPool.
+ *
+ * Each pool worker keeps its own Bot, cleared before every position so a result depends only
+ * on the position and the limits, not on what the worker searched before. Lines finish out
+ * of order and are written as soon as every earlier line is done.
+ */
+#include "Epd.h"
+#include "Board.h"
+#include "Bot.h"
+#include "Notation.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    struct EpdPosition {
+        int line = 0;
+        std::string fen;
+        std::string id;
+        std::vector<std::string> bestMoves;    ///< bm operands (SAN)
+        std::vector<std::string> avoidMoves;   ///< am operands (SAN)
+    };
+
+    std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+    }
+
+    // "<placement> <side> <castling> <ep> [opcode operands;]..." or a plain six-field FEN.
+    bool parseEpdLine(const std::string& text, EpdPosition& pos) {
+        std::istringstream in(text);
+        std::string fields[4];
+        for (std::string& f : fields) {
+            if (!(in >> f)) return false;
+        }
+        pos.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+        std::string rest;
+        std::getline(in, rest);
+        std::istringstream ops(rest);
+        std::string op;
+        while (std::getline(ops, op, ';')) {
+            std::istringstream words(trim(op));
+            std::string code, operand;
+            if (!(words >> code)) continue;
+            std::vector<std::string> operands;
+            while (words >> operand) {
+                operands.push_back(operand);
+            }
+            if (code == "bm") pos.bestMoves = operands;
+            else if (code == "am") pos.avoidMoves = operands;
+            else if (code == "id") {
+                std::string id = trim(op.substr(op.find("id") + 2));
+                if (id.size() >= 2 && id.front() == '"' && id.back() == '"') id = id.substr(1, id.size() - 2);
+                pos.id = id;
+            }
+        }
+        return true;
+    }
+
+    bool matchesAny(const Board& board, PackedMove move, const std::vector<std::string>& sans) {
+        for (const std::string& san : sans) {
+            if (parseMove(board, san) == move) return true;
+        }
+        return false;
+    }
+
+    void analyse(Bot& bot, const EpdPosition& pos, const SearchLimits& limits, EpdResult& result) {
+        std::ostringstream out;
+        out << "#" << pos.line;
+        if (!pos.id.empty()) out << " \"" << pos.id << "\"";
+        Board board;
+        try {
+            board.loadFromFen(pos.fen);
+        }
+        catch (const std::exception& e) {
+            out << "  error: " << e.what();
+            result.text = out.str();
+            return;
+        }
+        bot.clearHash();
+        bot.setColor(board.currentPlayerColor);
+        bot.setSearchLimits(limits);
+        PackedMove best = bot.think(board);
+        const SearchResult& r = bot.getLastResult();
+        result.nodes = r.nodes;
+
+        out << "  best " << (best ? moveToSan(board, best) + " (" + packedMoveToString(best) + ")" : std::string("none"))
+            << "  score " << Bot::formatScore(r.score) << "  depth " << r.depth
+            << "  nodes " << r.nodes << "  time " << r.timeMs << " ms  pv";
+        for (PackedMove m : r.pv) out << " " << packedMoveToString(m);
+
+        if (!pos.bestMoves.empty() || !pos.avoidMoves.empty()) {
+            result.tested = true;
+            bool good = best != 0;
+            if (!pos.bestMoves.empty()) {
+                out << "  bm";
+                for (const std::string& m : pos.bestMoves) out << " " << m;
+                good = good && matchesAny(board, best, pos.bestMoves);
+            }
+            if (!pos.avoidMoves.empty()) {
+                out << "  am";
+                for (const std::string& m : pos.avoidMoves) out << " " << m;
+                good = good && !matchesAny(board, best, pos.avoidMoves);
+            }
+            result.solved = good;
+            out << (good ? "  solved" : "  FAILED");
+        }
+        result.text = out.str();
+    }
+}
+
+void analyseEpdRecord(Bot& bot, int lineNumber, const std::string& record, const SearchLimits& limits, EpdResult& result) {
+    EpdPosition pos;
+    pos.line = lineNumber;
+    if (!parseEpdLine(trim(record), pos)) {
+        result.text = "#" + std::to_string(lineNumber) + "  error: not an EPD record";
+        return;
+    }
+    analyse(bot, pos, limits, result);
+}
+
+int runEpdAnalysis(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "epd: missing input file" << std::endl;
+        return 1;
+    }
+    SearchLimits limits;
+    limits.maxDepth = 8;
+    limits.moveTimeMs = 0;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    int searchThreads = 1;
+    std::size_t hashMb = 16;
+    std::string outFile;
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        if (i + 1 >= args.size()) {
+            std::cerr << "epd: missing value for " << a << std::endl;
+            return 1;
+        }
+        const std::string& v = args[++i];
+        if (a == "--depth") { limits.maxDepth = std::atoi(v.c_str()); }
+        else if (a == "--nodes") { limits.maxNodes = std::atoll(v.c_str()); limits.maxDepth = Bot::MAX_PLY - 1; }
+        else if (a == "--movetime") { limits.moveTimeMs = std::atoi(v.c_str()); limits.maxDepth = Bot::MAX_PLY - 1; }
+        else if (a == "--threads") threads = std::size_t(std::max(1, std::atoi(v.c_str())));
+        else if (a == "--search-threads") searchThreads = std::max(1, std::atoi(v.c_str()));
+        else if (a == "--hash") hashMb = std::size_t(std::max(1, std::atoi(v.c_str())));
+        else if (a == "--out") outFile = v;
+        else {
+            std::cerr << "epd: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream in(args[0]);
+    if (!in) {
+        std::cerr << "epd: cannot open " << args[0] << std::endl;
+        return 1;
+    }
+    std::vector<EpdPosition> positions;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        EpdPosition pos;
+        pos.line = lineNumber;
+        if (parseEpdLine(line, pos)) {
+            positions.push_back(pos);
+        }
+        else {
+            std::cerr << "epd: line " << lineNumber << " is not an EPD record" << std::endl;
+        }
+    }
+
+    std::ofstream file;
+    if (!outFile.empty()) {
+        file.open(outFile);
+        if (!file) {
+            std::cerr << "epd: cannot write " << outFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outFile.empty() ? std::cout : file;
+
+    std::vector<EpdResult> results(positions.size());
+    std::size_t nextToWrite = 0;
+    std::mutex resultMutex;
+    std::vector<std::unique_ptr<Bot>> bots(threads);
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(threads);
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            pool.submit([&, i](std::size_t worker) {
+                if (!bots[worker]) {
+                    bots[worker].reset(new Bot(Color::WHITE));
+                    bots[worker]->setHashSize(hashMb);
+                    bots[worker]->setThreads(searchThreads);
+                }
+                EpdResult result;
+                analyse(*bots[worker], positions[i], limits, result);
+                result.done = true;
+
+                std::lock_guard<std::mutex> lock(resultMutex);
+                results[i] = result;
+                while (nextToWrite < results.size() && results[nextToWrite].done) {
+                    out << results[nextToWrite++].text << "\n";
+                }
+                out.flush();
+            });
+        }
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int tested = 0, solved = 0;
+    long long nodes = 0;
+    for (const EpdResult& r : results) {
+        nodes += r.nodes;
+        if (r.tested) {
+            ++tested;
+            if (r.solved) ++solved;
+        }
+    }
+    std::cout << "Positions " << positions.size() << "  time " << std::fixed << std::setprecision(1) << seconds << " s"
+        << "  nodes " << nodes << "  nps " << std::setprecision(0) << (seconds > 0 ? nodes / seconds : 0.0)
+        << "  (" << threads << " x " << searchThreads << " threads)" << std::endl;
+    if (tested > 0) {
+        std::cout << "Solved " << solved << " / " << tested << std::setprecision(1)
+            << " (" << 100.0 * solved / tested << "%)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <string>
+#include <vector>
+#include "Bot.h"
+
+/// Outcome of one EPD record.
+struct EpdResult {
+    std::string text;       ///< Output line: "#LINE "id"  best ... pv ...".
+    bool tested = false;    ///< Had bm or am.
+    bool solved = false;
+    long long nodes = 0;
+    bool done = false;
+};
+
+/**
+ * @brief Batch analysis of an EPD/FEN file ("epd" mode).
+ * @param args Command-line arguments after the mode name: the file, then options.
+ * @return Process exit code.
+ *
+ * Every position is searched to a fixed depth, node count or time, and one line per position
+ * (best move, score, depth, PV, nodes, time) is written in file order. Positions with `bm`
+ * (best move) or `am` (avoid move) opcodes count towards the solve rate printed at the end.
+ *
+ * Options:
+ *   --depth D | --nodes N | --movetime MS   Search limit per position (default depth 8).
+ *   --threads N          Positions searched in parallel (default: hardware threads).
+ *   --search-threads N   Threads per search (Lazy SMP); use with --threads 1 to give every
+ *                        position the whole machine.
+ *   --hash MB            Transposition table per search (default 16).
+ *   --out FILE           Write the per-position lines there instead of stdout.
+ */
+int runEpdAnalysis(const std::vector<std::string>& args);
+
+/**
+ * @brief Analyse one EPD record exactly as "epd" mode does (the hash is cleared first).
+ * @param lineNumber Line of the record in its file; it starts the output text.
+ *
+ * A record that does not parse gives an "error" line rather than an exception.
+ */
+void analyseEpdRecord(Bot& bot, int lineNumber, const std::string& record, const SearchLimits& limits, EpdResult& result);
+
+#endif // EPD_H
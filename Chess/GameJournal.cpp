@@ -0,0 +1,307 @@
+/**
+ * @file GameJournal.cpp
+ * @brief Record encoding, batched fsync and recovery of the append-only game journal.
+ *
+ * File layout: the magic "CHJ1", then records of
+ *   type (1 byte) | game ID (4) | payload | FNV-1a checksum of the preceding bytes (4)
+ * with little-endian integers and the payloads
+ *   'B' begin: text length (2) and "FEN\nINFO"
+ *   'M' move:  packed move (2) and promotion (1)
+ *   'E' end:   nothing
+ * A record cut short by a crash, or one whose checksum fails, ends the readable journal.
+ */
+#include "GameJournal.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[4] = { 'C', 'H', 'J', '1' };
+    const std::size_t CHECKSUM_BYTES = 4;
+
+    std::uint32_t checksum(const std::uint8_t* data, std::size_t size) {
+        std::uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    void putInt(std::vector<std::uint8_t>& out, std::uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    std::uint32_t getInt(const std::uint8_t* in, int bytes) {
+        std::uint32_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value |= std::uint32_t(in[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::vector<std::uint8_t> makeRecord(char type, std::uint32_t game) {
+        std::vector<std::uint8_t> record;
+        record.push_back(static_cast<std::uint8_t>(type));
+        putInt(record, game, 4);
+        return record;
+    }
+
+    void seal(std::vector<std::uint8_t>& record) {
+        putInt(record, checksum(record.data(), record.size()), 4);
+    }
+
+    std::vector<std::uint8_t> beginRecord(std::uint32_t game, const std::string& fen, const std::string& info) {
+        std::string text = fen + "\n" + info;
+        if (text.size() > 0xFFFF) text.resize(0xFFFF);
+        std::vector<std::uint8_t> record = makeRecord('B', game);
+        putInt(record, std::uint32_t(text.size()), 2);
+        record.insert(record.end(), text.begin(), text.end());
+        seal(record);
+        return record;
+    }
+
+    std::vector<std::uint8_t> moveRecord(std::uint32_t game, PackedMove move, std::uint8_t promotion) {
+        std::vector<std::uint8_t> record = makeRecord('M', game);
+        putInt(record, move, 2);
+        record.push_back(promotion);
+        seal(record);
+        return record;
+    }
+
+    // Read records from `pos` until the end or the first torn/corrupt one; returns where reading stopped.
+    std::size_t parseRecords(const std::vector<std::uint8_t>& data, std::size_t pos, std::vector<JournalGame>& games) {
+        std::map<std::uint32_t, std::size_t> index;
+        while (pos + 5 + CHECKSUM_BYTES <= data.size()) {
+            char type = static_cast<char>(data[pos]);
+            std::uint32_t game = getInt(&data[pos + 1], 4);
+            std::size_t payload;
+            if (type == 'B') {
+                if (pos + 7 > data.size()) break;
+                payload = 2 + getInt(&data[pos + 5], 2);
+            }
+            else if (type == 'M') payload = 3;
+            else if (type == 'E') payload = 0;
+            else break;
+            std::size_t size = 5 + payload;
+            if (pos + size + CHECKSUM_BYTES > data.size()) break;
+            if (getInt(&data[pos + size], 4) != checksum(&data[pos], size)) break;
+
+            const std::uint8_t* body = &data[pos + 5];
+            if (type == 'B') {
+                std::string text(reinterpret_cast<const char*>(body + 2), payload - 2);
+                std::size_t newline = text.find('\n');
+                JournalGame g;
+                g.id = game;
+                g.fen = text.substr(0, newline);
+                g.info = newline == std::string::npos ? "" : text.substr(newline + 1);
+                index[game] = games.size();
+                games.push_back(g);
+            }
+            else {
+                // Records of a game whose begin record is missing can't be replayed; skip them.
+                auto it = index.find(game);
+                if (it != index.end()) {
+                    JournalGame& g = games[it->second];
+                    if (type == 'E') g.ended = true;
+                    else g.moves.push_back({ static_cast<PackedMove>(getInt(body, 2)), body[2] });
+                }
+            }
+            pos += size + CHECKSUM_BYTES;
+        }
+        return pos;
+    }
+
+    bool syncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+}
+
+void JournalGame::replay(Board& board) const {
+    board.loadFromFen(fen);
+    for (size_t i = 0; i < moves.size(); ++i) {
+        PackedMove m = moves[i].move;
+        Piece* piece = board.getPieceAt(packedFromX(m), packedFromY(m));
+        if (!piece || !board.applyMove(piece->getId(), packedToX(m), packedToY(m)).first) {
+            throw std::runtime_error("Journal game " + std::to_string(id) + ": illegal move " +
+                std::to_string(i + 1) + " (" + packedMoveToString(m) + ")");
+        }
+        int promotion = moves[i].promotion;
+        if (promotion && static_cast<PieceType>(promotion - 1) != PieceType::QUEEN) {
+            board.promotePiece(piece->getId(), static_cast<PieceType>(promotion - 1));
+        }
+    }
+}
+
+GameJournal::~GameJournal() {
+    close();
+}
+
+bool GameJournal::openFile(const std::string& path, const char* mode, std::string& error) {
+    file = std::fopen(path.c_str(), mode);
+    if (!file) {
+        error = "cannot open journal " + path;
+        return false;
+    }
+    unsynced = 0;
+    return true;
+}
+
+bool GameJournal::create(const std::string& path, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) std::fclose(file);
+    if (!openFile(path, "wb", error)) return false;
+    if (std::fwrite(MAGIC, 1, sizeof(MAGIC), file) != sizeof(MAGIC) || !syncFile(file)) {
+        std::fclose(file);
+        file = nullptr;
+        error = "cannot write journal " + path;
+        return false;
+    }
+    return true;
+}
+
+bool GameJournal::resume(const std::string& path, std::vector<JournalGame>& unfinished, std::string& error) {
+    unfinished.clear();
+    std::vector<std::uint8_t> data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return create(path, error);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    if (data.size() < sizeof(MAGIC) || !std::equal(MAGIC, MAGIC + sizeof(MAGIC), data.begin())) {
+        error = path + " is not a game journal";
+        return false;
+    }
+    std::vector<JournalGame> games;
+    std::size_t end = parseRecords(data, sizeof(MAGIC), games);
+    bool rewrite = end != data.size();
+    for (JournalGame& g : games) {
+        if (g.ended) rewrite = true;
+        else unfinished.push_back(g);
+    }
+    if (!rewrite) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file) std::fclose(file);
+        return openFile(path, "ab", error);
+    }
+
+    // Drop the torn tail and the finished games: write the rest to a new file and swap it in.
+    std::string scratch = path + ".tmp";
+    if (!create(scratch, error)) return false;
+    for (const JournalGame& g : unfinished) {
+        append(beginRecord(g.id, g.fen, g.info));
+        for (const JournalMove& m : g.moves) {
+            append(moveRecord(g.id, m.move, m.promotion));
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    bool written = file && syncFile(file);
+    if (file) std::fclose(file);
+    file = nullptr;
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (!written || std::rename(scratch.c_str(), path.c_str()) != 0) {
+        error = "cannot rewrite journal " + path;
+        return false;
+    }
+    return openFile(path, "ab", error);
+}
+
+void GameJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) return;
+    syncLocked();
+    std::fclose(file);
+    file = nullptr;
+}
+
+bool GameJournal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr;
+}
+
+void GameJournal::setSyncPolicy(int records, int delayMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    syncRecords = std::max(1, records);
+    syncDelay = std::chrono::milliseconds(std::max(0, delayMs));
+}
+
+void GameJournal::beginGame(std::uint32_t game, const std::string& fen, const std::string& info) {
+    append(beginRecord(game, fen, info));
+}
+
+void GameJournal::recordMove(std::uint32_t game, PackedMove move, std::uint8_t promotion) {
+    append(moveRecord(game, move, promotion));
+}
+
+void GameJournal::recordLastMove(std::uint32_t game, const Board& board) {
+    const Move* last = board.getLastMove();
+    if (!last) return;
+    std::uint8_t promotion = last->promoted ? static_cast<std::uint8_t>(1 + static_cast<int>(last->promotedTo)) : 0;
+    recordMove(game, packMove(last->from.first, last->from.second, last->to.first, last->to.second), promotion);
+}
+
+void GameJournal::endGame(std::uint32_t game) {
+    std::vector<std::uint8_t> record = makeRecord('E', game);
+    seal(record);
+    append(record);
+}
+
+void GameJournal::append(const std::vector<std::uint8_t>& record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) return;
+    // Hand the record to the OS at once; only the fsync waits for the batch.
+    if (std::fwrite(record.data(), 1, record.size(), file) != record.size() || std::fflush(file) != 0) {
+        std::cerr << "journal: write failed, journaling stopped" << std::endl;
+        std::fclose(file);
+        file = nullptr;
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (unsynced++ == 0) firstUnsynced = now;
+    if (unsynced >= syncRecords || now - firstUnsynced >= syncDelay) {
+        syncLocked();
+    }
+}
+
+void GameJournal::syncIfDue() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file && unsynced > 0 && std::chrono::steady_clock::now() - firstUnsynced >= syncDelay) {
+        syncLocked();
+    }
+}
+
+void GameJournal::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) syncLocked();
+}
+
+void GameJournal::syncLocked() {
+    if (unsynced == 0) return;
+    if (!syncFile(file)) {
+        std::cerr << "journal: fsync failed" << std::endl;
+    }
+    unsynced = 0;
+}
+
+bool GameJournal::isJournal(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    return in.read(magic, sizeof(magic)) && std::equal(MAGIC, MAGIC + sizeof(MAGIC), magic);
+}
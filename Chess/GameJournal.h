@@ -0,0 +1,91 @@
+#ifndef GAME_JOURNAL_H
+#define GAME_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include "Board.h"
+
+/**
+ * @struct JournalMove
+ * @brief One move of a journaled game: from/to squares and the piece a pawn promoted to.
+ */
+struct JournalMove {
+    PackedMove move = 0;
+    std::uint8_t promotion = 0;        ///< 0, or 1 + PieceType of the promoted piece.
+};
+
+/**
+ * @struct JournalGame
+ * @brief A game recovered from a journal: its start position and the moves played since.
+ */
+struct JournalGame {
+    std::uint32_t id = 0;
+    std::string fen;                   ///< Start position.
+    std::string info;                  ///< Owner's text from beginGame() (e.g. the server's game settings).
+    std::vector<JournalMove> moves;
+    bool ended = false;
+
+    /// Set up the start position and play the moves; throws std::runtime_error if one is illegal.
+    void replay(Board& board) const;
+};
+
+/**
+ * @class GameJournal
+ * @brief Append-only, crash-safe record of games as they are played.
+ *
+ * Instead of rewriting a full snapshot, each move is appended as a 12-byte record (game ID,
+ * packed move, promotion, checksum) the moment it is played. Records are handed to the OS at
+ * once, so a crashed or killed process loses nothing; fsync is batched (setSyncPolicy()), so
+ * only a machine crash can lose the last few records, never corrupt earlier ones. One
+ * journal can hold many games, which lets a server cover the moves of all of them with one
+ * fsync.
+ *
+ * resume() is the recovery path: it reads the journal back, stops at the first torn or
+ * corrupt record, rewrites the file without it and without finished games, and returns the
+ * unfinished games for replay(). All members are thread-safe.
+ */
+class GameJournal {
+public:
+    GameJournal() = default;
+    ~GameJournal();
+
+    GameJournal(const GameJournal&) = delete;
+    GameJournal& operator=(const GameJournal&) = delete;
+
+    bool create(const std::string& path, std::string& error);  ///< Start an empty journal, replacing any file.
+    /// Recover the unfinished games of an existing journal (none if there is no file) and keep appending to it.
+    bool resume(const std::string& path, std::vector<JournalGame>& unfinished, std::string& error);
+    void close();                      ///< Sync and close.
+    bool isOpen() const;
+
+    /// fsync after `records` appended records, or once the oldest unsynced one is `delayMs` old (default 64, 50 ms).
+    void setSyncPolicy(int records, int delayMs);
+
+    void beginGame(std::uint32_t game, const std::string& fen, const std::string& info = "");
+    void recordMove(std::uint32_t game, PackedMove move, std::uint8_t promotion = 0);
+    void recordLastMove(std::uint32_t game, const Board& board);  ///< The move just played on `board`.
+    void endGame(std::uint32_t game);
+
+    void syncIfDue();                  ///< Apply the delay of the sync policy; call it now and then when idle.
+    void sync();                       ///< fsync everything appended so far.
+
+    static bool isJournal(const std::string& path);  ///< Does the file start with the journal's magic?
+
+private:
+    void append(const std::vector<std::uint8_t>& record);
+    void syncLocked();
+    bool openFile(const std::string& path, const char* mode, std::string& error);
+
+    mutable std::mutex mutex;
+    std::FILE* file{ nullptr };
+    int syncRecords{ 64 };
+    std::chrono::milliseconds syncDelay{ 50 };
+    int unsynced{ 0 };
+    std::chrono::steady_clock::time_point firstUnsynced;
+};
+
+#endif // GAME_JOURNAL_H
@@ -0,0 +1,556 @@
+/**
+ * @file GameLog.cpp
+ * @brief Binary layout, index file, queries and text export of the game log.
+ *
+ * Layout of the log, little-endian:
+ *   header   "CHGL", version (4)
+ *   records  payload length (4) | payload | FNV-1a checksum of the payload (4), where the payload is
+ *            start (8) end (8) result (1) human colour (1) FEN length (2) FEN  move count (4)
+ *            moves (2 each: packed move | promotion << 12)  3 x histogram text length (2) and text
+ * and of its index, the same path plus ".idx":
+ *   header   "CHGI", version (4)
+ *   entries  one 28-byte entry per game: offset (8) start (8) duration (4) plies (2) result (1)
+ *            colour (1) checksum of those 24 bytes (4)
+ *
+ * Both files only grow at the end. Version 1 logs kept the index in a footer of the log
+ * itself; they read as a log whose index is missing, and the first append converts them.
+ */
+#include "GameLog.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+    const char HEADER_MAGIC[4] = { 'C', 'H', 'G', 'L' };
+    const char INDEX_MAGIC[4] = { 'C', 'H', 'G', 'I' };
+    const std::uint32_t VERSION = 2;
+    const std::size_t HEADER_BYTES = 8;
+    const std::size_t INDEX_HEADER_BYTES = 8;
+    const std::size_t ENTRY_BYTES = 28;
+
+    std::uint32_t checksum(const std::string& bytes) {
+        std::uint32_t hash = 2166136261u;
+        for (unsigned char c : bytes) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+    void put(std::string& out, std::uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out += static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    void putText(std::string& out, const std::string& text) {
+        std::size_t size = std::min<std::size_t>(text.size(), 0xFFFF);
+        put(out, size, 2);
+        out.append(text, 0, size);
+    }
+
+    // Bounds-checked reading of a record or index buffer.
+    class Reader {
+    public:
+        explicit Reader(std::string bytes) : bytes(std::move(bytes)) {}
+
+        std::uint64_t get(int size) {
+            need(size);
+            std::uint64_t value = 0;
+            for (int i = 0; i < size; ++i) {
+                value |= std::uint64_t(static_cast<unsigned char>(bytes[pos + i])) << (8 * i);
+            }
+            pos += size;
+            return value;
+        }
+
+        std::string text() {
+            std::size_t size = static_cast<std::size_t>(get(2));
+            need(size);
+            std::string value = bytes.substr(pos, size);
+            pos += size;
+            return value;
+        }
+
+    private:
+        void need(std::size_t size) const {
+            if (pos + size > bytes.size()) throw std::runtime_error("Game log record is truncated.");
+        }
+
+        std::string bytes;
+        std::size_t pos = 0;
+    };
+
+    std::string encodeRecord(const GameRecord& game) {
+        std::string payload;
+        put(payload, static_cast<std::uint64_t>(game.startTime), 8);
+        put(payload, static_cast<std::uint64_t>(game.endTime), 8);
+        put(payload, static_cast<std::uint8_t>(game.result), 1);
+        put(payload, game.humanColor == Color::BLACK, 1);
+        putText(payload, game.startFen);
+        put(payload, game.moves.size(), 4);
+        for (const JournalMove& m : game.moves) {
+            put(payload, m.move | (m.promotion << 12), 2);
+        }
+        putText(payload, game.thinkLatency.encode());
+        putText(payload, game.moveLatency.encode());
+        putText(payload, game.renderLatency.encode());
+
+        std::string record;
+        put(record, payload.size(), 4);
+        record += payload;
+        put(record, checksum(payload), 4);
+        return record;
+    }
+
+    GameRecord decodeRecord(const std::string& payload) {
+        Reader in(payload);
+        GameRecord game;
+        game.startTime = static_cast<std::int64_t>(in.get(8));
+        game.endTime = static_cast<std::int64_t>(in.get(8));
+        game.result = static_cast<GameResult>(std::min<std::uint64_t>(in.get(1), 2));
+        game.humanColor = in.get(1) ? Color::BLACK : Color::WHITE;
+        game.startFen = in.text();
+        std::uint64_t count = in.get(4);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::uint64_t m = in.get(2);
+            game.moves.push_back({ static_cast<PackedMove>(m & 0x0FFF), static_cast<std::uint8_t>(m >> 12) });
+        }
+        if (!game.thinkLatency.decode(in.text()) || !game.moveLatency.decode(in.text()) ||
+            !game.renderLatency.decode(in.text())) {
+            throw std::runtime_error("Game log record has a malformed latency histogram.");
+        }
+        return game;
+    }
+
+    GameIndexEntry entryFor(const GameRecord& game, std::uint64_t offset) {
+        GameIndexEntry entry;
+        entry.offset = offset;
+        entry.startTime = game.startTime;
+        entry.durationSec = static_cast<std::uint32_t>(std::max<std::int64_t>(0, game.endTime - game.startTime));
+        entry.plies = static_cast<std::uint16_t>(std::min<std::size_t>(game.moves.size(), 0xFFFF));
+        entry.result = game.result;
+        entry.humanColor = game.humanColor;
+        return entry;
+    }
+
+    std::string encodeEntry(const GameIndexEntry& e) {
+        std::string bytes;
+        put(bytes, e.offset, 8);
+        put(bytes, static_cast<std::uint64_t>(e.startTime), 8);
+        put(bytes, e.durationSec, 4);
+        put(bytes, e.plies, 2);
+        put(bytes, static_cast<std::uint8_t>(e.result), 1);
+        put(bytes, e.humanColor == Color::BLACK, 1);
+        put(bytes, checksum(bytes), 4);
+        return bytes;
+    }
+
+    // False if the entry's checksum doesn't match (e.g. it was only partly written).
+    bool decodeEntry(const std::string& bytes, GameIndexEntry& e) {
+        Reader in(bytes);
+        e.offset = in.get(8);
+        e.startTime = static_cast<std::int64_t>(in.get(8));
+        e.durationSec = static_cast<std::uint32_t>(in.get(4));
+        e.plies = static_cast<std::uint16_t>(in.get(2));
+        e.result = static_cast<GameResult>(std::min<std::uint64_t>(in.get(1), 2));
+        e.humanColor = in.get(1) ? Color::BLACK : Color::WHITE;
+        return checksum(bytes.substr(0, ENTRY_BYTES - 4)) == in.get(4);
+    }
+
+    std::string readBytes(std::ifstream& in, std::uint64_t offset, std::size_t size) {
+        std::string bytes(size, '\0');
+        in.seekg(static_cast<std::streamoff>(offset));
+        if (size && !in.read(&bytes[0], static_cast<std::streamsize>(size))) bytes.clear();
+        return bytes;
+    }
+
+    std::uint64_t fileSize(std::ifstream& in) {
+        in.seekg(0, std::ios::end);
+        return static_cast<std::uint64_t>(in.tellg());
+    }
+
+    std::uint64_t fileSize(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return in ? fileSize(in) : 0;
+    }
+
+    // Where the record at @p offset ends, or 0 if it is torn or fails its checksum.
+    std::uint64_t recordEnd(std::ifstream& in, std::uint64_t offset, std::uint64_t size) {
+        if (offset + 8 > size) return 0;
+        std::uint64_t length = Reader(readBytes(in, offset, 4)).get(4);
+        if (offset + 8 + length > size) return 0;
+        std::string payload = readBytes(in, offset + 4, static_cast<std::size_t>(length));
+        std::string sum = readBytes(in, offset + 4 + length, 4);
+        if (payload.size() != length || sum.size() != 4 || checksum(payload) != Reader(sum).get(4)) return 0;
+        return offset + 8 + length;
+    }
+
+    void createFile(const std::string& path, const std::string& bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.write(bytes.data(), bytes.size()) || !out.flush()) {
+            throw std::runtime_error("Failed to create game log: " + path);
+        }
+    }
+
+    void writeAt(const std::string& path, std::uint64_t offset, const std::string& bytes) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open game log: " + path);
+        }
+        file.seekp(static_cast<std::streamoff>(offset));
+        if (!file.write(bytes.data(), bytes.size()) || !file.flush()) {
+            throw std::runtime_error("Failed to write game log: " + path);
+        }
+    }
+
+    // Cuts the file back to its first @p size bytes through a copy renamed over it.
+    void truncateFile(const std::string& path, std::uint64_t size) {
+        std::ifstream source(path, std::ios::binary);
+        std::string kept = readBytes(source, 0, static_cast<std::size_t>(size));
+        source.close();
+        std::string scratch = path + ".tmp";
+        {
+            std::ofstream out(scratch, std::ios::binary);
+            if (kept.size() != size || !out.write(kept.data(), kept.size())) {
+                throw std::runtime_error("Failed to repair game log: " + path);
+            }
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        if (std::rename(scratch.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Failed to repair game log: " + path);
+        }
+    }
+
+    std::string formatTime(std::int64_t seconds, const char* format) {
+        std::time_t t = static_cast<std::time_t>(seconds);
+        std::tm* local = std::localtime(&t);
+        char text[64];
+        if (!local || !std::strftime(text, sizeof(text), format, local)) return "?";
+        return text;
+    }
+
+    std::string moveText(const JournalMove& m) {
+        std::string text = packedMoveToString(m.move);
+        if (m.promotion) text += "pnbrqk"[(m.promotion - 1) % 6];
+        return text;
+    }
+
+    std::string percent(long long part, long long whole) {
+        char text[16];
+        std::snprintf(text, sizeof(text), "%.1f%%", whole ? 100.0 * part / whole : 0.0);
+        return text;
+    }
+
+    // "YYYY-MM-DD" as local midnight; false if it doesn't parse.
+    bool parseDate(const std::string& text, std::int64_t& seconds) {
+        std::tm date = {};
+        if (std::sscanf(text.c_str(), "%d-%d-%d", &date.tm_year, &date.tm_mon, &date.tm_mday) != 3) return false;
+        date.tm_year -= 1900;
+        date.tm_mon -= 1;
+        date.tm_isdst = -1;
+        std::time_t t = std::mktime(&date);
+        if (t == static_cast<std::time_t>(-1)) return false;
+        seconds = static_cast<std::int64_t>(t);
+        return true;
+    }
+}
+
+const char* gameResultText(GameResult result) {
+    switch (result) {
+    case GameResult::WHITE_WINS: return "White wins by checkmate.";
+    case GameResult::BLACK_WINS: return "Black wins by checkmate.";
+    case GameResult::DRAW: break;
+    }
+    return "Draw by stalemate.";
+}
+
+bool GameFilter::matches(const GameIndexEntry& entry) const {
+    return entry.startTime >= since && entry.startTime < until &&
+        (result < 0 || static_cast<int>(entry.result) == result);
+}
+
+std::string GameSummary::text() const {
+    std::ostringstream out;
+    out << "Games: " << games;
+    if (games) {
+        out << " (started " << formatTime(firstStart, "%Y-%m-%d") << " to " << formatTime(lastStart, "%Y-%m-%d") << ")";
+    }
+    out << "\nWhite wins: " << whiteWins << " (" << percent(whiteWins, games) << ")"
+        << "  Black wins: " << blackWins << " (" << percent(blackWins, games) << ")"
+        << "  Draws: " << draws << " (" << percent(draws, games) << ")\n"
+        << "Human wins: " << humanWins << " (" << percent(humanWins, games) << ")\n"
+        << std::fixed << std::setprecision(1)
+        << "Average length: " << averagePlies << " plies, " << averageDurationSec << " s" << std::endl;
+    return out.str();
+}
+
+GameLog::GameLog(const std::string& path) : path(path) {}
+
+void GameLog::append(const GameRecord& game) {
+    append(std::vector<GameRecord>(1, game));
+}
+
+void GameLog::append(const std::vector<GameRecord>& games) {
+    std::uint64_t recordsEnd = 0;
+    std::size_t indexedGames = 0;
+    std::vector<GameIndexEntry> index = loadUnindexed(recordsEnd, indexedGames);
+    std::string indexPath = path + ".idx";
+    if (recordsEnd == 0) {
+        std::string header(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+        put(header, VERSION, 4);
+        createFile(path, header);
+        recordsEnd = HEADER_BYTES;
+        indexedGames = 0;
+    }
+    else {
+        // An earlier append may have been interrupted: cut off a torn record and whatever the
+        // index file holds past its last good entry. Readers never do this, they only skip it.
+        if (fileSize(path) != recordsEnd) truncateFile(path, recordsEnd);
+    }
+    std::uint64_t indexEnd = INDEX_HEADER_BYTES + indexedGames * ENTRY_BYTES;
+    if (indexedGames == 0) {
+        std::string header(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        put(header, VERSION, 4);
+        createFile(indexPath, header);
+    }
+    else if (fileSize(indexPath) != indexEnd) {
+        truncateFile(indexPath, indexEnd);
+    }
+
+    // Records first, then their entries: an index entry never points at an unwritten record.
+    std::string records;
+    for (const GameRecord& game : games) {
+        index.push_back(entryFor(game, recordsEnd + records.size()));
+        records += encodeRecord(game);
+    }
+    std::string entries;
+    for (const GameIndexEntry& e : index) {
+        entries += encodeEntry(e);
+    }
+    writeAt(path, recordsEnd, records);
+    writeAt(indexPath, indexEnd, entries);
+}
+
+std::vector<GameIndexEntry> GameLog::readIndex() const {
+    std::uint64_t recordsEnd = 0;
+    std::size_t indexedGames = 0;
+    return loadIndex(recordsEnd, indexedGames);
+}
+
+std::vector<GameIndexEntry> GameLog::loadIndex(std::uint64_t& recordsEnd, std::size_t& indexedGames) const {
+    recordsEnd = 0;
+    indexedGames = 0;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return {};
+    std::uint64_t size = fileSize(in);
+    std::string header = readBytes(in, 0, HEADER_BYTES);
+    if (header.size() != HEADER_BYTES || header.compare(0, 4, HEADER_MAGIC, 4) != 0) {
+        throw std::runtime_error(path + " is not a game log.");
+    }
+
+    // The whole entries of the index file up to the first one that is torn, fails its checksum
+    // or points outside the records; a log without an index file simply has none.
+    std::vector<GameIndexEntry> index;
+    std::ifstream indexIn(path + ".idx", std::ios::binary);
+    if (indexIn) {
+        std::uint64_t indexSize = fileSize(indexIn);
+        std::string indexHeader = readBytes(indexIn, 0, INDEX_HEADER_BYTES);
+        if (indexSize > INDEX_HEADER_BYTES && indexHeader.size() == INDEX_HEADER_BYTES &&
+            indexHeader.compare(0, 4, INDEX_MAGIC, 4) == 0) {
+            std::uint64_t count = (indexSize - INDEX_HEADER_BYTES) / ENTRY_BYTES;
+            std::string bytes = readBytes(indexIn, INDEX_HEADER_BYTES, static_cast<std::size_t>(count * ENTRY_BYTES));
+            index.reserve(bytes.size() / ENTRY_BYTES);
+            GameIndexEntry entry;
+            for (std::size_t pos = 0; pos < bytes.size(); pos += ENTRY_BYTES) {
+                if (!decodeEntry(bytes.substr(pos, ENTRY_BYTES), entry) || entry.offset >= size ||
+                    entry.offset < (index.empty() ? HEADER_BYTES : index.back().offset + 8)) {
+                    break;
+                }
+                index.push_back(entry);
+            }
+        }
+    }
+    // Records after the last indexed one (an append was interrupted, or one is in progress)
+    // are picked up by scanning them; the file is left alone, the next append() repairs it.
+    std::uint64_t scanFrom = HEADER_BYTES;
+    while (!index.empty() && (scanFrom = recordEnd(in, index.back().offset, size)) == 0) {
+        index.pop_back();
+    }
+    if (index.empty()) scanFrom = HEADER_BYTES;
+    indexedGames = index.size();
+    std::vector<GameIndexEntry> rest = scanRecords(scanFrom, recordsEnd);
+    index.insert(index.end(), rest.begin(), rest.end());
+    return index;
+}
+
+std::vector<GameIndexEntry> GameLog::loadUnindexed(std::uint64_t& recordsEnd, std::size_t& indexedGames) const {
+    // Appends only ever tear the end of the files, so an intact last entry whose record is
+    // whole vouches for the index; then only the records after it need a look.
+    std::ifstream in(path, std::ios::binary);
+    std::ifstream indexIn(path + ".idx", std::ios::binary);
+    if (in && indexIn) {
+        std::uint64_t size = fileSize(in);
+        std::uint64_t indexSize = fileSize(indexIn);
+        std::string header = readBytes(in, 0, HEADER_BYTES);
+        std::string indexHeader = readBytes(indexIn, 0, INDEX_HEADER_BYTES);
+        std::uint64_t count = indexSize >= INDEX_HEADER_BYTES ? (indexSize - INDEX_HEADER_BYTES) / ENTRY_BYTES : 0;
+        GameIndexEntry last;
+        std::uint64_t end = 0;
+        if (count > 0 && header.size() == HEADER_BYTES && header.compare(0, 4, HEADER_MAGIC, 4) == 0 &&
+            indexHeader.size() == INDEX_HEADER_BYTES && indexHeader.compare(0, 4, INDEX_MAGIC, 4) == 0 &&
+            decodeEntry(readBytes(indexIn, INDEX_HEADER_BYTES + (count - 1) * ENTRY_BYTES, ENTRY_BYTES), last) &&
+            last.offset >= HEADER_BYTES && (end = recordEnd(in, last.offset, size)) != 0) {
+            indexedGames = static_cast<std::size_t>(count);
+            return scanRecords(end, recordsEnd);
+        }
+    }
+    std::vector<GameIndexEntry> index = loadIndex(recordsEnd, indexedGames);
+    index.erase(index.begin(), index.begin() + indexedGames);
+    return index;
+}
+
+std::vector<GameIndexEntry> GameLog::scanRecords(std::uint64_t from, std::uint64_t& recordsEnd) const {
+    std::vector<GameIndexEntry> index;
+    std::ifstream in(path, std::ios::binary);
+    std::uint64_t size = fileSize(in);
+    std::uint64_t pos = from;
+    std::uint64_t end = 0;
+    while ((end = recordEnd(in, pos, size)) != 0) {
+        index.push_back(entryFor(decodeRecord(readBytes(in, pos + 4, static_cast<std::size_t>(end - pos - 8))), pos));
+        pos = end;
+    }
+    recordsEnd = pos;
+    return index;
+}
+
+GameRecord GameLog::read(const GameIndexEntry& entry) const {
+    std::ifstream in(path, std::ios::binary);
+    std::string lengthBytes = readBytes(in, entry.offset, 4);
+    if (lengthBytes.size() != 4) {
+        throw std::runtime_error("Game log index points past the end of " + path);
+    }
+    std::uint64_t length = Reader(lengthBytes).get(4);
+    std::string payload = readBytes(in, entry.offset + 4, static_cast<std::size_t>(length));
+    std::string sumBytes = readBytes(in, entry.offset + 4 + length, 4);
+    if (payload.size() != length || sumBytes.size() != 4 || checksum(payload) != Reader(sumBytes).get(4)) {
+        throw std::runtime_error("Corrupt game record in " + path);
+    }
+    return decodeRecord(payload);
+}
+
+GameSummary GameLog::summarize(const GameFilter& filter) const {
+    GameSummary s;
+    double plies = 0, seconds = 0;
+    for (const GameIndexEntry& e : readIndex()) {
+        if (!filter.matches(e)) continue;
+        if (s.games == 0 || e.startTime < s.firstStart) s.firstStart = e.startTime;
+        if (s.games == 0 || e.startTime > s.lastStart) s.lastStart = e.startTime;
+        ++s.games;
+        plies += e.plies;
+        seconds += e.durationSec;
+        if (e.result == GameResult::WHITE_WINS) ++s.whiteWins;
+        else if (e.result == GameResult::BLACK_WINS) ++s.blackWins;
+        else ++s.draws;
+        if ((e.result == GameResult::WHITE_WINS && e.humanColor == Color::WHITE) ||
+            (e.result == GameResult::BLACK_WINS && e.humanColor == Color::BLACK)) {
+            ++s.humanWins;
+        }
+    }
+    if (s.games) {
+        s.averagePlies = plies / s.games;
+        s.averageDurationSec = seconds / s.games;
+    }
+    return s;
+}
+
+void GameLog::exportText(std::ostream& out, const GameFilter& filter) const {
+    for (const GameIndexEntry& e : readIndex()) {
+        if (!filter.matches(e)) continue;
+        GameRecord game = read(e);
+        int plies = static_cast<int>(game.moves.size());
+        out << "[" << formatTime(game.endTime, "%Y-%m-%d %H:%M:%S") << "] " << gameResultText(game.result)
+            << " Moves: " << (plies + 1) / 2 << " full moves (" << plies << " plies)." << "\n  moves";
+        for (const JournalMove& m : game.moves) {
+            out << " " << moveText(m);
+        }
+        out << "\n";
+        const char* names[] = { "bot-think", "human-move", "render" };
+        const LatencyHistogram* histograms[] = { &game.thinkLatency, &game.moveLatency, &game.renderLatency };
+        for (int i = 0; i < 3; ++i) {
+            out << "  latency " << names[i] << " n=" << histograms[i]->count() << " " << histograms[i]->summary()
+                << " hist=" << histograms[i]->encode() << "\n";
+        }
+    }
+    out.flush();
+}
+
+int runGameLogTool(const std::vector<std::string>& args) {
+    const char* usage = "Usage: Chess gamelog stats|export [--since YYYY-MM-DD] [--until YYYY-MM-DD] "
+        "[--result white|black|draw] [--file PATH] [--out FILE]";
+    if (args.empty() || (args[0] != "stats" && args[0] != "export")) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    GameFilter filter;
+    std::string file = "game_log.bin";
+    std::string outFile;
+    for (size_t i = 1; i < args.size(); i += 2) {
+        const std::string& a = args[i];
+        if (i + 1 >= args.size()) {
+            std::cerr << "gamelog: missing value for " << a << std::endl;
+            return 1;
+        }
+        const std::string& v = args[i + 1];
+        bool ok = true;
+        if (a == "--since") ok = parseDate(v, filter.since);
+        else if (a == "--until") ok = parseDate(v, filter.until);
+        else if (a == "--result") {
+            if (v == "white") filter.result = static_cast<int>(GameResult::WHITE_WINS);
+            else if (v == "black") filter.result = static_cast<int>(GameResult::BLACK_WINS);
+            else if (v == "draw") filter.result = static_cast<int>(GameResult::DRAW);
+            else ok = false;
+        }
+        else if (a == "--file") file = v;
+        else if (a == "--out") outFile = v;
+        else {
+            std::cerr << "gamelog: unknown option " << a << "\n" << usage << std::endl;
+            return 1;
+        }
+        if (!ok) {
+            std::cerr << "gamelog: bad value for " << a << ": " << v << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        GameLog log(file);
+        if (args[0] == "stats") {
+            std::cout << log.summarize(filter).text();
+        }
+        else if (outFile.empty()) {
+            log.exportText(std::cout, filter);
+        }
+        else {
+            std::ofstream out(outFile);
+            if (!out) {
+                std::cerr << "gamelog: cannot write " << outFile << std::endl;
+                return 1;
+            }
+            log.exportText(out, filter);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "gamelog: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
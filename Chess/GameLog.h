@@ -0,0 +1,127 @@
+#ifndef GAME_LOG_H
+#define GAME_LOG_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include "Board.h"
+#include "GameJournal.h"
+#include "Histogram.h"
+
+enum class GameResult : std::uint8_t { WHITE_WINS, BLACK_WINS, DRAW };
+
+const char* gameResultText(GameResult result);  ///< "White wins by checkmate." style sentence.
+
+/**
+ * @struct GameRecord
+ * @brief Everything the game log keeps about one finished game.
+ */
+struct GameRecord {
+    std::int64_t startTime = 0;        ///< Seconds since the epoch.
+    std::int64_t endTime = 0;
+    GameResult result = GameResult::DRAW;
+    Color humanColor = Color::WHITE;
+    std::string startFen;              ///< Position the game started from.
+    std::vector<JournalMove> moves;
+    LatencyHistogram thinkLatency;     ///< Bot moves (see GameSession).
+    LatencyHistogram moveLatency;      ///< Validating and playing the human's moves.
+    LatencyHistogram renderLatency;    ///< Redrawing the board.
+};
+
+/**
+ * @struct GameIndexEntry
+ * @brief A game's entry in the index file: enough for the aggregate queries on its own.
+ */
+struct GameIndexEntry {
+    std::uint64_t offset = 0;          ///< Where the game's record starts.
+    std::int64_t startTime = 0;
+    std::uint32_t durationSec = 0;
+    std::uint16_t plies = 0;
+    GameResult result = GameResult::DRAW;
+    Color humanColor = Color::WHITE;
+};
+
+/**
+ * @struct GameFilter
+ * @brief Which games a query covers: a start-time range and optionally one result.
+ */
+struct GameFilter {
+    std::int64_t since = INT64_MIN;    ///< Games started at or after this time...
+    std::int64_t until = INT64_MAX;    ///< ...and before this one.
+    int result = -1;                   ///< A GameResult, or -1 for any.
+
+    bool matches(const GameIndexEntry& entry) const;
+};
+
+/**
+ * @struct GameSummary
+ * @brief Aggregates over the games a filter selects.
+ */
+struct GameSummary {
+    long long games = 0;
+    long long whiteWins = 0;
+    long long blackWins = 0;
+    long long draws = 0;
+    long long humanWins = 0;           ///< Games won by the human's side.
+    double averagePlies = 0;
+    double averageDurationSec = 0;
+    std::int64_t firstStart = 0;       ///< Earliest and latest start time (0 without games).
+    std::int64_t lastStart = 0;
+
+    std::string text() const;          ///< Multi-line report.
+};
+
+/**
+ * @class GameLog
+ * @brief Binary store of finished games with an index file beside it.
+ *
+ * The log is a header and one checksummed record per game (times, result, start position,
+ * moves, latency histograms); the index, the same path plus ".idx", holds one checksummed
+ * fixed-size entry per game. Queries on result, length and date read only the index, so they
+ * cost 28 bytes per game rather than a scan of every record; records are read only for
+ * export and the latency report. Both files only grow at the end, so appending a game writes
+ * its record and its entry and nothing else. Records the index lacks (e.g. after a crash
+ * during an append) are found by scanning the records after the last indexed one; queries
+ * do that in memory and the next append() repairs the files.
+ *
+ * All members throw std::runtime_error on I/O errors and malformed files.
+ */
+class GameLog {
+public:
+    explicit GameLog(const std::string& path);
+
+    void append(const GameRecord& game);
+    void append(const std::vector<GameRecord>& games);
+
+    std::vector<GameIndexEntry> readIndex() const;       ///< Empty if there is no file yet.
+    GameRecord read(const GameIndexEntry& entry) const;
+    GameSummary summarize(const GameFilter& filter) const;
+    /// The selected games as text: a result line, the moves and one line per latency histogram.
+    void exportText(std::ostream& out, const GameFilter& filter) const;
+
+private:
+    // Reads the index and where the records end; the first @p indexedGames entries came from
+    // the index file, the rest from scanning the records after them. Never modifies a file.
+    std::vector<GameIndexEntry> loadIndex(std::uint64_t& recordsEnd, std::size_t& indexedGames) const;
+    // What append() needs: the entries missing from the index file, without reading all of it.
+    std::vector<GameIndexEntry> loadUnindexed(std::uint64_t& recordsEnd, std::size_t& indexedGames) const;
+    std::vector<GameIndexEntry> scanRecords(std::uint64_t from, std::uint64_t& recordsEnd) const;
+
+    std::string path;
+};
+
+/**
+ * @brief Query or export the game log from the command line ("gamelog" mode).
+ * @param args Command-line arguments after the mode name.
+ * @return Process exit code.
+ *
+ *   gamelog stats  [filters]              Win rates, average length and duration.
+ *   gamelog export [filters] [--out FILE] The games as text (the old game_log.txt format plus moves).
+ *
+ * Filters: --since YYYY-MM-DD, --until YYYY-MM-DD (exclusive), --result white|black|draw.
+ * --file PATH reads another log than game_log.bin.
+ */
+int runGameLogTool(const std::vector<std::string>& args);
+
+#endif // GAME_LOG_H
@@ -0,0 +1,516 @@
+/**
+ * @file GameServer.cpp
+ * @brief Multi-game hosting: network thread, fair move queue and bot worker pool.
+ *
+ * Locking: sessionMutex guards the session table and queueMutex the move queue; the
+ * connections (LineServer) lock themselves. No thread holds two of these at once, and the
+ * journal (which has its own lock) is only called with none of them held. A session in the
+ * QUEUED state belongs to the worker that will answer it, so the network thread only touches
+ * IDLE sessions.
+ */
+#include "GameServer.h"
+#include "Bot.h"
+#include "Notation.h"
+#include "Histogram.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+namespace {
+    const std::size_t LATENCY_SAMPLES = 100000;
+    const char* const PIECE_LETTERS = "PNBRQK";
+
+    // "" while the game goes on, else how it ended for the side that just moved's opponent.
+    std::string gameStatus(const Board& board) {
+        Color side = board.currentPlayerColor;
+        if (!generateLegalMoves(board, side).empty()) return "";
+        return board.isPlayerInCheck(side) ? "checkmate" : "stalemate";
+    }
+
+    int clampOption(const std::string& value, int low, int high) {
+        return std::min(std::max(std::atoi(value.c_str()), low), high);
+    }
+
+    // The options of a "new" command; the journal keeps them in this form too.
+    void parseGameOptions(std::istream& in, std::uint8_t& botIsWhite, std::uint16_t& moveTimeMs, std::uint16_t& latencyMs) {
+        std::string word;
+        while (in >> word) {
+            if (word == "black") botIsWhite = 1;
+            else if (word == "white") botIsWhite = 0;
+            else if (word == "movetime" && in >> word) moveTimeMs = std::uint16_t(clampOption(word, 1, 60000));
+            else if (word == "latency" && in >> word) latencyMs = std::uint16_t(clampOption(word, 1, 60000));
+        }
+    }
+
+    std::string gameOptions(std::uint8_t botIsWhite, std::uint16_t moveTimeMs, std::uint16_t latencyMs) {
+        return std::string(botIsWhite ? "black" : "white") + " movetime " + std::to_string(moveTimeMs) +
+            " latency " + std::to_string(latencyMs);
+    }
+}
+
+CompactPosition CompactPosition::fromBoard(const Board& board) {
+    CompactPosition p;
+    for (int sq = 0; sq < 64; ++sq) {
+        Piece* piece = board.getPieceAt(sq % 8, sq / 8);
+        std::uint8_t code = 0;
+        if (piece) {
+            code = std::uint8_t(1 + static_cast<int>(piece->getType()) + (piece->getColor() == Color::BLACK ? 8 : 0));
+        }
+        if (sq % 2 == 0) p.squares[sq / 2] = code;
+        else p.squares[sq / 2] |= std::uint8_t(code << 4);
+    }
+    p.whiteToMove = board.currentPlayerColor == Color::WHITE;
+    return p;
+}
+
+void CompactPosition::toBoard(Board& board) const {
+    std::string fen;
+    for (int y = 0; y < 8; ++y) {
+        int empty = 0;
+        for (int x = 0; x < 8; ++x) {
+            int sq = y * 8 + x;
+            int code = (sq % 2 == 0) ? (squares[sq / 2] & 0x0F) : (squares[sq / 2] >> 4);
+            if (code == 0) {
+                ++empty;
+                continue;
+            }
+            if (empty) fen += char('0' + empty);
+            empty = 0;
+            char letter = PIECE_LETTERS[(code & 7) - 1];
+            fen += (code & 8) ? char(std::tolower(letter)) : letter;
+        }
+        if (empty) fen += char('0' + empty);
+        if (y < 7) fen += '/';
+    }
+    fen += whiteToMove ? " w" : " b";
+    board.loadFromFen(fen);
+}
+
+bool GameServer::FairQueue::laterDeadline(const Job& a, const Job& b) {
+    return a.deadline > b.deadline;
+}
+
+void GameServer::FairQueue::push(std::uint32_t connection, const Job& job) {
+    std::vector<Job>& heap = perConnection[connection];
+    if (heap.empty()) turn.push_back(connection);
+    heap.push_back(job);
+    std::push_heap(heap.begin(), heap.end(), laterDeadline);
+    ++size;
+}
+
+bool GameServer::FairQueue::pop(Job& job) {
+    while (!turn.empty()) {
+        std::uint32_t connection = turn.front();
+        turn.pop_front();
+        auto it = perConnection.find(connection);
+        if (it == perConnection.end() || it->second.empty()) continue;
+        std::vector<Job>& heap = it->second;
+        std::pop_heap(heap.begin(), heap.end(), laterDeadline);
+        job = heap.back();
+        heap.pop_back();
+        --size;
+        if (heap.empty()) perConnection.erase(it);
+        else turn.push_back(connection);   // back of the line until every other connection had a turn
+        return true;
+    }
+    return false;
+}
+
+GameServer::GameServer(const ServerOptions& opts)
+    : options(opts) {
+    if (options.workers <= 0) {
+        options.workers = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+}
+
+GameServer::~GameServer() {
+    stop();
+}
+
+bool GameServer::start(std::string& error) {
+    if (!initSockets()) {
+        error = "socket library initialisation failed";
+        return false;
+    }
+    if (!options.journalPath.empty() && !recoverGames(error)) {
+        return false;
+    }
+    listener = listenLoopback(options.port, port);
+    if (listener == INVALID_SOCKET_HANDLE) {
+        error = "cannot listen on 127.0.0.1:" + std::to_string(options.port);
+        return false;
+    }
+    running = true;
+    for (int i = 0; i < options.workers; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+    networkThread = std::thread([this] { networkLoop(); });
+    return true;
+}
+
+void GameServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    queueSignal.notify_all();
+    if (networkThread.joinable()) networkThread.join();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    journal.close();
+    connections.closeAll();
+    closeSocket(listener);
+}
+
+void GameServer::wait() {
+    if (networkThread.joinable()) networkThread.join();
+}
+
+int GameServer::getPort() const {
+    return port;
+}
+
+int GameServer::getWorkerCount() const {
+    return options.workers;
+}
+
+int GameServer::getResumedGames() const {
+    return resumedGames;
+}
+
+bool GameServer::recoverGames(std::string& error) {
+    std::vector<JournalGame> games;
+    if (!journal.resume(options.journalPath, games, error)) {
+        return false;
+    }
+    Board board;
+    for (const JournalGame& game : games) {
+        try {
+            game.replay(board);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "serve: not resuming game " << game.id << ": " << e.what() << std::endl;
+            journal.endGame(game.id);
+            continue;
+        }
+        Session session;
+        session.position = CompactPosition::fromBoard(board);
+        session.botIsWhite = 0;
+        session.moveTimeMs = std::uint16_t(options.moveTimeMs);
+        session.latencyMs = std::uint16_t(options.latencyMs);
+        std::istringstream info(game.info);
+        parseGameOptions(info, session.botIsWhite, session.moveTimeMs, session.latencyMs);
+        // A crash between a game's last move and its end record leaves a finished game here.
+        session.state = gameStatus(board).empty() ? SessionState::IDLE : SessionState::OVER;
+        session.plies = std::uint16_t(game.moves.size());
+        session.connection = 0;
+        sessions[game.id] = session;
+        nextGame = std::max(nextGame, game.id + 1);
+        ++resumedGames;
+    }
+    return true;
+}
+
+void GameServer::networkLoop() {
+    connections.run(listener, running,
+        [this](std::uint32_t connection, const std::string& line) { handleLine(connection, line); },
+        [this](std::uint32_t connection) { dropConnection(connection); },
+        [this] { journal.syncIfDue(); });
+}
+
+void GameServer::handleLine(std::uint32_t connection, const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    if (!(in >> command)) return;
+
+    if (command == "new") {
+        Session session;
+        Board board;
+        session.position = CompactPosition::fromBoard(board);
+        session.botIsWhite = 0;
+        session.state = SessionState::IDLE;
+        session.plies = 0;
+        session.moveTimeMs = std::uint16_t(options.moveTimeMs);
+        session.latencyMs = std::uint16_t(options.latencyMs);
+        session.connection = connection;
+        parseGameOptions(in, session.botIsWhite, session.moveTimeMs, session.latencyMs);
+        std::uint32_t game;
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            game = nextGame++;
+            if (session.botIsWhite) session.state = SessionState::QUEUED;
+            sessions[game] = session;
+        }
+        journal.beginGame(game, board.toFen(), gameOptions(session.botIsWhite, session.moveTimeMs, session.latencyMs));
+        reply(connection, "game " + std::to_string(game));
+        if (session.botIsWhite) enqueueBotMove(game, session);
+        return;
+    }
+    if (command == "stats") {
+        reply(connection, statsLine());
+        return;
+    }
+    if (command == "quit") {
+        dropConnection(connection);
+        return;
+    }
+
+    std::uint32_t game = 0;
+    if (!(in >> game)) {
+        reply(connection, "error 0 unknown or incomplete command: " + line);
+        return;
+    }
+    std::string gameText = std::to_string(game);
+    Session session;
+    if (command == "resume") {
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            auto it = sessions.find(game);
+            if (it == sessions.end() || it->second.connection != 0) {
+                reply(connection, "error " + gameText + " no such game");
+                return;
+            }
+            it->second.connection = connection;
+            bool botToMove = it->second.position.whiteToMove == it->second.botIsWhite;
+            if (botToMove && it->second.state == SessionState::IDLE) it->second.state = SessionState::QUEUED;
+            session = it->second;
+        }
+        Board board;
+        session.position.toBoard(board);
+        reply(connection, "resumed " + gameText + " " + board.toFen());
+        if (session.state == SessionState::QUEUED) enqueueBotMove(game, session);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        auto it = sessions.find(game);
+        if (it == sessions.end() || it->second.connection != connection) {
+            reply(connection, "error " + gameText + " no such game");
+            return;
+        }
+        session = it->second;
+        if (command == "close") {
+            // A queued move is simply dropped by the worker when it finds no session.
+            sessions.erase(it);
+        }
+    }
+
+    if (command == "close") {
+        journal.endGame(game);
+        reply(connection, "closed " + gameText);
+    }
+    else if (command == "fen") {
+        Board board;
+        session.position.toBoard(board);
+        reply(connection, "fen " + gameText + " " + board.toFen());
+    }
+    else if (command == "move") {
+        std::string text;
+        in >> text;
+        if (session.state != SessionState::IDLE) {
+            reply(connection, "error " + gameText + (session.state == SessionState::OVER ? " game is over" : " bot is thinking"));
+            return;
+        }
+        Board board;
+        session.position.toBoard(board);
+        PackedMove move = parseMove(board, text);
+        if (!move) {
+            reply(connection, "error " + gameText + " illegal move " + text);
+            return;
+        }
+        Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+        board.applyMove(piece->getId(), packedToX(move), packedToY(move));
+        std::string status = gameStatus(board);
+        journal.recordLastMove(game, board);
+        if (!status.empty()) journal.endGame(game);
+        session.position = CompactPosition::fromBoard(board);
+        ++session.plies;
+        session.state = status.empty() ? SessionState::QUEUED : SessionState::OVER;
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            auto it = sessions.find(game);
+            if (it == sessions.end()) return;
+            it->second = session;
+        }
+        if (status.empty()) enqueueBotMove(game, session);
+        else reply(connection, "gameover " + gameText + " " + status);
+    }
+    else {
+        reply(connection, "error " + gameText + " unknown command " + command);
+    }
+}
+
+void GameServer::enqueueBotMove(std::uint32_t game, const Session& session) {
+    Job job;
+    job.game = game;
+    job.arrived = std::chrono::steady_clock::now();
+    job.deadline = job.arrived + std::chrono::milliseconds(session.latencyMs);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push(session.connection, job);
+    }
+    queueSignal.notify_one();
+}
+
+void GameServer::workerLoop() {
+    Bot bot(Color::WHITE);   // the default NNUE network, if any, is shared by all workers
+    bot.setHashSize(options.hashMb);
+    Board board;
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueSignal.wait(lock, [this] { return !running || queue.size > 0; });
+            if (!running) return;
+            queue.pop(job);
+        }
+        Session session;
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            auto it = sessions.find(job.game);
+            if (it == sessions.end()) continue;
+            session = it->second;
+        }
+
+        // A move picked up late only gets what is left of its latency target.
+        auto now = std::chrono::steady_clock::now();
+        long long left = std::chrono::duration_cast<std::chrono::milliseconds>(job.deadline - now).count() - 2;
+        SearchLimits limits;
+        limits.moveTimeMs = int(std::min<long long>(std::max<long long>(left, 1), session.moveTimeMs));
+        session.position.toBoard(board);
+        bot.setColor(board.currentPlayerColor);
+        bot.setSearchLimits(limits);
+        PackedMove best = bot.think(board);
+
+        std::string gameText = std::to_string(job.game);
+        std::string line;
+        if (!best) {
+            // Only reachable if the position was already over; report it as such.
+            line = "gameover " + gameText + " " + (board.isPlayerInCheck(board.currentPlayerColor) ? "checkmate" : "stalemate");
+            session.state = SessionState::OVER;
+            journal.endGame(job.game);
+        }
+        else {
+            line = "botmove " + gameText + " " + moveToUci(board, best);
+            Piece* piece = board.getPieceAt(packedFromX(best), packedFromY(best));
+            board.applyMove(piece->getId(), packedToX(best), packedToY(best));
+            std::string status = gameStatus(board);
+            journal.recordLastMove(job.game, board);
+            if (!status.empty()) {
+                line += " " + status;
+                journal.endGame(job.game);
+            }
+            session.position = CompactPosition::fromBoard(board);
+            ++session.plies;
+            session.state = status.empty() ? SessionState::IDLE : SessionState::OVER;
+        }
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            auto it = sessions.find(job.game);
+            if (it == sessions.end()) continue;   // closed while thinking
+            session.connection = it->second.connection;   // detached or resumed while thinking
+            it->second = session;
+        }
+        reply(session.connection, line);
+
+        auto done = std::chrono::steady_clock::now();
+        recordLatency(std::chrono::duration_cast<std::chrono::microseconds>(done - job.arrived).count());
+        if (done > job.deadline) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ++deadlineMisses;
+        }
+    }
+}
+
+void GameServer::dropConnection(std::uint32_t id) {
+    if (!connections.close(id)) return;
+    // With a journal the games are kept for the client to resume, as after a restart.
+    bool detach = journal.isOpen();
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    for (auto it = sessions.begin(); it != sessions.end();) {
+        if (it->second.connection != id) ++it;
+        else if (detach) (it++)->second.connection = 0;
+        else it = sessions.erase(it);
+    }
+}
+
+void GameServer::reply(std::uint32_t id, const std::string& line) {
+    connections.send(id, line);
+}
+
+void GameServer::recordLatency(long long micros) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    ++botMoves;
+    if (latencies.size() < LATENCY_SAMPLES) {
+        latencies.push_back(micros);
+    }
+    else {
+        latencies[latencyNext] = micros;
+        latencyNext = (latencyNext + 1) % LATENCY_SAMPLES;
+    }
+}
+
+std::string GameServer::statsLine() {
+    std::size_t sessionCount, queued;
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        sessionCount = sessions.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queued = queue.size;
+    }
+    std::vector<long long> samples;
+    long long moves, misses;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        samples = latencies;
+        moves = botMoves;
+        misses = deadlineMisses;
+    }
+    std::ostringstream out;
+    out << "stats sessions " << sessionCount << " queued " << queued << " workers " << options.workers
+        << " botmoves " << moves << " deadlinemisses " << misses
+        << " p50us " << samplePercentile(samples, 0.50) << " p99us " << samplePercentile(samples, 0.99)
+        << " sessionbytes " << sizeof(Session);
+    return out.str();
+}
+
+int runGameServer(const std::vector<std::string>& args) {
+    ServerOptions options;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        const std::string& a = args[i];
+        const std::string& v = args[i + 1];
+        if (a == "--port") options.port = std::atoi(v.c_str());
+        else if (a == "--workers") options.workers = std::atoi(v.c_str());
+        else if (a == "--hash") options.hashMb = std::size_t(std::max(1, std::atoi(v.c_str())));
+        else if (a == "--movetime") options.moveTimeMs = clampOption(v, 1, 60000);
+        else if (a == "--latency") options.latencyMs = clampOption(v, 1, 60000);
+        else if (a == "--journal") options.journalPath = v;
+        else {
+            std::cerr << "serve: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+    if (args.size() % 2 != 0) {
+        std::cerr << "serve: missing value for " << args.back() << std::endl;
+        return 1;
+    }
+    GameServer server(options);
+    std::string error;
+    if (!server.start(error)) {
+        std::cerr << "serve: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Serving games on 127.0.0.1:" << server.getPort() << " with "
+        << server.getWorkerCount() << " bot workers" << std::endl;
+    if (!options.journalPath.empty()) {
+        std::cout << "Journaling to " << options.journalPath << "; " << server.getResumedGames()
+            << " unfinished games resumed" << std::endl;
+    }
+    server.wait();
+    return 0;
+}
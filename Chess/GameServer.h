@@ -0,0 +1,158 @@
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Board.h"
+#include "Socket.h"
+#include "GameJournal.h"
+
+struct ServerOptions {
+    int port = 7878;                ///< Loopback TCP port (0 = any free port).
+    int workers = 0;                ///< Bot threads (0 = hardware threads).
+    std::size_t hashMb = 16;        ///< Transposition table per worker.
+    int moveTimeMs = 100;           ///< Default bot think time per move.
+    int latencyMs = 250;            ///< Default target from a human move to the bot's reply.
+    std::string journalPath;        ///< Journal of every game's moves ("" = none); its unfinished games are resumed.
+};
+
+/**
+ * @struct CompactPosition
+ * @brief A position in 33 bytes: two squares per byte (0 = empty, 1-6 White P N B R Q K,
+ *        9-14 Black) and the side to move. Rebuilt into a Board only while a move is handled.
+ */
+struct CompactPosition {
+    std::uint8_t squares[32];
+    std::uint8_t whiteToMove;
+
+    static CompactPosition fromBoard(const Board& board);
+    void toBoard(Board& board) const;
+};
+
+/**
+ * @class GameServer
+ * @brief Hosts many human-vs-bot games in one process over a line-based loopback protocol.
+ *
+ * One network thread multiplexes all connections and answers cheap commands inline. Bot
+ * moves go to a shared pool of worker threads, each owning one Bot. Pending moves are queued
+ * per connection and the connections are served round robin, so one client with many games
+ * cannot starve the others; within a connection the earliest deadline goes first. A move's
+ * deadline is its arrival time plus the game's latency target, and a worker that picks up a
+ * late move shortens its think time to what is left of the target.
+ *
+ * Protocol (one line each way; replies to a game may arrive in any order):
+ *   new [white|black] [movetime MS] [latency MS]  -> game ID   (the human's colour; the bot
+ *                                                               replies at once if it is White)
+ *   move ID MOVE        (SAN or e2e4)             -> botmove ID MOVE [checkmate|stalemate],
+ *                                                    or gameover ID RESULT, or error ID REASON
+ *   fen ID                                        -> fen ID FEN
+ *   resume ID                                     -> resumed ID FEN   (take over a game recovered
+ *                                                                       from the journal)
+ *   close ID                                      -> closed ID
+ *   stats                                         -> stats key value ...
+ *   quit                                          -> closes the connection
+ *
+ * The NNUE network, when loaded, is shared read-only by every worker. Games are held as
+ * CompactPosition-based sessions of a few dozen bytes, not as Boards and Bots.
+ *
+ * With a journal, every move is appended to it before it is answered, and the fsyncs of all
+ * games are batched. On start the unfinished games in the journal are replayed; they wait,
+ * detached from any connection, until a client resumes them; so do the games of a connection
+ * that drops. Games that are closed or end are marked finished and dropped from the journal
+ * at the next start.
+ */
+class GameServer {
+public:
+    explicit GameServer(const ServerOptions& options);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    bool start(std::string& error);   ///< Bind and start the network and worker threads.
+    void stop();                      ///< Close every connection and join the threads.
+    void wait();                      ///< Block until the network thread ends.
+    int getPort() const;
+    int getWorkerCount() const;
+    int getResumedGames() const;      ///< Unfinished games recovered from the journal by start().
+
+private:
+    enum class SessionState : std::uint8_t { IDLE, QUEUED, OVER };
+
+    struct Session {
+        CompactPosition position;
+        std::uint8_t botIsWhite;
+        SessionState state;
+        std::uint16_t plies;
+        std::uint16_t moveTimeMs;
+        std::uint16_t latencyMs;
+        std::uint32_t connection;      // 0 = recovered from the journal and not yet resumed
+    };
+
+    struct Job {
+        std::uint32_t game;
+        std::chrono::steady_clock::time_point arrived;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // Deadline-ordered jobs per connection, connections served round robin.
+    struct FairQueue {
+        std::map<std::uint32_t, std::vector<Job>> perConnection;   // min-heaps on deadline
+        std::deque<std::uint32_t> turn;
+        std::size_t size{ 0 };
+
+        void push(std::uint32_t connection, const Job& job);
+        bool pop(Job& job);
+        static bool laterDeadline(const Job& a, const Job& b);
+    };
+
+    void networkLoop();
+    void workerLoop();
+    bool recoverGames(std::string& error);
+    void handleLine(std::uint32_t connection, const std::string& line);
+    void dropConnection(std::uint32_t connection);
+    void reply(std::uint32_t connection, const std::string& line);
+    void enqueueBotMove(std::uint32_t game, const Session& session);
+    void recordLatency(long long micros);
+    std::string statsLine();
+
+    ServerOptions options;
+    SocketHandle listener{ INVALID_SOCKET_HANDLE };
+    int port{ 0 };
+    std::atomic<bool> running{ false };
+    std::thread networkThread;
+    std::vector<std::thread> workers;
+
+    LineServer connections;
+
+    std::mutex sessionMutex;
+    std::unordered_map<std::uint32_t, Session> sessions;
+    std::uint32_t nextGame{ 1 };
+    int resumedGames{ 0 };
+
+    GameJournal journal;
+
+    std::mutex queueMutex;
+    std::condition_variable queueSignal;
+    FairQueue queue;
+
+    std::mutex statsMutex;
+    std::vector<long long> latencies;          ///< Recent reply latencies in microseconds (ring).
+    std::size_t latencyNext{ 0 };
+    long long botMoves{ 0 };
+    long long deadlineMisses{ 0 };
+};
+
+int runGameServer(const std::vector<std::string>& args);   ///< "serve" mode.
+
+#endif // GAME_SERVER_H
@@ -0,0 +1,110 @@
+/**
+ * @file Histogram.cpp
+ * @brief Log-linear bucketing, percentiles and the text encoding of LatencyHistogram, and
+ *        percentiles of raw samples.
+ */
+#include "Histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+int LatencyHistogram::bucketOf(long long micros) {
+    if (micros < 2 * SUB_BUCKETS) return micros < 0 ? 0 : static_cast<int>(micros);
+    int exponent = 63;
+    while (!(static_cast<unsigned long long>(micros) >> exponent)) {
+        --exponent;
+    }
+    int shift = exponent - 5;   // leaves the top 6 bits: 32..63
+    int index = 2 * SUB_BUCKETS + (exponent - 6) * SUB_BUCKETS + static_cast<int>((micros >> shift) - SUB_BUCKETS);
+    return std::min(index, BUCKETS - 1);
+}
+
+long long LatencyHistogram::bucketTop(int index) {
+    if (index < 2 * SUB_BUCKETS) return index;
+    int exponent = 6 + (index - 2 * SUB_BUCKETS) / SUB_BUCKETS;
+    int sub = (index - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    int shift = exponent - 5;
+    return (static_cast<long long>(SUB_BUCKETS + sub) << shift) + (1LL << shift) - 1;
+}
+
+void LatencyHistogram::record(long long micros) {
+    ++counts[bucketOf(micros)];
+    ++total;
+    maxValue = std::max(maxValue, micros);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+void LatencyHistogram::clear() {
+    counts.fill(0);
+    total = 0;
+    maxValue = 0;
+}
+
+long long LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    long long rank = std::max(1LL, static_cast<long long>(std::ceil(p * total)));
+    long long seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(bucketTop(i), maxValue);
+    }
+    return maxValue;
+}
+
+std::string LatencyHistogram::summary() const {
+    char text[160];
+    std::snprintf(text, sizeof(text), "p50=%.3fms p90=%.3fms p99=%.3fms max=%.3fms",
+        percentile(0.50) / 1000.0, percentile(0.90) / 1000.0, percentile(0.99) / 1000.0, maxValue / 1000.0);
+    return text;
+}
+
+std::string LatencyHistogram::encode() const {
+    std::ostringstream out;
+    bool first = true;
+    for (int i = 0; i < BUCKETS; ++i) {
+        if (!counts[i]) continue;
+        out << (first ? "" : ",") << i << ":" << counts[i];
+        first = false;
+    }
+    out << ";" << maxValue;
+    return out.str();
+}
+
+bool LatencyHistogram::decode(const std::string& text) {
+    clear();
+    std::istringstream in(text);
+    char separator = ',';
+    while (separator == ',' && in.peek() != ';') {
+        long long index = -1, count = 0;
+        char colon = 0;
+        if (!(in >> index >> colon >> count) || colon != ':' || index < 0 || index >= BUCKETS || count < 0) {
+            clear();
+            return false;
+        }
+        counts[index] += static_cast<std::uint32_t>(count);
+        total += count;
+        if (!(in >> separator)) separator = 0;
+        else if (separator == ';') in.unget();
+    }
+    char semicolon = 0;
+    if (!(in >> semicolon >> maxValue) || semicolon != ';') {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+long long samplePercentile(std::vector<long long> samples, double p) {
+    if (samples.empty()) return 0;
+    std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(p * (samples.size() - 1) + 0.5));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
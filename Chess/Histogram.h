@@ -0,0 +1,55 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style histogram of latencies in microseconds: fixed memory, about 3% precision.
+ *
+ * Values below 64 us have a bucket each; above that every power of two is split into 32
+ * buckets, so a bucket is never wider than 1/32 of the values in it, from 1 us to beyond an
+ * hour. Percentiles are reported as the upper end of their bucket (never optimistic) and the
+ * maximum exactly. Histograms of many games merge by adding bucket counts, which is what the
+ * text encoding is for.
+ */
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKETS = 32;
+    static const int BUCKETS = 2 * SUB_BUCKETS + 36 * SUB_BUCKETS;  ///< Exact 0-63, then 2^6 to 2^42 us.
+
+    void record(long long micros);
+    void merge(const LatencyHistogram& other);
+    void clear();
+
+    long long count() const { return total; }
+    long long max() const { return maxValue; }
+    long long percentile(double p) const;  ///< p in [0, 1]; 0 for an empty histogram.
+
+    /// "p50=1.234ms p90=... p99=... max=..." for logs and reports.
+    std::string summary() const;
+
+    /// Non-empty buckets as "INDEX:COUNT,..." followed by ";max" (round-trips through decode()).
+    std::string encode() const;
+    bool decode(const std::string& text);  ///< Replace the contents; false on malformed text.
+
+private:
+    static int bucketOf(long long micros);
+    static long long bucketTop(int index);  ///< Largest value that falls into the bucket.
+
+    std::array<std::uint32_t, BUCKETS> counts{};
+    long long total = 0;
+    long long maxValue = 0;
+};
+
+/**
+ * @brief Nearest-rank percentile of raw samples (p in [0, 1]); 0 when there are none.
+ *
+ * For the servers' and load generators' recent latency samples, where exact values are kept.
+ */
+long long samplePercentile(std::vector<long long> samples, double p);
+
+#endif // HISTOGRAM_H
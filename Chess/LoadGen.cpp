@@ -0,0 +1,294 @@
+/**
+ * @file LoadGen.cpp
+ * @brief Load generator for the game server: many scripted "humans" over a few connections.
+ *
+ * Each client thread drives its share of the games over one connection. It keeps a local
+ * Board per game to pick random legal moves and to follow the bot's replies, and it only
+ * sends a game's next move after that game's reply arrived and its think pause is over.
+ */
+#include "LoadGen.h"
+#include "GameServer.h"
+#include "Notation.h"
+#include "Socket.h"
+#include "Histogram.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    struct LoadOptions {
+        int port = 0;
+        int workers = 0;
+        int games = 1000;
+        int clients = 4;
+        int moves = 20;
+        int thinkMs = 1000;
+        int moveTimeMs = 20;
+        int latencyMs = 250;
+        int ramp = 0;
+    };
+
+    struct ClientGame {
+        std::uint32_t id = 0;
+        Board board;
+        int movesLeft = 0;
+        bool waiting = false;
+        bool done = false;
+        Clock::time_point sentAt;
+        Clock::time_point nextMove;
+    };
+
+    struct ClientStats {
+        std::vector<long long> latenciesUs;
+        int errors = 0;
+        bool connected = false;
+    };
+
+    struct RoundResult {
+        std::vector<long long> latenciesUs; ///< Every bot reply of the round, sorted.
+        int errors = 0;
+        double seconds = 0;
+    };
+
+    bool readReply(LineReader& reader, std::vector<std::string>& pending, std::string& line) {
+        while (pending.empty()) {
+            if (!reader.readLines(pending)) return false;
+        }
+        line = pending.front();
+        pending.erase(pending.begin());
+        return true;
+    }
+
+    void runClient(const LoadOptions& o, int gameCount, unsigned seed, ClientStats& stats) {
+        SocketHandle socket = connectLoopback(o.port);
+        if (socket == INVALID_SOCKET_HANDLE) return;
+        stats.connected = true;
+        LineReader reader(socket);
+        std::vector<std::string> pending;
+        std::mt19937 rng(seed);
+
+        // Open every game first; "new" replies come back in order.
+        std::string request;
+        for (int i = 0; i < gameCount; ++i) {
+            request += "new white movetime " + std::to_string(o.moveTimeMs) + " latency " + std::to_string(o.latencyMs) + "\n";
+        }
+        sendAll(socket, request);
+        std::vector<ClientGame> games(gameCount);
+        std::unordered_map<std::uint32_t, size_t> index;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < gameCount; ++i) {
+            std::string line;
+            if (!readReply(reader, pending, line)) {
+                closeSocket(socket);
+                return;
+            }
+            std::istringstream in(line);
+            std::string word;
+            in >> word >> games[i].id;
+            index[games[i].id] = size_t(i);
+            games[i].movesLeft = o.moves;
+            // Spread the first moves over one think period so the load doesn't arrive in lockstep.
+            games[i].nextMove = start + std::chrono::milliseconds(o.thinkMs > 0 ? rng() % o.thinkMs : 0);
+        }
+
+        int active = gameCount;
+        std::vector<SocketHandle> sockets(1, socket);
+        std::vector<bool> readable;
+        while (active > 0) {
+            Clock::time_point now = Clock::now();
+            Clock::time_point wake = now + std::chrono::milliseconds(100);
+            request.clear();
+            for (ClientGame& g : games) {
+                if (g.done || g.waiting) continue;
+                if (g.nextMove > now) {
+                    wake = std::min(wake, g.nextMove);
+                    continue;
+                }
+                std::vector<PackedMove> legal = generateLegalMoves(g.board, g.board.currentPlayerColor);
+                if (legal.empty() || g.movesLeft == 0) {
+                    g.done = true;
+                    --active;
+                    request += "close " + std::to_string(g.id) + "\n";
+                    continue;
+                }
+                PackedMove move = legal[rng() % legal.size()];
+                Piece* piece = g.board.getPieceAt(packedFromX(move), packedFromY(move));
+                request += "move " + std::to_string(g.id) + " " + packedMoveToString(move) + "\n";
+                g.board.applyMove(piece->getId(), packedToX(move), packedToY(move));
+                g.waiting = true;
+                g.sentAt = now;
+            }
+            if (!request.empty() && !sendAll(socket, request)) break;
+
+            int timeout = int(std::chrono::duration_cast<std::chrono::milliseconds>(wake - Clock::now()).count());
+            if (pending.empty() && pollReadable(sockets, readable, std::max(timeout, 0)) <= 0) continue;
+            if (pending.empty() && !reader.readLines(pending)) break;
+
+            Clock::time_point received = Clock::now();
+            for (const std::string& line : pending) {
+                std::istringstream in(line);
+                std::string kind, move, status;
+                std::uint32_t id = 0;
+                in >> kind >> id;
+                auto it = index.find(id);
+                if (it == index.end()) continue;
+                ClientGame& g = games[it->second];
+                if (kind == "botmove") {
+                    in >> move >> status;
+                    stats.latenciesUs.push_back(
+                        std::chrono::duration_cast<std::chrono::microseconds>(received - g.sentAt).count());
+                    PackedMove reply = parseMove(g.board, move);
+                    Piece* piece = reply ? g.board.getPieceAt(packedFromX(reply), packedFromY(reply)) : nullptr;
+                    if (piece) g.board.applyMove(piece->getId(), packedToX(reply), packedToY(reply));
+                    g.waiting = false;
+                    --g.movesLeft;
+                    g.nextMove = received + std::chrono::milliseconds(o.thinkMs);
+                    if (!status.empty() || !piece) g.movesLeft = 0;
+                }
+                else if (kind == "gameover" || kind == "error") {
+                    if (kind == "error") ++stats.errors;
+                    if (!g.done) {
+                        g.done = true;
+                        --active;
+                        sendAll(socket, "close " + std::to_string(id) + "\n");
+                    }
+                }
+            }
+            pending.clear();
+        }
+        sendAll(socket, "quit\n");
+        closeSocket(socket);
+    }
+
+    std::string queryStats(int port) {
+        SocketHandle socket = connectLoopback(port);
+        if (socket == INVALID_SOCKET_HANDLE) return "";
+        sendAll(socket, "stats\n");
+        LineReader reader(socket);
+        std::vector<std::string> pending;
+        std::string line;
+        readReply(reader, pending, line);
+        closeSocket(socket);
+        return line;
+    }
+
+    /// Plays @p games sessions split over the client connections; false if none could connect.
+    bool runRound(const LoadOptions& o, int games, RoundResult& result) {
+        std::vector<ClientStats> stats(o.clients);
+        std::vector<std::thread> threads;
+        Clock::time_point start = Clock::now();
+        for (int c = 0; c < o.clients; ++c) {
+            int share = games / o.clients + (c < games % o.clients ? 1 : 0);
+            threads.emplace_back(runClient, std::cref(o), share, 12345u + unsigned(c), std::ref(stats[c]));
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        int connected = 0;
+        for (const ClientStats& s : stats) {
+            result.latenciesUs.insert(result.latenciesUs.end(), s.latenciesUs.begin(), s.latenciesUs.end());
+            result.errors += s.errors;
+            connected += s.connected ? 1 : 0;
+        }
+        std::sort(result.latenciesUs.begin(), result.latenciesUs.end());
+        return connected > 0;
+    }
+}
+
+int runLoadGenerator(const std::vector<std::string>& args) {
+    LoadOptions o;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        const std::string& a = args[i];
+        int v = std::atoi(args[i + 1].c_str());
+        if (a == "--port") o.port = v;
+        else if (a == "--workers") o.workers = v;
+        else if (a == "--games") o.games = std::max(1, v);
+        else if (a == "--clients") o.clients = std::max(1, v);
+        else if (a == "--moves") o.moves = std::max(1, v);
+        else if (a == "--think") o.thinkMs = std::max(0, v);
+        else if (a == "--movetime") o.moveTimeMs = std::max(1, v);
+        else if (a == "--latency") o.latencyMs = std::max(1, v);
+        else if (a == "--ramp") o.ramp = std::max(0, v);
+        else {
+            std::cerr << "loadgen: unknown option " << a << std::endl;
+            return 1;
+        }
+    }
+    if (args.size() % 2 != 0) {
+        std::cerr << "loadgen: missing value for " << args.back() << std::endl;
+        return 1;
+    }
+    if (!initSockets()) {
+        std::cerr << "loadgen: socket library initialisation failed" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<GameServer> server;
+    if (o.port == 0) {
+        ServerOptions serverOptions;
+        serverOptions.port = 0;
+        serverOptions.workers = o.workers;
+        server.reset(new GameServer(serverOptions));
+        std::string error;
+        if (!server->start(error)) {
+            std::cerr << "loadgen: " << error << std::endl;
+            return 1;
+        }
+        o.port = server->getPort();
+    }
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Load: " << o.games << " sessions over " << o.clients << " connections, " << o.moves
+        << " moves each, think " << o.thinkMs << " ms, bot " << o.moveTimeMs << " ms/move, latency target "
+        << o.latencyMs << " ms, server 127.0.0.1:" << o.port << std::endl;
+
+    // Without --ramp this is one round at the offered load. With it, --games grows by the step
+    // after every round whose p99 met the target, and the last such round is the capacity.
+    int passing = 0;
+    for (int games = o.games; ; games += o.ramp) {
+        if (o.ramp > 0) std::cout << "Round: " << games << " sessions" << std::endl;
+        RoundResult round;
+        if (!runRound(o, games, round)) {
+            std::cerr << "loadgen: cannot connect to 127.0.0.1:" << o.port << std::endl;
+            if (server) server->stop();
+            return 1;
+        }
+        const std::vector<long long>& all = round.latenciesUs;
+        long long p99 = samplePercentile(all, 0.99);
+        bool within = p99 <= o.latencyMs * 1000LL;
+        std::cout << std::fixed << std::setprecision(1)
+            << "Bot moves " << all.size() << " in " << round.seconds << " s ("
+            << (round.seconds > 0 ? all.size() / round.seconds : 0.0) << " moves/s), errors " << round.errors << "\n"
+            << "Latency ms: p50 " << samplePercentile(all, 0.50) / 1000.0 << "  p90 " << samplePercentile(all, 0.90) / 1000.0
+            << "  p99 " << p99 / 1000.0 << "  max " << (all.empty() ? 0.0 : all.back() / 1000.0) << "\n"
+            << "Offered load: " << double(games) / cores << " sessions per core (" << games << " sessions, " << cores
+            << " cores), p99 " << (within ? "within" : "OVER") << " the " << o.latencyMs << " ms target" << std::endl;
+        if (!within || o.ramp <= 0) break;
+        passing = games;
+    }
+    if (o.ramp > 0) {
+        if (passing > 0) {
+            std::cout << "Capacity: " << double(passing) / cores << " sessions per core (" << passing
+                << " sessions, " << cores << " cores) with p99 within " << o.latencyMs << " ms" << std::endl;
+        }
+        else {
+            std::cout << "Capacity: below " << o.games << " sessions, the first round already missed the "
+                << o.latencyMs << " ms target" << std::endl;
+        }
+    }
+    std::string serverStats = queryStats(o.port);
+    if (!serverStats.empty()) std::cout << "Server: " << serverStats << std::endl;
+    if (server) server->stop();
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Synthetic load for the GameServer ("loadgen" mode).
+ * @param args Command-line arguments after the mode name.
+ * @return Process exit code.
+ *
+ * Client threads open many games each and play random legal moves for the human side,
+ * optionally pausing between moves like a person would. Every bot reply's latency is
+ * measured from the moment the human move was sent. The report gives bot moves per second,
+ * p50/p90/p99/max latency, errors and the offered load per core against the latency target.
+ * With --ramp the run repeats with more sessions each round until p99 misses the target, and
+ * the last round that met it is reported as the capacity in sessions per core.
+ *
+ * Options:
+ *   --port P        Server to load (default: start one in this process on a free port).
+ *   --workers N     Bot workers of the in-process server (default: hardware threads).
+ *   --games N       Concurrent sessions (default 1000).
+ *   --clients N     Client connections sharing those sessions (default 4).
+ *   --moves N       Human moves per game (default 20).
+ *   --think MS      Pause before each human move (default 1000).
+ *   --movetime MS   Bot think time per move (default 20).
+ *   --latency MS    Per-game reply latency target (default 250).
+ *   --ramp N        Add N sessions per round until p99 exceeds --latency (default 0: one round).
+ */
+int runLoadGenerator(const std::vector<std::string>& args);
+
+#endif // LOAD_GEN_H
@@ -4,24 +4,44 @@
  *
  * This file contains the main function and menu system for the chess game. It creates a Menu object
  * to allow the user to start a new game, load a saved game, view the game log, or exit. The game logic
- * uses the GameSession class to manage each game.
+ * uses the GameSession class to manage each game. Passing a mode on the command line (e.g. "prunebench")
+ * runs a non-interactive tool instead of the menu,
+ * and "uci" turns the program into a headless engine for chess GUIs and match runners.
  */
 #define _CRT_SECURE_NO_WARNINGS
 
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
-#include <fstream>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "Board.h"
 #include "Player.h"
 #include "Bot.h"
+#include "Trace.h"
+#include "Histogram.h"
+#include "BoardRenderer.h"
+#include "GameJournal.h"
+#include "GameLog.h"
+#include "Bench.h"
+#include "BoardStress.h"
+#include "Nnue.h"
+#include "Uci.h"
+#include "Match.h"
+#include "Epd.h"
+#include "GameServer.h"
+#include "LoadGen.h"
+#include "AnalysisServer.h"
+#include "AnalysisLoad.h"
+#include "Distributed.h"
 
-#ifdef _WIN32
-#define CLEAR_COMMAND "cls"
-#else
-#define CLEAR_COMMAND "clear"
-#endif
+// Finished games are appended to this binary log (see GameLog; "Chess gamelog" queries it).
+const char* const GAME_LOG = "game_log.bin";
+
+// Every game's moves are journaled here as they are played; load it from the menu to continue.
+const char* const AUTOSAVE_JOURNAL = "autosave.journal";
 
  /**
   * @class GameSession
@@ -29,27 +49,43 @@
   *
   * The GameSession class ties together the Board, Player (human), and Bot (AI) for a single game.
   * It handles turn-by-turn execution of the game, including input handling, turn switching,
-  * detecting game end conditions, saving mid-game, and logging results.
+  * detecting game end conditions, saving mid-game, and logging results. While the human is
+  * thinking, the AI ponders on a background thread (see startPondering()). Each move is
+  * appended to a GameJournal as it is played, so a game survives the program being killed.
   */
 class GameSession {
 public:
     GameSession() : human(Color::WHITE, true), ai(Color::BLACK) {
         // Board is initialized with default constructor (standard chess starting positions).
+        aiColor = ai.getColor();
+        playLimits = ai.getSearchLimits();
+    }
+
+    ~GameSession() {
+        stopPondering();
     }
 
     /**
      * @brief Start a new game session loop.
      * @param loadFilename If non-empty, a saved game state will be loaded from this file before starting.
+     *        A journal (such as AUTOSAVE_JOURNAL) is replayed and continued; a save file starts a new journal.
      *
      * This function runs the main game loop, alternating turns between the human and AI. It catches
      * SaveGameException and QuitGameException to handle save and quit commands from the human player.
      * When the game ends (by checkmate, stalemate, or user quitting), it logs the game result to a file.
      */
     void play(const std::string& loadFilename = "") {
+        startTime = std::time(nullptr);
         try {
-            if (!loadFilename.empty()) {
-                board.loadFromFile(loadFilename);
-                std::cout << "Game loaded from " << loadFilename << ".\n";
+            if (!loadFilename.empty() && GameJournal::isJournal(loadFilename)) {
+                resumeJournal(loadFilename);
+            }
+            else {
+                if (!loadFilename.empty()) {
+                    board.loadFromFile(loadFilename);
+                    std::cout << "Game loaded from " << loadFilename << ".\n";
+                }
+                startJournal();
             }
         }
         catch (const std::exception& e) {
@@ -58,21 +94,27 @@ public:
         }
 
         bool gameAborted = false;
+        PackedMove ponderedReply = 0;
         // Main game loop
         while (board.isGameRunning()) {
-            system(CLEAR_COMMAND);
-            board.displayBoard();
+            render();
             if (board.currentPlayerColor == human.getColor()) {
                 // Human's turn
                 std::cout << "Your turn (" << (human.getColor() == Color::WHITE ? "White" : "Black") << "):" << std::endl;
                 bool moveMade = false;
+                startPondering();
                 // Keep prompting until a valid move is made or the player decides to save/quit.
                 while (!moveMade) {
                     try {
                         moveMade = human.makeMove(board);
+                        if (moveMade) {
+                            moveLatency.record(human.getLastValidationMicros());
+                            journal.recordLastMove(journalGame, board);
+                        }
                     }
                     catch (const SaveGameException&) {
                         // Handle save request.
+                        stopPondering();
                         std::string filename;
                         std::cout << "Enter filename to save the game: ";
                         std::cin >> filename;
@@ -84,10 +126,12 @@ public:
                             std::cerr << "Failed to save game: " << ex.what() << std::endl;
                         }
                         // Continue the loop without changing turn.
+                        startPondering();
                         continue;
                     }
                     catch (const QuitGameException&) {
                         // Handle quit request: abort the game and return to menu.
+                        stopPondering();
                         std::cout << "Quitting to main menu...\n";
                         gameAborted = true;
                         board.setGameRunning(false); // mark game as no longer running
@@ -95,17 +139,28 @@ public:
                     }
                     if (!moveMade) {
                         std::cout << "Invalid move. Try again." << std::endl;
+                        // Restart from the same position; the hash table keeps what was found so far.
+                        stopPondering();
+                        startPondering();
                     }
                 }
                 if (gameAborted) break; // exit the outer game loop if user quit
+                ponderedReply = finishPondering();
             }
             else {
                 // AI's turn
                 std::cout << "AI's turn (" << (ai.getColor() == Color::WHITE ? "White" : "Black") << "):" << std::endl;
-                bool moveMade = ai.makeMove(board);
+                auto thinkStart = std::chrono::steady_clock::now();
+                bool moveMade = ponderedReply ? ai.playMove(board, ponderedReply) : ai.makeMove(board);
+                ponderedReply = 0;
+                if (moveMade) {
+                    thinkLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - thinkStart).count());
+                    journal.recordLastMove(journalGame, board);
+                }
                 if (!moveMade) {
                     // No valid moves for AI: game over (either checkmate or stalemate).
-                    if (board.isPlayerInCheck(ai.getColor())) {
+                    if (board.isPlayerChecked()) {
                         std::cout << "AI has no moves and is in check - checkmate!" << std::endl;
                     }
                     else {
@@ -117,62 +172,209 @@ public:
         }
 
         // Game loop ended.
-        system(CLEAR_COMMAND);
-        board.displayBoard();
-        std::string result;
-        if (gameAborted) {
-            result = "Game aborted by user.";
-        }
-        else {
-            // Determine result of the finished game.
-            if (board.isPlayerInCheck(board.currentPlayerColor)) {
-                // The current player to move is in check and has no moves: checkmate.
-                Color winner = (board.currentPlayerColor == Color::WHITE ? Color::BLACK : Color::WHITE);
-                result = (winner == Color::WHITE ? "White" : "Black");
-                result += " wins by checkmate.";
-            }
-            else {
-                result = "Draw by stalemate.";
-            }
+        render();
+        renderer.release();
+        GameResult result = GameResult::DRAW;
+        if (!gameAborted && board.isPlayerChecked()) {
+            // The current player to move is in check and has no moves: checkmate.
+            result = board.currentPlayerColor == Color::WHITE ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
         }
-        std::cout << "Game over. " << result << std::endl;
+        std::cout << "Game over. " << (gameAborted ? "Game aborted by user." : gameResultText(result)) << std::endl;
 
-        // Log the game result to a log file.
+        // Log the game result to a log file. An aborted game stays open in the journal.
         if (!gameAborted) {
+            journal.endGame(journalGame);
             logGameResult(result);
         }
+        else if (journal.isOpen()) {
+            std::cout << "Load " << AUTOSAVE_JOURNAL << " to continue this game." << std::endl;
+        }
+        journal.close();
     }
 
 private:
     Board board;
     Player human;
     Bot ai;
+    Color aiColor;
+    SearchLimits playLimits;             ///< The AI's normal limits, restored after pondering.
+
+    // Background search while the human thinks.
+    std::thread ponderThread;
+    Board ponderBoard;                   ///< Root of the ponder search (owned by the thread while it runs).
+    PackedMove ponderMove{ 0 };          ///< Predicted human move, or 0 when pondering every reply.
+    std::atomic<bool> ponderDone{ false };
+    std::chrono::steady_clock::time_point ponderStart;
+
+    GameJournal journal;                 ///< Moves of this game, appended as they are played.
+    std::uint32_t journalGame{ 1 };      ///< This game's ID in the journal.
+    std::string startFen;                ///< Position the moves in the board's history start from.
+    std::time_t startTime{ 0 };
+
+    // Per-ply latencies, written to the game log with the result.
+    LatencyHistogram thinkLatency;       ///< AI turn: search and playing the move.
+    LatencyHistogram moveLatency;        ///< Human turn: validating and playing the entered move.
+    LatencyHistogram renderLatency;      ///< Drawing the board.
+    BoardRenderer renderer{ std::cout }; ///< Keeps the board at the top of the terminal.
+
+    /**
+     * @brief Start journaling this game from the current position into AUTOSAVE_JOURNAL.
+     *
+     * A move every few seconds is cheap to fsync, so every record is synced at once. Without a
+     * journal (e.g. an unwritable directory) the game is still played.
+     */
+    void startJournal() {
+        startFen = board.toFen();
+        std::string error;
+        if (!journal.create(AUTOSAVE_JOURNAL, error)) {
+            std::cerr << "Moves will not be journaled: " << error << std::endl;
+            return;
+        }
+        journal.setSyncPolicy(1, 0);
+        journal.beginGame(journalGame, startFen);
+    }
+
+    /**
+     * @brief Replay the last unfinished game of a journal and keep appending to it.
+     * @throws std::runtime_error if the journal can't be read or has no unfinished game.
+     */
+    void resumeJournal(const std::string& filename) {
+        std::vector<JournalGame> games;
+        std::string error;
+        if (!journal.resume(filename, games, error)) {
+            throw std::runtime_error(error);
+        }
+        if (games.empty()) {
+            journal.close();
+            throw std::runtime_error("no unfinished game in " + filename);
+        }
+        games.back().replay(board);
+        startFen = games.back().fen;
+        journalGame = games.back().id;
+        journal.setSyncPolicy(1, 0);
+        std::cout << "Game recovered from " << filename << " (" << games.back().moves.size() << " moves).\n";
+    }
+
+    /**
+     * @brief Redraw the squares that changed since the last render, recording how long it took.
+     */
+    void render() {
+        auto start = std::chrono::steady_clock::now();
+        renderer.render(board);
+        renderLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
 
     /**
-     * @brief Log the game outcome and moves to a log file.
-     * @param result A description of the game result (e.g., "White wins by checkmate.")
+     * @brief Start searching in the background while the human thinks.
      *
-     * This function appends the result of the game to a "game_log.txt" file, including a timestamp and move count.
+     * If the AI's last search predicted the human's reply (the second move of its PV), the
+     * position after that reply is searched, so a correct guess leaves the answer ready.
+     * Otherwise the human's own position is searched, which fills the shared transposition
+     * table for whatever reply comes.
      */
-    void logGameResult(const std::string& result) {
-        std::ofstream logFile("game_log.txt", std::ios::app);
-        if (!logFile.is_open()) {
-            std::cerr << "Could not open log file to record game result." << std::endl;
+    void startPondering() {
+        if (ponderThread.joinable() || !board.isGameRunning()) {
             return;
         }
-        // Get current date/time for log.
-        std::time_t now = std::time(nullptr);
-        std::tm* localTime = std::localtime(&now);
-        char timeBuf[100];
-        if (localTime && std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", localTime)) {
-            logFile << "[" << timeBuf << "] ";
-        }
-        // Count the number of half-moves (plies) in the game using move history.
-        std::stack<Move> moves = board.getMoveHistory();
-        int halfMoves = moves.size();
-        int fullMoves = (halfMoves + 1) / 2;
-        logFile << result << " Moves: " << fullMoves << " full moves (" << halfMoves << " plies)." << std::endl;
-        logFile.close();
+        ponderBoard = board;
+        ponderMove = 0;
+        const SearchResult& last = ai.getLastResult();
+        if (last.pv.size() >= 2) {
+            PackedMove reply = last.pv[1];
+            Piece* piece = ponderBoard.getPieceAt(packedFromX(reply), packedFromY(reply));
+            if (piece && piece->getColor() == human.getColor() &&
+                ponderBoard.applyMove(piece->getId(), packedToX(reply), packedToY(reply)).first &&
+                !ponderBoard.isPlayerInCheck(human.getColor())) {
+                ponderMove = reply;
+            }
+            else {
+                ponderBoard = board;
+            }
+        }
+        ai.setColor(ponderMove ? aiColor : human.getColor());
+        SearchLimits limits = playLimits;
+        limits.infinite = true;
+        ai.setSearchLimits(limits);
+        ponderDone = false;
+        ponderStart = std::chrono::steady_clock::now();
+        ponderThread = std::thread([this] {
+            ai.think(ponderBoard);
+            ponderDone = true;
+        });
+    }
+
+    /**
+     * @brief Cancel the background search (save, quit, invalid move or a wrong guess).
+     */
+    void stopPondering() {
+        if (!ponderThread.joinable()) {
+            return;
+        }
+        ai.stop();
+        ponderThread.join();
+        ai.setColor(aiColor);
+        ai.setSearchLimits(playLimits);
+    }
+
+    /**
+     * @brief End pondering once the human has moved.
+     * @return The AI's reply if the human played the predicted move, otherwise 0.
+     *
+     * On a correct guess the search may go on until it has used the AI's normal move time,
+     * counted from when pondering began, so the reply is never searched for less wall-clock
+     * time than without pondering but usually arrives at once.
+     */
+    PackedMove finishPondering() {
+        if (!ponderThread.joinable()) {
+            return 0;
+        }
+        bool hit = ponderMove != 0 && ponderBoard.currentPlayerColor == board.currentPlayerColor &&
+            ponderBoard.getHashKey() == board.getHashKey();
+        while (hit && !ponderDone) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - ponderStart).count();
+            if (playLimits.moveTimeMs > 0 && elapsed >= playLimits.moveTimeMs) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stopPondering();
+        if (!hit) {
+            return 0;
+        }
+        std::cout << "AI predicted your move." << std::endl;
+        return ai.getLastResult().bestMove;
+    }
+
+    /**
+     * @brief Append the finished game to the game log.
+     * @param result How the game ended.
+     *
+     * The record holds the start and end time, the start position and every move since, and the
+     * latency histograms of the game (see GameLog).
+     */
+    void logGameResult(GameResult result) {
+        GameRecord record;
+        record.startTime = startTime;
+        record.endTime = std::time(nullptr);
+        record.result = result;
+        record.humanColor = human.getColor();
+        record.startFen = startFen;
+        record.moves.reserve(board.getMoveHistory().ply());
+        for (const Move& m : board.getMoveHistory()) {
+            std::uint8_t promotion = m.promoted ? static_cast<std::uint8_t>(1 + static_cast<int>(m.promotedTo)) : 0;
+            record.moves.push_back({ packMove(m.from.first, m.from.second, m.to.first, m.to.second), promotion });
+        }
+        record.thinkLatency = thinkLatency;
+        record.moveLatency = moveLatency;
+        record.renderLatency = renderLatency;
+        try {
+            GameLog(GAME_LOG).append(record);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Could not record the game in " << GAME_LOG << ": " << e.what() << std::endl;
+        }
     }
 };
 
@@ -192,8 +394,10 @@ public:
         std::cout << "1. Start New Game\n";
         std::cout << "2. Load Game from File\n";
         std::cout << "3. View Game Log\n";
-        std::cout << "4. Exit\n";
-        std::cout << "Enter choice (1-4): ";
+        std::cout << "4. Latency Report\n";
+        std::cout << "5. Game Statistics\n";
+        std::cout << "6. Exit\n";
+        std::cout << "Enter choice (1-6): ";
         int choice;
         if (!(std::cin >> choice)) {
             // Handle non-integer input
@@ -212,7 +416,7 @@ public:
         case 2: {
             // Load a game from a file.
             std::string filename;
-            std::cout << "Enter filename to load: ";
+            std::cout << "Enter filename to load (a save file or " << AUTOSAVE_JOURNAL << "): ";
             std::cin >> filename;
             GameSession game;
             game.play(filename);
@@ -224,6 +428,16 @@ public:
             break;
         }
         case 4: {
+            // Percentiles over every logged game.
+            latencyReport();
+            break;
+        }
+        case 5: {
+            // Win rates and game lengths, from the log's index alone.
+            gameStatistics();
+            break;
+        }
+        case 6: {
             std::cout << "Exiting program. Goodbye!" << std::endl;
             return;
         }
@@ -240,25 +454,167 @@ public:
 
 private:
     /**
-     * @brief Display the contents of the game log file.
+     * @brief Display the game log as text.
      */
     void viewLog() {
-        std::ifstream logFile("game_log.txt");
-        if (!logFile.is_open()) {
-            std::cout << "No log file found or unable to open log file." << std::endl;
+        try {
+            GameLog log(GAME_LOG);
+            if (log.readIndex().empty()) {
+                std::cout << "No games have been logged yet." << std::endl;
+                return;
+            }
+            std::cout << "\n--- Game Log ---" << std::endl;
+            log.exportText(std::cout, GameFilter());
+            std::cout << "----------------\n";
+        }
+        catch (const std::exception& e) {
+            std::cout << "Unable to read the game log: " << e.what() << std::endl;
+        }
+    }
+
+    /**
+     * @brief Merge the latency histograms of every logged game and print their percentiles.
+     */
+    void latencyReport() {
+        const char* kinds[] = { "bot-think", "human-move", "render" };
+        LatencyHistogram totals[3];
+        std::size_t games = 0;
+        try {
+            GameLog log(GAME_LOG);
+            std::vector<GameIndexEntry> index = log.readIndex();
+            for (const GameIndexEntry& entry : index) {
+                GameRecord game = log.read(entry);
+                totals[0].merge(game.thinkLatency);
+                totals[1].merge(game.moveLatency);
+                totals[2].merge(game.renderLatency);
+            }
+            games = index.size();
+        }
+        catch (const std::exception& e) {
+            std::cout << "Unable to read the game log: " << e.what() << std::endl;
             return;
         }
-        std::cout << "\n--- Game Log ---" << std::endl;
-        std::string line;
-        while (std::getline(logFile, line)) {
-            std::cout << line << std::endl;
+
+        std::cout << "\n--- Latency Report (" << games << " games) ---" << std::endl;
+        for (int i = 0; i < 3; ++i) {
+            std::cout << std::left << std::setw(11) << kinds[i] << std::right << " n=" << std::setw(6) << totals[i].count()
+                << "  " << totals[i].summary() << std::endl;
         }
         std::cout << "----------------\n";
-        logFile.close();
+    }
+
+    /**
+     * @brief Print win rates and average game length over every logged game.
+     */
+    void gameStatistics() {
+        try {
+            std::cout << "\n--- Game Statistics ---\n" << GameLog(GAME_LOG).summarize(GameFilter()).text()
+                << "(Chess gamelog stats filters by date and result.)\n----------------\n";
+        }
+        catch (const std::exception& e) {
+            std::cout << "Unable to read the game log: " << e.what() << std::endl;
+        }
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Global options come first: "--evalfile <file>" loads an NNUE network for every Bot,
+    // "--stats" prints search statistics with every move a Bot plays, "--trace <file>"
+    // records a trace-event timeline (builds with CHESS_TRACE only).
+    int argi = 1;
+    while (argi < argc) {
+        std::string option = argv[argi];
+        if (option == "--stats") {
+            Bot::setStatsLogging(true);
+            ++argi;
+            continue;
+        }
+        if (option == "--trace" && argi + 1 < argc) {
+#ifdef CHESS_TRACE
+            if (!Trace::start(argv[argi + 1])) {
+                std::cerr << "Cannot write trace file " << argv[argi + 1] << std::endl;
+            }
+#else
+            std::cerr << "--trace ignored: built without CHESS_TRACE" << std::endl;
+#endif
+            argi += 2;
+            continue;
+        }
+        if (option != "--evalfile" || argi + 1 >= argc) break;
+        std::string error;
+        auto network = NnueNetwork::load(argv[argi + 1], error);
+        if (network) {
+            NnueNetwork::setDefault(network);
+            std::cout << "Loaded NNUE network " << argv[argi + 1] << std::endl;
+        }
+        else {
+            std::cerr << "NNUE disabled: " << error << std::endl;
+        }
+        argi += 2;
+    }
+    argc -= argi - 1;
+    argv += argi - 1;
+
+    // Non-interactive modes are selected by the first remaining argument.
+    if (argc > 1) {
+        std::string mode = argv[1];
+        if (mode == "uci" || mode == "--uci") {
+            UciEngine engine(std::cin, std::cout);
+            return engine.run();
+        }
+        if (mode == "selfplay") {
+            return runSelfPlayMatch(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "gamelog") {
+            return runGameLogTool(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "epd") {
+            return runEpdAnalysis(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "serve") {
+            return runGameServer(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "loadgen") {
+            return runLoadGenerator(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "analysisd") {
+            return runAnalysisServer(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "analysisload") {
+            return runAnalysisLoad(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "coordinator") {
+            return runCoordinator(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "worker") {
+            return runWorker(std::vector<std::string>(argv + 2, argv + argc));
+        }
+        if (mode == "bench") {
+            runBench(argc > 2 ? std::atoi(argv[2]) : 9);
+            return 0;
+        }
+        if (mode == "prunebench") {
+            runPruningBenchmark(argc > 2 ? std::atoi(argv[2]) : 6);
+            return 0;
+        }
+        if (mode == "schedbench") {
+            runSchedulerBenchmark(argc > 2 ? std::atoi(argv[2]) : 32, argc > 3 ? std::atoi(argv[3]) : 6,
+                argc > 4 ? std::atoll(argv[4]) : 1024);
+            return 0;
+        }
+        if (mode == "boardstress") {
+            return runBoardStress(argc > 2 ? std::atoi(argv[2]) : 0, argc > 3 ? std::atoi(argv[3]) : 5);
+        }
+        std::cerr << "Unknown mode: " << mode << std::endl;
+        std::cerr << "Usage: Chess [--stats] [--trace <file>] [--evalfile <file>] [uci | selfplay [options] | epd <file> [options] |\n"
+            << "                                      serve [options] | loadgen [options] | analysisd [options] |\n"
+            << "                                      analysisload [options] | coordinator [options] <job> |\n"
+            << "                                      worker [options] | bench [depth] | prunebench [depth] |\n"
+            << "                                      schedbench [searches] [depth] [slice] |\n"
+            << "                                      boardstress [threads] [seconds] |\n"
+            << "                                      gamelog stats|export [options]]" << std::endl;
+        return 1;
+    }
     Menu menu;
     menu.show();
     return 0;
@@ -0,0 +1,568 @@
+/**
+ * @file Match.cpp
+ * @brief Self-play match runner: parallel Bot-vs-Bot games, Elo estimate and SPRT.
+ *
+ * Each worker thread owns one Bot per engine and takes the next game number from a shared
+ * counter, so games are independent and the pairs of an opening may run on different
+ * threads. Games are adjudicated by the runner: mate and stalemate, threefold repetition,
+ * the 50-move rule, insufficient material, a ply limit, and loss on time under a clock.
+ */
+#include "Match.h"
+#include "Board.h"
+#include "Bot.h"
+#include "Nnue.h"
+#include "Notation.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+    // Short, castling-free openings used when no --openings file is given.
+    const char* const builtinOpenings[] = {
+        "e2e4 e7e5 g1f3 b8c6 f1c4 g8f6",
+        "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6",
+        "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6",
+        "e2e4 c7c5 b1c3 b8c6 g2g3 g7g6 f1g2 f8g7",
+        "e2e4 e7e6 d2d4 d7d5 b1c3 f8b4",
+        "e2e4 c7c6 d2d4 d7d5 e4e5 c8f5",
+        "e2e4 d7d5 e4d5 d8d5 b1c3 d5a5",
+        "e2e4 g8f6 e4e5 f6d5 d2d4 d7d6",
+        "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6 c1g5 f8e7",
+        "d2d4 d7d5 c2c4 c7c6 g1f3 g8f6 b1c3 d5c4",
+        "d2d4 g8f6 c2c4 g7g6 b1c3 f8g7 e2e4 d7d6",
+        "d2d4 g8f6 c2c4 e7e6 b1c3 f8b4 d1c2",
+        "d2d4 g8f6 c2c4 c7c5 d4d5 e7e6 b1c3 e6d5 c4d5 d7d6",
+        "d2d4 f7f5 g2g3 g8f6 f1g2 e7e6 g1f3",
+        "c2c4 e7e5 b1c3 g8f6 g2g3 d7d5 c4d5 f6d5",
+        "c2c4 c7c5 g1f3 g8f6 b1c3 b8c6",
+        "g1f3 d7d5 g2g3 g8f6 f1g2 c7c6",
+        "g1f3 g8f6 c2c4 b7b6 g2g3 c8b7 f1g2 e7e6",
+        "e2e4 e7e5 f2f4 e5f4 g1f3 g7g5",
+        "e2e4 e7e5 b1c3 g8f6 f2f4 d7d5",
+        "d2d4 d7d5 c1f4 g8f6 e2e3 c7c5",
+        "e2e4 d7d6 d2d4 g8f6 b1c3 g7g6",
+        "b2b3 e7e5 c1b2 b8c6 e2e3 g8f6",
+        "e2e4 b8c6 d2d4 d7d5 b1c3 d5e4"
+    };
+
+    struct EngineConfig {
+        std::string name;
+        SearchParams params;
+        std::shared_ptr<const NnueNetwork> network;
+    };
+
+    struct MatchOptions {
+        int games = 1000;
+        int concurrency = 1;
+        long long baseMs = 0;          ///< Clock per side (0 = no clock).
+        long long incMs = 0;
+        int moveTimeMs = 100;
+        int depth = 0;
+        long long nodes = 0;
+        std::size_t hashMb = 8;
+        std::string openingsFile;
+        std::string outFile = "selfplay_results.txt";
+        bool sprt = false;
+        double elo0 = 0.0, elo1 = 5.0;
+        double alpha = 0.05, beta = 0.05;
+        EngineConfig engines[2];
+    };
+
+    enum class GameResult { WHITE_WINS, BLACK_WINS, DRAW };
+
+    struct Opening {
+        std::string text;
+        Board board;
+    };
+
+    bool parseBool(const std::string& v) {
+        return v == "1" || v == "true" || v == "on" || v == "yes";
+    }
+
+    // key=value for one engine: SearchParams fields by their lower-case names, evalfile, name.
+    bool applyEngineOption(EngineConfig& engine, const std::string& option, std::string& error) {
+        size_t eq = option.find('=');
+        if (eq == std::string::npos) {
+            error = "expected KEY=VALUE, got " + option;
+            return false;
+        }
+        std::string key = option.substr(0, eq), value = option.substr(eq + 1);
+        SearchParams& p = engine.params;
+        struct BoolField { const char* key; bool SearchParams::* field; };
+        struct IntField { const char* key; int SearchParams::* field; };
+        struct DoubleField { const char* key; double SearchParams::* field; };
+        static const BoolField bools[] = {
+            { "nullmove", &SearchParams::nullMove }, { "nullmoveverify", &SearchParams::nullMoveVerify },
+            { "lmr", &SearchParams::lateMoveReductions }, { "futility", &SearchParams::futility },
+            { "rfp", &SearchParams::reverseFutility }, { "aspiration", &SearchParams::aspiration }
+        };
+        static const IntField ints[] = {
+            { "nullmovemindepth", &SearchParams::nullMoveMinDepth }, { "nullmovereduction", &SearchParams::nullMoveReduction },
+            { "nullmoveverifydepth", &SearchParams::nullMoveVerifyDepth }, { "lmrmindepth", &SearchParams::lmrMinDepth },
+            { "lmrminmoves", &SearchParams::lmrMinMoves }, { "futilitymaxdepth", &SearchParams::futilityMaxDepth },
+            { "futilitymargin", &SearchParams::futilityMargin }, { "rfpmaxdepth", &SearchParams::reverseFutilityMaxDepth },
+            { "rfpmargin", &SearchParams::reverseFutilityMargin }, { "aspirationmindepth", &SearchParams::aspirationMinDepth },
+            { "aspirationwindow", &SearchParams::aspirationWindow }
+        };
+        static const DoubleField doubles[] = {
+            { "lmrbase", &SearchParams::lmrBase }, { "lmrdivisor", &SearchParams::lmrDivisor }
+        };
+        for (const BoolField& f : bools) {
+            if (key == f.key) { p.*f.field = parseBool(value); return true; }
+        }
+        for (const IntField& f : ints) {
+            if (key == f.key) { p.*f.field = std::atoi(value.c_str()); return true; }
+        }
+        for (const DoubleField& f : doubles) {
+            if (key == f.key) { p.*f.field = std::atof(value.c_str()); return true; }
+        }
+        if (key == "name") {
+            engine.name = value;
+            return true;
+        }
+        if (key == "evalfile") {
+            engine.network = value.empty() ? nullptr : NnueNetwork::load(value, error);
+            return value.empty() || engine.network != nullptr;
+        }
+        error = "unknown engine option " + key;
+        return false;
+    }
+
+    bool parseOptions(const std::vector<std::string>& args, MatchOptions& o, std::string& error) {
+        o.concurrency = std::max(1u, std::thread::hardware_concurrency());
+        o.engines[0].name = "A";
+        o.engines[1].name = "B";
+        o.engines[0].network = o.engines[1].network = NnueNetwork::getDefault();
+        for (size_t i = 0; i < args.size(); ++i) {
+            const std::string& a = args[i];
+            bool hasValue = i + 1 < args.size();
+            std::string v = hasValue ? args[i + 1] : "";
+            if (!hasValue) {
+                error = "missing value for " + a;
+                return false;
+            }
+            ++i;
+            if (a == "--games") o.games = std::atoi(v.c_str());
+            else if (a == "--concurrency") o.concurrency = std::max(1, std::atoi(v.c_str()));
+            else if (a == "--tc") {
+                size_t plus = v.find('+');
+                o.baseMs = (long long)(std::atof(v.substr(0, plus).c_str()) * 1000.0);
+                o.incMs = plus == std::string::npos ? 0 : (long long)(std::atof(v.substr(plus + 1).c_str()) * 1000.0);
+            }
+            else if (a == "--movetime") o.moveTimeMs = std::atoi(v.c_str());
+            else if (a == "--depth") o.depth = std::atoi(v.c_str());
+            else if (a == "--nodes") o.nodes = std::atoll(v.c_str());
+            else if (a == "--hash") o.hashMb = std::size_t(std::max(1, std::atoi(v.c_str())));
+            else if (a == "--openings") o.openingsFile = v;
+            else if (a == "--out") o.outFile = v;
+            else if (a == "--alpha") o.alpha = std::atof(v.c_str());
+            else if (a == "--beta") o.beta = std::atof(v.c_str());
+            else if (a == "--sprt") {
+                if (i + 1 >= args.size()) {
+                    error = "--sprt needs ELO0 and ELO1";
+                    return false;
+                }
+                o.sprt = true;
+                o.elo0 = std::atof(v.c_str());
+                o.elo1 = std::atof(args[++i].c_str());
+            }
+            else if (a == "--a" || a == "--b") {
+                if (!applyEngineOption(o.engines[a == "--a" ? 0 : 1], v, error)) return false;
+            }
+            else {
+                error = "unknown option " + a;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool playMoves(Board& board, const std::string& line) {
+        std::istringstream in(line);
+        std::string mv;
+        while (in >> mv) {
+            if (mv.size() < 4) return false;
+            int fx = mv[0] - 'a', fy = 8 - (mv[1] - '0');
+            int tx = mv[2] - 'a', ty = 8 - (mv[3] - '0');
+            if (fx < 0 || fx > 7 || fy < 0 || fy > 7 || tx < 0 || tx > 7 || ty < 0 || ty > 7) return false;
+            Piece* piece = board.getPieceAt(fx, fy);
+            if (!piece || !board.applyMove(piece->getId(), tx, ty).first) return false;
+        }
+        return true;
+    }
+
+    // FEN/EPD lines contain '/'; anything else is a move sequence from the initial position.
+    bool loadOpening(const std::string& line, Board& board) {
+        if (line.find('/') != std::string::npos) {
+            try {
+                board.loadFromFen(line);
+            }
+            catch (const std::exception&) {
+                return false;
+            }
+            return true;
+        }
+        board = Board();
+        return playMoves(board, line);
+    }
+
+    std::vector<Opening> loadOpenings(const std::string& file) {
+        std::vector<std::string> lines;
+        if (file.empty()) {
+            lines.assign(std::begin(builtinOpenings), std::end(builtinOpenings));
+        }
+        else {
+            std::ifstream in(file);
+            if (!in) {
+                throw std::runtime_error("cannot open opening file " + file);
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty() || line[0] == '#') continue;
+                lines.push_back(line);
+            }
+        }
+        std::vector<Opening> openings;
+        for (const std::string& line : lines) {
+            Opening opening;
+            opening.text = line;
+            if (loadOpening(line, opening.board)) {
+                openings.push_back(opening);
+            }
+            else {
+                std::cerr << "Skipping unusable opening: " << line << std::endl;
+            }
+        }
+        return openings;
+    }
+
+    bool insufficientMaterial(const Board& board) {
+        int minors = 0;
+        for (const std::vector<Piece>* pieces : { &board.whitePieces, &board.blackPieces }) {
+            for (const Piece& p : *pieces) {
+                if (!p.isAlive() || p.getType() == PieceType::KING) continue;
+                if (p.getType() != PieceType::KNIGHT && p.getType() != PieceType::BISHOP) return false;
+                ++minors;
+            }
+        }
+        return minors <= 1;
+    }
+
+    bool isLegalMove(const Board& board, PackedMove move) {
+        std::vector<PackedMove> legal = generateLegalMoves(board, board.currentPlayerColor);
+        return std::find(legal.begin(), legal.end(), move) != legal.end();
+    }
+
+    /**
+     * @brief Play one game between two bots and adjudicate it.
+     * @param bots   bots[0] plays White, bots[1] Black.
+     * @param reason Receives a short description of how the game ended (with the FEN and move,
+     *               for an illegal move).
+     */
+    GameResult playGame(const Board& start, Bot* bots[2], const MatchOptions& o, std::string& reason, int& plies) {
+        Board board = start;
+        long long clock[2] = { o.baseMs, o.baseMs };
+        std::vector<std::uint64_t> keys;   // positions since the last capture or pawn move
+        keys.push_back(board.getPositionKey(board.currentPlayerColor));
+        int quietPlies = 0;
+        plies = 0;
+
+        while (true) {
+            int us = board.currentPlayerColor == Color::WHITE ? 0 : 1;
+            Bot& bot = *bots[us];
+            SearchLimits limits;
+            limits.maxDepth = o.depth > 0 ? o.depth : limits.maxDepth;
+            limits.maxNodes = o.nodes;
+            limits.moveTimeMs = o.baseMs > 0 ? Bot::allocateTime(clock[us], o.incMs)
+                : (o.depth > 0 || o.nodes > 0 ? 0 : o.moveTimeMs);
+            bot.setColor(board.currentPlayerColor);
+            bot.setSearchLimits(limits);
+
+            auto start = std::chrono::steady_clock::now();
+            PackedMove move = bot.think(board);
+            long long used = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            if (!move) {
+                // think() only returns no move when there is none.
+                if (board.isPlayerInCheck(board.currentPlayerColor)) {
+                    reason = "checkmate";
+                    return us == 0 ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+                }
+                reason = "stalemate";
+                return GameResult::DRAW;
+            }
+            if (!isLegalMove(board, move)) {
+                // An engine bug, not a result of play: it loses, and the game line says where.
+                reason = "illegal move " + moveToUci(board, move) + " in " + board.toFen();
+                return us == 0 ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+            }
+            if (o.baseMs > 0) {
+                clock[us] -= used;
+                if (clock[us] < 0) {
+                    reason = "time forfeit";
+                    return us == 0 ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+                }
+                clock[us] += o.incMs;
+            }
+
+            Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+            bool irreversible = piece->getType() == PieceType::PAWN ||
+                board.getPieceAt(packedToX(move), packedToY(move)) != nullptr;
+            board.applyMove(piece->getId(), packedToX(move), packedToY(move));
+            ++plies;
+
+            std::uint64_t key = board.getPositionKey(board.currentPlayerColor);
+            if (irreversible) {
+                keys.clear();
+                quietPlies = 0;
+            }
+            else {
+                ++quietPlies;
+            }
+            if (std::count(keys.begin(), keys.end(), key) >= 2) {
+                reason = "threefold repetition";
+                return GameResult::DRAW;
+            }
+            keys.push_back(key);
+            if (quietPlies >= 100) {
+                reason = "50-move rule";
+                return GameResult::DRAW;
+            }
+            if (insufficientMaterial(board)) {
+                reason = "insufficient material";
+                return GameResult::DRAW;
+            }
+            if (plies >= 600) {
+                reason = "ply limit";
+                return GameResult::DRAW;
+            }
+        }
+    }
+
+    void createEngines(const MatchOptions& o, std::unique_ptr<Bot> engines[2]) {
+        for (int e = 0; e < 2; ++e) {
+            engines[e].reset(new Bot(Color::WHITE));
+            engines[e]->setSearchParams(o.engines[e].params);
+            engines[e]->setNetwork(o.engines[e].network);
+            engines[e]->setHashSize(o.hashMb);
+        }
+    }
+
+    // Game number `game` of a match: each opening is played twice, engine A taking White in the even game.
+    GameResult playMatchGame(const MatchOptions& o, const std::vector<Opening>& openings,
+        std::unique_ptr<Bot> engines[2], int game, std::string& reason, int& plies) {
+        const Opening& opening = openings[(game / 2) % openings.size()];
+        int whiteEngine = game % 2;
+        Bot* bots[2] = { engines[whiteEngine].get(), engines[1 - whiteEngine].get() };
+        bots[0]->clearHash();
+        bots[1]->clearHash();
+        return playGame(opening.board, bots, o, reason, plies);
+    }
+
+    double expectedScore(double elo) {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+
+    double scoreToElo(double score) {
+        score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+        double elo = -400.0 * std::log10(1.0 / score - 1.0);
+        return elo == 0.0 ? 0.0 : elo;  // no "-0.0" for an even score
+    }
+
+    // Running totals, from engine A's point of view.
+    struct Tally {
+        int wins = 0, draws = 0, losses = 0;
+
+        int games() const { return wins + draws + losses; }
+
+        double score() const {
+            return games() ? (wins + 0.5 * draws) / games() : 0.5;
+        }
+
+        double variance() const {
+            if (!games()) return 0.0;
+            double s = score();
+            return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+        }
+
+        // Elo difference and half-width of its 95% confidence interval.
+        void elo(double& diff, double& margin) const {
+            double s = score();
+            double se = games() ? std::sqrt(variance() / games()) : 0.0;
+            diff = scoreToElo(s);
+            margin = (scoreToElo(s + 1.96 * se) - scoreToElo(s - 1.96 * se)) / 2.0;
+        }
+
+        // Log-likelihood ratio of H1 against H0 under a normal approximation of the game score.
+        double llr(double elo0, double elo1) const {
+            double var = variance();
+            if (games() < 2 || var <= 0.0) return 0.0;
+            double s0 = expectedScore(elo0), s1 = expectedScore(elo1);
+            return games() * (s1 - s0) * (2.0 * score() - s0 - s1) / (2.0 * var);
+        }
+    };
+}
+
+int runSelfPlayMatch(const std::vector<std::string>& args) {
+    MatchOptions o;
+    std::string error;
+    if (!parseOptions(args, o, error)) {
+        std::cerr << "selfplay: " << error << std::endl;
+        return 1;
+    }
+    std::vector<Opening> openings;
+    try {
+        openings = loadOpenings(o.openingsFile);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "selfplay: " << e.what() << std::endl;
+        return 1;
+    }
+    if (openings.empty()) {
+        std::cerr << "selfplay: no usable openings" << std::endl;
+        return 1;
+    }
+    std::ofstream out(o.outFile, std::ios::app);
+    if (!out) {
+        std::cerr << "selfplay: cannot open " << o.outFile << std::endl;
+        return 1;
+    }
+
+    const double lowerBound = std::log(o.beta / (1.0 - o.alpha));
+    const double upperBound = std::log((1.0 - o.beta) / o.alpha);
+
+    std::cout << "Self-play: " << o.engines[0].name << " vs " << o.engines[1].name << ", up to " << o.games
+        << " games on " << o.concurrency << " threads, " << openings.size() << " openings, ";
+    if (o.baseMs > 0) std::cout << "tc " << o.baseMs / 1000.0 << "+" << o.incMs / 1000.0 << "s";
+    else if (o.depth > 0) std::cout << "depth " << o.depth;
+    else if (o.nodes > 0) std::cout << o.nodes << " nodes";
+    else std::cout << o.moveTimeMs << " ms/move";
+    if (o.sprt) std::cout << ", SPRT elo0 " << o.elo0 << " elo1 " << o.elo1 << " (LLR bounds " << std::fixed
+        << std::setprecision(2) << lowerBound << ", " << upperBound << ")";
+    std::cout << std::endl;
+
+    std::atomic<int> nextGame{ 0 };
+    std::atomic<bool> finished{ false };
+    std::mutex resultMutex;
+    Tally tally;
+    std::string verdict;
+    auto matchStart = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        // One bot per engine per thread, reused across games with a cleared hash.
+        std::unique_ptr<Bot> engines[2];
+        createEngines(o, engines);
+        while (!finished) {
+            int game = nextGame++;
+            if (game >= o.games) break;
+            const Opening& opening = openings[(game / 2) % openings.size()];
+            int whiteEngine = game % 2;
+            std::string reason;
+            int plies = 0;
+            GameResult result = playMatchGame(o, openings, engines, game, reason, plies);
+            int scoreForA = result == GameResult::DRAW ? 1
+                : ((result == GameResult::WHITE_WINS) == (whiteEngine == 0) ? 2 : 0);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (finished) break;
+            if (scoreForA == 2) ++tally.wins;
+            else if (scoreForA == 1) ++tally.draws;
+            else ++tally.losses;
+
+            const char* resultText = result == GameResult::DRAW ? "1/2-1/2"
+                : (result == GameResult::WHITE_WINS ? "1-0" : "0-1");
+            out << "game " << game + 1 << "  " << o.engines[whiteEngine].name << " - " << o.engines[1 - whiteEngine].name
+                << "  " << resultText << "  " << reason << "  plies " << plies << "  opening " << opening.text << std::endl;
+
+            double diff, margin;
+            tally.elo(diff, margin);
+            double hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - matchStart).count() / 3600.0;
+            std::cout << "Games " << tally.games() << "  +" << tally.wins << " =" << tally.draws << " -" << tally.losses
+                << std::fixed << std::setprecision(1) << "  Elo " << diff << " +/- " << margin
+                << std::setprecision(0) << "  " << (hours > 0 ? tally.games() / hours : 0.0) << " games/h";
+            if (o.sprt) {
+                double llr = tally.llr(o.elo0, o.elo1);
+                std::cout << std::setprecision(2) << "  LLR " << llr;
+                if (llr >= upperBound) {
+                    verdict = "H1 accepted: " + o.engines[0].name + " is stronger";
+                    finished = true;
+                }
+                else if (llr <= lowerBound) {
+                    verdict = "H0 accepted: no improvement of " + o.engines[0].name + " shown";
+                    finished = true;
+                }
+            }
+            std::cout << std::endl;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < o.concurrency; ++t) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    double diff, margin;
+    tally.elo(diff, margin);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - matchStart).count();
+    std::cout << "Finished " << tally.games() << " games in " << std::fixed << std::setprecision(1) << seconds << " s ("
+        << std::setprecision(0) << (seconds > 0 ? tally.games() * 3600.0 / seconds : 0.0) << " games/h). "
+        << o.engines[0].name << " vs " << o.engines[1].name << ": +" << tally.wins << " =" << tally.draws << " -" << tally.losses
+        << std::setprecision(1) << ", Elo " << diff << " +/- " << margin << std::endl;
+    if (o.sprt) {
+        std::cout << (verdict.empty() ? "SPRT inconclusive after the game limit." : "SPRT: " + verdict) << std::endl;
+    }
+    return 0;
+}
+
+bool playMatchGames(const std::vector<std::string>& args, int first, int count,
+    int& wins, int& draws, int& losses, std::string& error) {
+    MatchOptions o;
+    if (!parseOptions(args, o, error)) return false;
+    std::vector<Opening> openings;
+    try {
+        openings = loadOpenings(o.openingsFile);
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    if (openings.empty()) {
+        error = "no usable openings";
+        return false;
+    }
+    std::unique_ptr<Bot> engines[2];
+    createEngines(o, engines);
+    wins = draws = losses = 0;
+    for (int game = first; game < first + count; ++game) {
+        std::string reason;
+        int plies = 0;
+        GameResult result = playMatchGame(o, openings, engines, game, reason, plies);
+        if (result == GameResult::DRAW) ++draws;
+        else if ((result == GameResult::WHITE_WINS) == (game % 2 == 0)) ++wins;
+        else ++losses;
+    }
+    return true;
+}
+
+void estimateElo(int wins, int draws, int losses, double& diff, double& margin) {
+    Tally tally;
+    tally.wins = wins;
+    tally.draws = draws;
+    tally.losses = losses;
+    tally.elo(diff, margin);
+}
@@ -0,0 +1,50 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Headless Bot-vs-Bot match runner ("selfplay" mode).
+ * @param args Command-line arguments after the mode name.
+ * @return Process exit code.
+ *
+ * Two engine configurations (A and B, differing in SearchParams or NNUE network) play each
+ * opening of a suite twice with colours reversed. Worker threads play independent games,
+ * every finished game is appended to the results file at once, and the running score is
+ * turned into an Elo difference with a 95% error bar. With --sprt the match stops as soon
+ * as a sequential probability ratio test accepts either hypothesis.
+ *
+ * Options:
+ *   --games N           Games to play at most (default 1000).
+ *   --concurrency N     Worker threads (default: hardware threads).
+ *   --tc BASE+INC       Clock per side in seconds, e.g. 10+0.1.
+ *   --movetime MS       Fixed time per move instead of a clock (default 100).
+ *   --depth D           Fixed depth per move.
+ *   --nodes N           Node budget per move.
+ *   --hash MB           Transposition table size per engine (default 8).
+ *   --openings FILE     One FEN/EPD position or coordinate move sequence per line.
+ *   --out FILE          Results file (default selfplay_results.txt).
+ *   --sprt ELO0 ELO1    Test H0: elo = ELO0 against H1: elo = ELO1.
+ *   --alpha A --beta B  SPRT error rates (default 0.05 each).
+ *   --a KEY=VALUE       Engine A option; --b likewise. Keys: the SearchParams fields in lower
+ *                       case (nullmove, lmr, futility, rfp, aspiration, ...), evalfile, name.
+ */
+int runSelfPlayMatch(const std::vector<std::string>& args);
+
+/**
+ * @brief Play games [first, first + count) of the match `args` describes, one after another
+ *        on the calling thread.
+ *
+ * Game numbers choose the opening and colours as in runSelfPlayMatch, so batches played
+ * elsewhere add up to the same schedule. --concurrency, --out and --sprt are accepted and
+ * ignored.
+ * @return False with `error` set if the options or the openings are unusable.
+ */
+bool playMatchGames(const std::vector<std::string>& args, int first, int count,
+    int& wins, int& draws, int& losses, std::string& error);
+
+/// Elo difference of engine A and the half-width of its 95% confidence interval.
+void estimateElo(int wins, int draws, int losses, double& diff, double& margin);
+
+#endif // MATCH_H
@@ -0,0 +1,313 @@
+/**
+ * @file MicroBench.cpp
+ * @brief Microbenchmarks of the Board, Piece and Bot hot paths, as a separate executable.
+ *
+ * Every benchmark runs one operation over the bench signature positions (Bench.h) and
+ * times it in several repetitions; the output is JSON so runs from different commits can be
+ * compared by a script. Each repetition repeats its pass over the corpus until it has run for
+ * at least the minimum time, so short operations are not measured at the clock's resolution.
+ *
+ * Usage: ChessMicroBench [--repetitions N] [--min-time MS] [--filter TEXT] [--out FILE]
+ */
+#include "Bench.h"
+#include "Board.h"
+#include "Bot.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+
+namespace {
+    // Results are folded in here so the compiler can't drop the work being measured.
+    std::uint64_t sink = 0;
+
+    struct Options {
+        int repetitions = 10;
+        double minTimeMs = 50;
+        std::string filter;
+        std::string outFile;
+        std::string scratchFile = "microbench_save.tmp";
+    };
+
+    // One operation over the corpus; returns how many times it performed the operation.
+    struct Benchmark {
+        std::string name;
+        std::function<long long()> pass;
+    };
+
+    struct Statistics {
+        double mean = 0, median = 0, min = 0, max = 0, stddev = 0;
+    };
+
+    Statistics summarize(std::vector<double> samples) {
+        Statistics s;
+        std::sort(samples.begin(), samples.end());
+        size_t n = samples.size();
+        s.min = samples.front();
+        s.max = samples.back();
+        s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+        s.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+        double squares = 0;
+        for (double v : samples) {
+            squares += (v - s.mean) * (v - s.mean);
+        }
+        s.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+        return s;
+    }
+
+    std::string pieceName(PieceType type) {
+        switch (type) {
+        case PieceType::PAWN: return "pawn";
+        case PieceType::KNIGHT: return "knight";
+        case PieceType::BISHOP: return "bishop";
+        case PieceType::ROOK: return "rook";
+        case PieceType::QUEEN: return "queen";
+        case PieceType::KING: return "king";
+        }
+        return "?";
+    }
+
+    std::string compilerName() {
+        std::ostringstream out;
+#if defined(__clang__)
+        out << "clang " << __clang_major__ << "." << __clang_minor__ << "." << __clang_patchlevel__;
+#elif defined(__GNUC__)
+        out << "gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "." << __GNUC_PATCHLEVEL__;
+#elif defined(_MSC_VER)
+        out << "msvc " << _MSC_VER;
+#else
+        out << "unknown";
+#endif
+        return out.str();
+    }
+
+    std::vector<Benchmark> makeBenchmarks(std::vector<Board>& corpus, Bot& bot, const Options& options) {
+        std::vector<Benchmark> benchmarks;
+        const PieceType types[] = {
+            PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN, PieceType::KING
+        };
+        for (PieceType type : types) {
+            benchmarks.push_back({ "Piece::getAllValidMoves/" + pieceName(type), [&corpus, type] {
+                long long ops = 0;
+                for (const Board& board : corpus) {
+                    for (const std::vector<Piece>* pieces : { &board.whitePieces, &board.blackPieces }) {
+                        for (const Piece& piece : *pieces) {
+                            if (!piece.isAlive() || piece.getType() != type) continue;
+                            sink += piece.getAllValidMoves(board).size();
+                            ++ops;
+                        }
+                    }
+                }
+                return ops;
+            } });
+        }
+        benchmarks.push_back({ "Board::isPlayerInCheck", [&corpus] {
+            for (const Board& board : corpus) {
+                sink += board.isPlayerInCheck(Color::WHITE) + 2 * board.isPlayerInCheck(Color::BLACK);
+            }
+            return static_cast<long long>(corpus.size()) * 2;
+        } });
+        benchmarks.push_back({ "Board::isCheckmate", [&corpus] {
+            for (const Board& board : corpus) {
+                sink += board.isCheckmate(board.currentPlayerColor);
+            }
+            return static_cast<long long>(corpus.size());
+        } });
+        benchmarks.push_back({ "Board::Board(const Board&)", [&corpus] {
+            for (const Board& board : corpus) {
+                Board copy(board);
+                sink += copy.getHashKey();
+            }
+            return static_cast<long long>(corpus.size());
+        } });
+        benchmarks.push_back({ "Board::getPieceById", [&corpus] {
+            for (Board& board : corpus) {
+                for (int id = 1; id <= 32; ++id) {
+                    Piece* piece = board.getPieceById(id);
+                    sink += piece ? static_cast<std::uint64_t>(piece->getX()) : 0;
+                }
+            }
+            return static_cast<long long>(corpus.size()) * 32;
+        } });
+        benchmarks.push_back({ "Bot::evaluateBoard", [&corpus, &bot] {
+            for (const Board& board : corpus) {
+                sink += static_cast<std::uint64_t>(bot.evaluateBoard(board));
+            }
+            return static_cast<long long>(corpus.size());
+        } });
+        benchmarks.push_back({ "Bot::validMoves", [&corpus, &bot] {
+            for (const Board& board : corpus) {
+                sink += bot.validMoves(board, board.currentPlayerColor).size();
+            }
+            return static_cast<long long>(corpus.size());
+        } });
+        benchmarks.push_back({ "Board::toFen+loadFromFen", [&corpus] {
+            Board loaded;
+            for (const Board& board : corpus) {
+                loaded.loadFromFen(board.toFen());
+                sink += loaded.getHashKey();
+            }
+            return static_cast<long long>(corpus.size());
+        } });
+        std::string scratch = options.scratchFile;
+        benchmarks.push_back({ "Board::saveToFile+loadFromFile", [&corpus, scratch] {
+            Board loaded;
+            for (const Board& board : corpus) {
+                board.saveToFile(scratch);
+                loaded.loadFromFile(scratch);
+                sink += loaded.getHashKey();
+            }
+            return static_cast<long long>(corpus.size());
+        } });
+        return benchmarks;
+    }
+
+    // The round trips must give the position back, or their timings mean nothing.
+    bool checkRoundTrips(const std::vector<Board>& corpus, const Options& options) {
+        for (const Board& board : corpus) {
+            Board viaFen, viaFile;
+            viaFen.loadFromFen(board.toFen());
+            board.saveToFile(options.scratchFile);
+            viaFile.loadFromFile(options.scratchFile);
+            Color side = board.currentPlayerColor;
+            if (viaFen.getPositionKey(viaFen.currentPlayerColor) != board.getPositionKey(side) ||
+                viaFile.getPositionKey(viaFile.currentPlayerColor) != board.getPositionKey(side)) {
+                std::cerr << "microbench: round trip changed " << board.toFen() << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double runPass(const Benchmark& benchmark, long long passes, long long& ops) {
+        ops = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < passes; ++i) {
+            ops += benchmark.pass();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void writeJson(std::ostream& out, const Options& options, size_t positions,
+        const std::vector<std::string>& names, const std::vector<long long>& opsPerRepetition,
+        const std::vector<std::vector<double>>& samples) {
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        out << std::fixed << std::setprecision(2);
+        out << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << date << "\",\n"
+            << "    \"compiler\": \"" << compilerName() << "\",\n"
+#ifdef NDEBUG
+            << "    \"build\": \"release\",\n"
+#else
+            << "    \"build\": \"debug\",\n"
+#endif
+            << "    \"positions\": " << positions << ",\n"
+            << "    \"repetitions\": " << options.repetitions << ",\n"
+            << "    \"min_time_ms\": " << options.minTimeMs << ",\n"
+            << "    \"checksum\": " << sink << "\n  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < names.size(); ++i) {
+            Statistics s = summarize(samples[i]);
+            out << (i ? "," : "") << "\n    {\n"
+                << "      \"name\": \"" << names[i] << "\",\n"
+                << "      \"ops_per_repetition\": " << opsPerRepetition[i] << ",\n"
+                << "      \"ns_per_op\": { \"mean\": " << s.mean << ", \"median\": " << s.median
+                << ", \"min\": " << s.min << ", \"max\": " << s.max << ", \"stddev\": " << s.stddev << " },\n"
+                << "      \"samples\": [";
+            for (size_t r = 0; r < samples[i].size(); ++r) {
+                out << (r ? ", " : "") << samples[i][r];
+            }
+            out << "]\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--repetitions" && hasValue) {
+                options.repetitions = std::max(1, std::atoi(argv[++i]));
+            }
+            else if (arg == "--min-time" && hasValue) {
+                options.minTimeMs = std::max(1.0, std::atof(argv[++i]));
+            }
+            else if (arg == "--filter" && hasValue) {
+                options.filter = argv[++i];
+            }
+            else if (arg == "--out" && hasValue) {
+                options.outFile = argv[++i];
+            }
+            else {
+                std::cerr << "microbench: unknown option " << arg << "\n"
+                    << "Usage: ChessMicroBench [--repetitions N] [--min-time MS] [--filter TEXT] [--out FILE]" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::vector<Board> corpus;
+    for (const std::string& fen : getBenchPositions()) {
+        corpus.emplace_back();
+        corpus.back().loadFromFen(fen);
+    }
+    Bot bot(Color::WHITE);
+    if (!checkRoundTrips(corpus, options)) {
+        std::remove(options.scratchFile.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    std::vector<long long> opsPerRepetition;
+    std::vector<std::vector<double>> samples;
+    for (const Benchmark& benchmark : makeBenchmarks(corpus, bot, options)) {
+        if (benchmark.name.find(options.filter) == std::string::npos) continue;
+        // Calibrate: double the passes until one repetition takes the minimum time (this also warms up).
+        long long passes = 1, ops = 0;
+        while (runPass(benchmark, passes, ops) < options.minTimeMs * 1e6 && passes < (1LL << 30)) {
+            passes *= 2;
+        }
+        std::vector<double> perOp;
+        for (int r = 0; r < options.repetitions; ++r) {
+            double ns = runPass(benchmark, passes, ops);
+            perOp.push_back(ops > 0 ? ns / ops : 0.0);
+        }
+        std::cerr << std::left << std::setw(34) << benchmark.name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << summarize(perOp).median << " ns/op" << std::endl;
+        names.push_back(benchmark.name);
+        opsPerRepetition.push_back(ops);
+        samples.push_back(perOp);
+    }
+    std::remove(options.scratchFile.c_str());
+
+    if (options.outFile.empty()) {
+        writeJson(std::cout, options, corpus.size(), names, opsPerRepetition, samples);
+    }
+    else {
+        std::ofstream out(options.outFile);
+        if (!out) {
+            std::cerr << "microbench: cannot write " << options.outFile << std::endl;
+            return 1;
+        }
+        writeJson(out, options, corpus.size(), names, opsPerRepetition, samples);
+    }
+    return 0;
+}
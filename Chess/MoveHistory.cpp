@@ -0,0 +1,43 @@
+/**
+ * @file MoveHistory.cpp
+ * @brief Recording, truncation and keyframe bookkeeping of MoveHistory.
+ */
+#include "MoveHistory.h"
+
+bool MoveHistory::needsKeyframe() const {
+    return current % KEYFRAME_INTERVAL == 0 && keyframeCount() == current / KEYFRAME_INTERVAL;
+}
+
+void MoveHistory::addKeyframe(const PositionKeyframe& keyframe) {
+    keyframes.push_back(keyframe);
+}
+
+void MoveHistory::record(const Move& move) {
+    // Keyframes up to the current ply describe positions before it and stay valid.
+    moves.resize(current);
+    if (keyframeCount() > current / KEYFRAME_INTERVAL + 1) {
+        keyframes.resize(current / KEYFRAME_INTERVAL + 1);
+    }
+    moves.push_back(move);
+    ++current;
+}
+
+void MoveHistory::setLastPromotion(PieceType type) {
+    if (current > 0 && moves[current - 1].promoted && moves[current - 1].promotedTo != type) {
+        // movePiece tested for check with the queen; that answer says nothing about the new piece.
+        moves[current - 1].promotedTo = type;
+        moves[current - 1].givesCheck = -1;
+    }
+}
+
+void MoveHistory::setLastCheck(bool check) {
+    if (current > 0) {
+        moves[current - 1].givesCheck = check ? 1 : 0;
+    }
+}
+
+void MoveHistory::clear() {
+    moves.clear();
+    keyframes.clear();
+    current = 0;
+}
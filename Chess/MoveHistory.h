@@ -0,0 +1,78 @@
+#ifndef MOVE_HISTORY_H
+#define MOVE_HISTORY_H
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "Piece.h"
+
+/**
+ * @struct Move
+ * @brief One executed move, with what it takes to undo or replay it.
+ *
+ * A captured piece is recorded by its slot (0-15 in whitePieces, 16-31 in blackPieces) rather
+ * than a pointer, so the record stays valid when the board is copied.
+ */
+struct Move {
+    int                      pieceId = 0;
+    std::pair<int, int>       from;
+    std::pair<int, int>       to;
+    int                      capturedSlot = -1;                   // -1 = nothing captured
+    bool                     promoted = false;                    // pawn was promoted by this move
+    PieceType                promotedTo = PieceType::QUEEN;       // ...to this piece
+    std::int8_t              givesCheck = -1;                     // 1 or 0 once movePiece has tested it
+};
+
+/**
+ * @struct PositionKeyframe
+ * @brief Snapshot of every piece slot and the side to move, for jumping within a game.
+ */
+struct PositionKeyframe {
+    std::array<std::uint16_t, 32> slots{};   ///< x | y << 3 | type << 6 | alive << 9 | off-board << 10, in slot order.
+    Color sideToMove = Color::WHITE;
+};
+
+/**
+ * @class MoveHistory
+ * @brief The moves of a game in one contiguous array, with a keyframe every KEYFRAME_INTERVAL plies.
+ *
+ * The board stands at ply() moves into the line. After jumping back, the later moves stay in
+ * the line (length() > ply()) so the game can be replayed forward; recording a new move there
+ * starts a new line from that point. Keyframe k is the position before move k * KEYFRAME_INTERVAL,
+ * so any ply is reached from a snapshot with fewer than KEYFRAME_INTERVAL unmakes or replays
+ * (half that inside the line).
+ * Iteration (begin/end, operator[]) covers the moves up to the current ply.
+ */
+class MoveHistory {
+public:
+    static const int KEYFRAME_INTERVAL = 16;
+
+    int ply() const { return current; }                          ///< Moves played to reach the board's position.
+    int length() const { return static_cast<int>(moves.size()); }  ///< Moves in the line, including any after ply().
+    bool empty() const { return current == 0; }
+    const Move& operator[](int index) const { return moves[index]; }  ///< Any index below length().
+    const Move& back() const { return moves[current - 1]; }     ///< Last move played; requires !empty().
+    const Move* begin() const { return moves.data(); }
+    const Move* end() const { return moves.data() + current; }
+
+    /// Does the position before the next move need a keyframe (see addKeyframe)?
+    bool needsKeyframe() const;
+    void addKeyframe(const PositionKeyframe& keyframe);
+    int keyframeCount() const { return static_cast<int>(keyframes.size()); }
+    const PositionKeyframe& keyframe(int index) const { return keyframes[index]; }
+
+    /// Play a move at ply(): discards the rest of the line and its keyframes, then appends.
+    void record(const Move& move);
+    void setLastPromotion(PieceType type);   ///< The player's choice for the move just recorded; forgets its check test.
+    void setLastCheck(bool check);           ///< Whether the move just recorded gave check.
+    void setPly(int ply) { current = ply; }  ///< 0 to length(); the board does the actual moving.
+    void clear();
+
+private:
+    std::vector<Move> moves;
+    std::vector<PositionKeyframe> keyframes;
+    int current = 0;
+};
+
+#endif // MOVE_HISTORY_H
@@ -0,0 +1,172 @@
+/**
+ * @file MovePicker.cpp
+ * @brief Implementation of the staged move picker used by the Bot search.
+ *
+ * Most nodes in an alpha-beta search are cut off after the first one or two moves, so the
+ * picker avoids generating (and especially legality-testing) moves that are never tried.
+ * The hash move is validated and returned without any generation, captures are generated
+ * and ordered next, and the quiet moves are only generated if everything before them failed
+ * to produce a cutoff.
+ */
+#include "MovePicker.h"
+#include <algorithm>
+
+namespace {
+    // Piece values used only for capture ordering (most valuable victim, least valuable attacker).
+    int orderValue(PieceType type) {
+        switch (type) {
+        case PieceType::PAWN:   return 1;
+        case PieceType::KNIGHT: return 3;
+        case PieceType::BISHOP: return 3;
+        case PieceType::ROOK:   return 5;
+        case PieceType::QUEEN:  return 9;
+        case PieceType::KING:   return 10;
+        }
+        return 0;
+    }
+}
+
+MovePicker::MovePicker(const Board& board, Color side, PackedMove hashMove, PackedMove killer1, PackedMove killer2)
+    : board(board) {
+    reset(side, hashMove, killer1, killer2);
+}
+
+MovePicker::MovePicker(const Board& board, Color side, PackedMove hashMove)
+    : board(board) {
+    resetCaptures(side, hashMove);
+}
+
+MovePicker::MovePicker(const Board& board)
+    : board(board), side(Color::WHITE), hashMove(0), killers{ 0, 0 }, capturesOnly(true), stage(Stage::DONE) {
+}
+
+void MovePicker::reset(Color side, PackedMove hashMove, PackedMove killer1, PackedMove killer2) {
+    this->side = side;
+    this->hashMove = hashMove;
+    killers[0] = killer1;
+    killers[1] = killer2;
+    capturesOnly = false;
+    stage = Stage::HASH_MOVE;
+    moves.clear();
+    index = 0;
+    killerIndex = 0;
+}
+
+void MovePicker::resetCaptures(Color side, PackedMove hashMove) {
+    reset(side, 0, 0, 0);
+    capturesOnly = true;
+    // Quiescence only searches noisy moves, so a quiet hash move is ignored.
+    if (hashMove && isPseudoLegal(hashMove) && isNoisy(hashMove)) {
+        this->hashMove = hashMove;
+    }
+}
+
+PackedMove MovePicker::nextMove() {
+    switch (stage) {
+    case Stage::HASH_MOVE:
+        stage = Stage::GENERATE_CAPTURES;
+        if (hashMove && (capturesOnly || isPseudoLegal(hashMove))) {
+            return hashMove;
+        }
+        hashMove = 0;
+        // fall through
+    case Stage::GENERATE_CAPTURES:
+        generate(MoveGenType::CAPTURES);
+        stage = Stage::CAPTURES;
+        // fall through
+    case Stage::CAPTURES:
+        while (index < moves.size()) {
+            // Selection sort step: only order as far as the search actually gets.
+            auto best = std::max_element(moves.begin() + index, moves.end(),
+                [](const ScoredMove& a, const ScoredMove& b) { return a.score < b.score; });
+            std::swap(*best, moves[index]);
+            PackedMove move = moves[index++].move;
+            if (move != hashMove) {
+                return move;
+            }
+        }
+        if (capturesOnly) {
+            stage = Stage::DONE;
+            return 0;
+        }
+        stage = Stage::KILLERS;
+        // fall through
+    case Stage::KILLERS:
+        while (killerIndex < 2) {
+            PackedMove killer = killers[killerIndex++];
+            if (killer && killer != hashMove && !isNoisy(killer) && isPseudoLegal(killer)) {
+                return killer;
+            }
+        }
+        stage = Stage::GENERATE_QUIETS;
+        // fall through
+    case Stage::GENERATE_QUIETS:
+        generate(MoveGenType::QUIETS);
+        stage = Stage::QUIETS;
+        // fall through
+    case Stage::QUIETS:
+        while (index < moves.size()) {
+            PackedMove move = moves[index++].move;
+            if (move != hashMove && move != killers[0] && move != killers[1]) {
+                return move;
+            }
+        }
+        stage = Stage::DONE;
+        // fall through
+    case Stage::DONE:
+        break;
+    }
+    return 0;
+}
+
+bool MovePicker::inQuietStage() const {
+    return stage == Stage::KILLERS || stage == Stage::GENERATE_QUIETS ||
+        stage == Stage::QUIETS || stage == Stage::DONE;
+}
+
+bool MovePicker::isPseudoLegal(PackedMove move) const {
+    Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+    if (!piece || piece->getColor() != side) {
+        return false;
+    }
+    scratch.clear();
+    piece->generateMoves(board, MoveGenType::ALL, scratch);
+    return std::find(scratch.begin(), scratch.end(),
+        std::make_pair(packedToX(move), packedToY(move))) != scratch.end();
+}
+
+bool MovePicker::isNoisy(PackedMove move) const {
+    if (board.getPieceAt(packedToX(move), packedToY(move))) {
+        return true;
+    }
+    Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+    int toY = packedToY(move);
+    return piece && piece->getType() == PieceType::PAWN && (toY == 0 || toY == 7);
+}
+
+void MovePicker::generate(MoveGenType genType) {
+    moves.clear();
+    index = 0;
+    const std::vector<Piece>& pieces = (side == Color::WHITE) ? board.whitePieces : board.blackPieces;
+    for (const Piece& piece : pieces) {
+        if (!piece.isAlive()) {
+            continue;
+        }
+        scratch.clear();
+        piece.generateMoves(board, genType, scratch);
+        for (const auto& target : scratch) {
+            ScoredMove scored;
+            scored.move = packMove(piece.getX(), piece.getY(), target.first, target.second);
+            scored.score = 0;
+            if (genType == MoveGenType::CAPTURES) {
+                Piece* victim = board.getPieceAt(target.first, target.second);
+                int victimValue = victim ? orderValue(victim->getType()) : 0;
+                if (piece.getType() == PieceType::PAWN && (target.second == 0 || target.second == 7)) {
+                    victimValue += orderValue(PieceType::QUEEN);
+                }
+                scored.score = victimValue * 16 - orderValue(piece.getType());
+            }
+            moves.push_back(scored);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef MOVE_PICKER_H
+#define MOVE_PICKER_H
+
+#include <vector>
+#include <utility>
+#include "Board.h"
+
+/**
+ * @class MovePicker
+ * @brief Hands out the moves of one search node in stages, generating each stage on demand.
+ *
+ * Order: hash move, captures (MVV-LVA), killer moves, then the remaining quiet moves.
+ * Moves are only pseudo-legal; the caller checks legality after making each one. The board
+ * must be back in the node's position (all tried moves undone) whenever nextMove is called.
+ */
+class MovePicker {
+public:
+    /**
+     * @brief Picker for a full-width node.
+     * @param board    Position to pick moves in.
+     * @param side     Side to move.
+     * @param hashMove Best move from the transposition table (0 if none).
+     * @param killer1  First killer move for this ply (0 if none).
+     * @param killer2  Second killer move for this ply (0 if none).
+     */
+    MovePicker(const Board& board, Color side, PackedMove hashMove, PackedMove killer1, PackedMove killer2);
+
+    /**
+     * @brief Picker for a quiescence node: hash move (if noisy) and captures only.
+     */
+    MovePicker(const Board& board, Color side, PackedMove hashMove);
+
+    /**
+     * @brief Exhausted picker on `board`; call reset() or resetCaptures() before use.
+     */
+    explicit MovePicker(const Board& board);
+
+    void reset(Color side, PackedMove hashMove, PackedMove killer1, PackedMove killer2);
+    ///< Start over as a full-width picker at another node, reusing the move buffers.
+    void resetCaptures(Color side, PackedMove hashMove);
+    ///< Start over as a quiescence picker at another node.
+
+    PackedMove nextMove();           ///< Next move to try, or 0 when exhausted.
+    bool inQuietStage() const;       ///< True once the picker hands out killers/quiets.
+
+private:
+    enum class Stage { HASH_MOVE, GENERATE_CAPTURES, CAPTURES, KILLERS, GENERATE_QUIETS, QUIETS, DONE };
+
+    struct ScoredMove {
+        PackedMove move;
+        int        score;
+    };
+
+    bool isPseudoLegal(PackedMove move) const;   ///< Piece of `side` on from-square can reach to-square.
+    bool isNoisy(PackedMove move) const;         ///< Capture or promotion.
+    void generate(MoveGenType genType);          ///< Fill `moves` with one class of moves.
+
+    const Board& board;
+    Color side;
+    PackedMove hashMove;
+    PackedMove killers[2];
+    bool capturesOnly;
+
+    Stage stage{ Stage::HASH_MOVE };
+    std::vector<ScoredMove> moves;
+    std::size_t index{ 0 };
+    int killerIndex{ 0 };
+    mutable std::vector<std::pair<int, int>> scratch;  ///< Reused target-square buffer.
+};
+
+#endif // MOVE_PICKER_H
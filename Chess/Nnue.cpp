@@ -0,0 +1,403 @@
+/**
+ * @file Nnue.cpp
+ * @brief Loading and evaluation of the optional NNUE network.
+ *
+ * The weights are memory-mapped rather than read so that several processes (and every
+ * thread in this one) share a single read-only copy. Kernels use AVX2 or SSSE3 when the
+ * compiler targets them and fall back to plain loops otherwise; all three produce
+ * bit-identical results.
+ */
+#include "Nnue.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_USE_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define NNUE_USE_SSSE3
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const std::size_t HEADER_SIZE = 64;
+    const std::uint32_t FILE_VERSION = 1;
+    const int WEIGHT_SHIFT = 6;        // hidden layers: int8 weights scaled by 64
+    const int OUTPUT_SCALE = 16;       // network output units per centipawn
+
+    std::size_t alignUp(std::size_t n) {
+        return (n + 63) & ~static_cast<std::size_t>(63);
+    }
+
+    std::mutex defaultMutex;
+    std::shared_ptr<const NnueNetwork> defaultNetwork;
+
+    // --- Kernels ---
+
+    void addColumn(std::int16_t* acc, const std::int16_t* column) {
+#if defined(NNUE_USE_AVX2)
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; i += 16) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, w));
+        }
+#elif defined(NNUE_USE_SSSE3)
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; i += 8) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, w));
+        }
+#else
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; ++i) {
+            acc[i] = static_cast<std::int16_t>(acc[i] + column[i]);
+        }
+#endif
+    }
+
+    void subColumn(std::int16_t* acc, const std::int16_t* column) {
+#if defined(NNUE_USE_AVX2)
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; i += 16) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, w));
+        }
+#elif defined(NNUE_USE_SSSE3)
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; i += 8) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, w));
+        }
+#else
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; ++i) {
+            acc[i] = static_cast<std::int16_t>(acc[i] - column[i]);
+        }
+#endif
+    }
+
+    // Clipped ReLU of an int16 half into [0, 127] bytes.
+    void clampHalf(const std::int16_t* in, std::uint8_t* out) {
+#if defined(NNUE_USE_AVX2)
+        const __m256i zero = _mm256_setzero_si256();
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; i += 32) {
+            __m256i a = _mm256_max_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), zero);
+            __m256i b = _mm256_max_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16)), zero);
+            __m256i packed = _mm256_packus_epi16(a, b);
+            packed = _mm256_min_epu8(packed, _mm256_set1_epi8(127));
+            // packus works per 128-bit lane; restore element order.
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+#elif defined(NNUE_USE_SSSE3)
+        const __m128i zero = _mm_setzero_si128();
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; i += 16) {
+            __m128i a = _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), zero);
+            __m128i b = _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)), zero);
+            __m128i packed = _mm_min_epu8(_mm_packus_epi16(a, b), _mm_set1_epi8(127));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+        }
+#else
+        for (int i = 0; i < NnueNetwork::HALF_DIMS; ++i) {
+            out[i] = static_cast<std::uint8_t>(std::min<int>(std::max<int>(in[i], 0), 127));
+        }
+#endif
+    }
+
+    // Dot product of `n` unsigned activations with signed int8 weights (n a multiple of 32).
+    std::int32_t dot(const std::uint8_t* in, const std::int8_t* w, int n) {
+#if defined(NNUE_USE_AVX2)
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < n; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, b), ones));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        return _mm_cvtsi128_si32(s);
+#elif defined(NNUE_USE_SSSE3)
+        const __m128i ones = _mm_set1_epi16(1);
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < n; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(a, b), ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+#else
+        std::int32_t sum = 0;
+        for (int i = 0; i < n; ++i) {
+            sum += static_cast<std::int32_t>(in[i]) * w[i];
+        }
+        return sum;
+#endif
+    }
+
+    // Fully connected layer followed by clipped ReLU.
+    void hiddenLayer(const std::uint8_t* in, int inDims, const std::int32_t* bias,
+        const std::int8_t* weights, int outDims, std::uint8_t* out) {
+        for (int o = 0; o < outDims; ++o) {
+            std::int32_t v = (bias[o] + dot(in, weights + o * inDims, inDims)) >> WEIGHT_SHIFT;
+            out[o] = static_cast<std::uint8_t>(std::min(std::max(v, 0), 127));
+        }
+    }
+
+    // Squares are oriented so that each side sees its own back rank as rank 0.
+    int orient(int perspective, int square) {
+        return perspective == 0 ? (square ^ 56) : square;
+    }
+
+    int featureIndex(int perspective, int kingSquare, int color, int type, int square) {
+        int kind = type * 2 + (color == perspective ? 0 : 1);
+        return (orient(perspective, kingSquare) * NnueNetwork::PIECE_KINDS + kind) * 64
+            + orient(perspective, square);
+    }
+
+    int kingSquare(const Board& board, int color) {
+        const std::vector<Piece>& pieces = (color == 0) ? board.whitePieces : board.blackPieces;
+        for (const Piece& p : pieces) {
+            if (p.isAlive() && p.getType() == PieceType::KING) {
+                return p.getY() * 8 + p.getX();
+            }
+        }
+        return 0;
+    }
+}
+
+NnueNetwork::~NnueNetwork() {
+#ifdef _WIN32
+    if (mapped) UnmapViewOfFile(mapped);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+#else
+    if (mapped) munmap(const_cast<void*>(mapped), mappedSize);
+#endif
+}
+
+std::shared_ptr<const NnueNetwork> NnueNetwork::load(const std::string& path, std::string& error) {
+    std::shared_ptr<NnueNetwork> net(new NnueNetwork());
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    net->fileHandle = file;
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    net->mappedSize = static_cast<std::size_t>(size.QuadPart);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        error = "cannot map " + path;
+        return nullptr;
+    }
+    net->mappingHandle = mapping;
+    net->mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        error = "cannot stat " + path;
+        return nullptr;
+    }
+    net->mappedSize = static_cast<std::size_t>(st.st_size);
+    void* addr = mmap(nullptr, net->mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // the mapping keeps the file alive
+    net->mapped = (addr == MAP_FAILED) ? nullptr : addr;
+#endif
+    if (!net->mapped) {
+        error = "cannot map " + path;
+        return nullptr;
+    }
+
+    // Validate the header and that every section fits.
+    const unsigned char* base = static_cast<const unsigned char*>(net->mapped);
+    std::uint32_t fields[4];
+    if (net->mappedSize < HEADER_SIZE || std::memcmp(base, "CNUE", 4) != 0) {
+        error = path + " is not a network file";
+        return nullptr;
+    }
+    std::memcpy(fields, base + 4, sizeof(fields));
+    if (fields[0] != FILE_VERSION || fields[1] != HALF_DIMS || fields[2] != L1 || fields[3] != L2) {
+        error = path + " has an unsupported version or layer sizes";
+        return nullptr;
+    }
+
+    // The file only has to reach the end of the last section, not the padding after it.
+    std::size_t offset = HEADER_SIZE;
+    std::size_t end = HEADER_SIZE;
+    auto section = [&](std::size_t bytes) {
+        const unsigned char* p = base + offset;
+        end = offset + bytes;
+        offset = alignUp(end);
+        return p;
+        };
+    net->ftBias = reinterpret_cast<const std::int16_t*>(section(sizeof(std::int16_t) * HALF_DIMS));
+    net->ftWeights = reinterpret_cast<const std::int16_t*>(
+        section(sizeof(std::int16_t) * static_cast<std::size_t>(INPUTS) * HALF_DIMS));
+    net->l1Bias = reinterpret_cast<const std::int32_t*>(section(sizeof(std::int32_t) * L1));
+    net->l1Weights = reinterpret_cast<const std::int8_t*>(section(L1 * 2 * HALF_DIMS));
+    net->l2Bias = reinterpret_cast<const std::int32_t*>(section(sizeof(std::int32_t) * L2));
+    net->l2Weights = reinterpret_cast<const std::int8_t*>(section(L2 * L1));
+    net->outBias = reinterpret_cast<const std::int32_t*>(section(sizeof(std::int32_t)));
+    net->outWeights = reinterpret_cast<const std::int8_t*>(section(L2));
+    if (end > net->mappedSize) {
+        error = path + " is truncated";
+        return nullptr;
+    }
+    return net;
+}
+
+void NnueNetwork::setDefault(std::shared_ptr<const NnueNetwork> network) {
+    std::lock_guard<std::mutex> lock(defaultMutex);
+    defaultNetwork = network;
+}
+
+std::shared_ptr<const NnueNetwork> NnueNetwork::getDefault() {
+    std::lock_guard<std::mutex> lock(defaultMutex);
+    return defaultNetwork;
+}
+
+NnueEvaluator::NnueEvaluator(std::shared_ptr<const NnueNetwork> network, int maxDepth)
+    : network(network), stack(maxDepth + 1) {
+}
+
+const NnueNetwork& NnueEvaluator::getNetwork() const {
+    return *network;
+}
+
+void NnueEvaluator::reset(const Board& board) {
+    top = 0;
+    Accumulator& acc = stack[0];
+    acc.changeCount = 0;
+    acc.kingMoved[0] = acc.kingMoved[1] = false;
+    refresh(board, acc, 0);
+    refresh(board, acc, 1);
+}
+
+void NnueEvaluator::push(const Board& board, PackedMove move) {
+    Accumulator& acc = stack[++top];
+    acc.computed[0] = acc.computed[1] = false;
+    acc.kingMoved[0] = acc.kingMoved[1] = false;
+    acc.changeCount = 0;
+
+    int from = packedFromY(move) * 8 + packedFromX(move);
+    int to = packedToY(move) * 8 + packedToX(move);
+    Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+    Piece* captured = board.getPieceAt(packedToX(move), packedToY(move));
+    if (!piece) {
+        return;
+    }
+    int color = piece->getColor() == Color::WHITE ? 0 : 1;
+    if (captured) {
+        acc.changes[acc.changeCount++] = { captured->getColor() == Color::WHITE ? 0 : 1,
+            static_cast<int>(captured->getType()), to, -1 };
+    }
+    if (piece->getType() == PieceType::KING) {
+        // Kings aren't features; moving one re-bases that side's whole half instead.
+        acc.kingMoved[color] = true;
+        return;
+    }
+    int toY = packedToY(move);
+    bool promotion = piece->getType() == PieceType::PAWN && (toY == 0 || toY == 7);
+    if (promotion) {
+        acc.changes[acc.changeCount++] = { color, static_cast<int>(PieceType::PAWN), from, -1 };
+        acc.changes[acc.changeCount++] = { color, static_cast<int>(PieceType::QUEEN), -1, to };
+    }
+    else {
+        acc.changes[acc.changeCount++] = { color, static_cast<int>(piece->getType()), from, to };
+    }
+}
+
+void NnueEvaluator::pop() {
+    if (top > 0) {
+        --top;
+    }
+}
+
+int NnueEvaluator::evaluate(const Board& board, Color sideToMove) {
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        if (!stack[top].computed[perspective]) {
+            update(top, perspective, board);
+        }
+    }
+    const Accumulator& acc = stack[top];
+    int us = sideToMove == Color::WHITE ? 0 : 1;
+
+    std::uint8_t input[2 * NnueNetwork::HALF_DIMS];
+    std::uint8_t hidden1[NnueNetwork::L1];
+    std::uint8_t hidden2[NnueNetwork::L2];
+    clampHalf(acc.values[us], input);
+    clampHalf(acc.values[1 - us], input + NnueNetwork::HALF_DIMS);
+    hiddenLayer(input, 2 * NnueNetwork::HALF_DIMS, network->l1Bias, network->l1Weights, NnueNetwork::L1, hidden1);
+    hiddenLayer(hidden1, NnueNetwork::L1, network->l2Bias, network->l2Weights, NnueNetwork::L2, hidden2);
+    std::int32_t output = network->outBias[0] + dot(hidden2, network->outWeights, NnueNetwork::L2);
+    return output / OUTPUT_SCALE;
+}
+
+void NnueEvaluator::refresh(const Board& board, Accumulator& acc, int perspective) const {
+    std::int16_t* values = acc.values[perspective];
+    std::memcpy(values, network->ftBias, sizeof(acc.values[perspective]));
+    int king = kingSquare(board, perspective);
+    for (int color = 0; color < 2; ++color) {
+        const std::vector<Piece>& pieces = (color == 0) ? board.whitePieces : board.blackPieces;
+        for (const Piece& p : pieces) {
+            if (!p.isAlive() || p.getType() == PieceType::KING) continue;
+            int index = featureIndex(perspective, king, color, static_cast<int>(p.getType()),
+                p.getY() * 8 + p.getX());
+            addColumn(values, network->ftWeights + static_cast<std::size_t>(index) * NnueNetwork::HALF_DIMS);
+        }
+    }
+    acc.computed[perspective] = true;
+}
+
+void NnueEvaluator::update(int index, int perspective, const Board& board) {
+    // Walk back to the nearest usable accumulator; a king move of this side in between
+    // means the old values are in a different king bucket, so refresh instead.
+    int start = index;
+    while (!stack[start].computed[perspective]) {
+        if (stack[start].kingMoved[perspective] || start == 0) {
+            refresh(board, stack[index], perspective);
+            return;
+        }
+        --start;
+    }
+    int king = kingSquare(board, perspective);
+    for (int i = start + 1; i <= index; ++i) {
+        Accumulator& acc = stack[i];
+        std::memcpy(acc.values[perspective], stack[i - 1].values[perspective], sizeof(acc.values[perspective]));
+        for (int c = 0; c < acc.changeCount; ++c) {
+            const FeatureChange& change = acc.changes[c];
+            if (change.from >= 0) {
+                int f = featureIndex(perspective, king, change.color, change.type, change.from);
+                subColumn(acc.values[perspective], network->ftWeights + static_cast<std::size_t>(f) * NnueNetwork::HALF_DIMS);
+            }
+            if (change.to >= 0) {
+                int f = featureIndex(perspective, king, change.color, change.type, change.to);
+                addColumn(acc.values[perspective], network->ftWeights + static_cast<std::size_t>(f) * NnueNetwork::HALF_DIMS);
+            }
+        }
+        acc.computed[perspective] = true;
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Board.h"
+
+/**
+ * @class NnueNetwork
+ * @brief Read-only, memory-mapped weights of an efficiently updatable neural network.
+ *
+ * Architecture (HalfKP-like): for each side, 64 king squares x 64 piece squares x 10 non-king
+ * piece kinds (5 types, own/enemy) = 40960 sparse inputs feed a 256-wide int16 feature
+ * transformer. The two halves (side to move first) go through clipped ReLU into int8 layers
+ * 512 -> 32 -> 32 -> 1. One network can be shared by any number of evaluators and threads.
+ *
+ * File layout (little endian, every section starting on a 64-byte boundary):
+ *   header   : char[4] "CNUE", uint32 version (1), uint32 halfDims, uint32 l1, uint32 l2, pad to 64
+ *   int16    ftBias[256], ftWeights[40960][256]
+ *   int32    l1Bias[32];  int8 l1Weights[32][512]
+ *   int32    l2Bias[32];  int8 l2Weights[32][32]
+ *   int32    outBias;     int8 outWeights[32]
+ */
+class NnueNetwork {
+public:
+    static const int PIECE_KINDS = 10;
+    static const int INPUTS = 64 * 64 * PIECE_KINDS;
+    static const int HALF_DIMS = 256;
+    static const int L1 = 32;
+    static const int L2 = 32;
+
+    ~NnueNetwork();
+    NnueNetwork(const NnueNetwork&) = delete;
+    NnueNetwork& operator=(const NnueNetwork&) = delete;
+
+    /**
+     * @brief Map a weights file into memory.
+     * @param path  File to load.
+     * @param error Receives a description of the problem on failure.
+     * @return The network, or nullptr if the file is missing or malformed.
+     */
+    static std::shared_ptr<const NnueNetwork> load(const std::string& path, std::string& error);
+
+    static void setDefault(std::shared_ptr<const NnueNetwork> network);  ///< Network new Bots start with.
+    static std::shared_ptr<const NnueNetwork> getDefault();
+
+    const std::int16_t* ftBias{ nullptr };
+    const std::int16_t* ftWeights{ nullptr };
+    const std::int32_t* l1Bias{ nullptr };
+    const std::int8_t*  l1Weights{ nullptr };
+    const std::int32_t* l2Bias{ nullptr };
+    const std::int8_t*  l2Weights{ nullptr };
+    const std::int32_t* outBias{ nullptr };
+    const std::int8_t*  outWeights{ nullptr };
+
+private:
+    NnueNetwork() = default;
+
+    const void* mapped{ nullptr };
+    std::size_t mappedSize{ 0 };
+#ifdef _WIN32
+    void* fileHandle{ nullptr };
+    void* mappingHandle{ nullptr };
+#endif
+};
+
+/**
+ * @class NnueEvaluator
+ * @brief Per-search accumulator stack over a shared NnueNetwork.
+ *
+ * The search calls push() just before making a move and pop() after undoing it. push() only
+ * records which features change; the accumulator is brought up to date lazily (a few vector
+ * adds from the nearest computed ancestor) when a position is actually evaluated. King moves
+ * force a full refresh of that side's half, since every one of its features depends on the
+ * king square.
+ */
+class NnueEvaluator {
+public:
+    explicit NnueEvaluator(std::shared_ptr<const NnueNetwork> network, int maxDepth = 128);
+
+    void reset(const Board& board);              ///< Full refresh for a new root position.
+    void push(const Board& board, PackedMove move);  ///< Before board makes `move`.
+    void pop();                                  ///< After the board undoes it.
+    int evaluate(const Board& board, Color sideToMove);  ///< Centipawns for the side to move.
+
+    const NnueNetwork& getNetwork() const;
+
+private:
+    struct FeatureChange {
+        int color;       ///< 0 = white, 1 = black
+        int type;        ///< PieceType as int
+        int from;        ///< Square removed from (-1 = none)
+        int to;          ///< Square added on (-1 = none)
+    };
+
+    struct Accumulator {
+        std::int16_t values[2][NnueNetwork::HALF_DIMS];
+        bool computed[2];
+        bool kingMoved[2];               ///< Moving side's king moved: its half needs a refresh.
+        FeatureChange changes[3];
+        int changeCount;
+    };
+
+    void refresh(const Board& board, Accumulator& acc, int perspective) const;
+    void update(int index, int perspective, const Board& board);
+
+    std::shared_ptr<const NnueNetwork> network;
+    std::vector<Accumulator> stack;
+    int top{ 0 };
+};
+
+#endif // NNUE_H
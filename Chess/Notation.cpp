@@ -0,0 +1,166 @@
+/**
+ * @file Notation.cpp
+ * @brief Legal move lists and conversion between packed moves and SAN / coordinate text.
+ *
+ * SAN is produced by comparing a move with every other legal move of the same piece type
+ * landing on the same square, which gives exactly the disambiguation the standard asks for.
+ */
+#include "Notation.h"
+#include "Trace.h"
+#include "Bot.h"
+#include <cstdlib>
+
+namespace {
+    char pieceLetter(PieceType type) {
+        switch (type) {
+        case PieceType::KNIGHT: return 'N';
+        case PieceType::BISHOP: return 'B';
+        case PieceType::ROOK:   return 'R';
+        case PieceType::QUEEN:  return 'Q';
+        case PieceType::KING:   return 'K';
+        default:                return 0;
+        }
+    }
+
+    bool isPromotion(const Board& board, PackedMove move) {
+        Piece* piece = board.getPieceAt(packedFromX(move), packedFromY(move));
+        int toY = packedToY(move);
+        return piece && piece->getType() == PieceType::PAWN && (toY == 0 || toY == 7);
+    }
+
+    std::string stripMarks(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c != '+' && c != '#' && c != '!' && c != '?') out += c;
+        }
+        return out;
+    }
+
+    long long perftFrom(Board& board, Color side, int depth) {
+        Color other = side == Color::WHITE ? Color::BLACK : Color::WHITE;
+        const std::vector<Piece>& pieces = (side == Color::WHITE) ? board.whitePieces : board.blackPieces;
+        std::vector<std::pair<int, int>> targets;
+        long long count = 0;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            if (!pieces[i].isAlive()) continue;
+            int id = pieces[i].getId();
+            targets.clear();
+            pieces[i].generateMoves(board, MoveGenType::ALL, targets);
+            for (const auto& t : targets) {
+                board.makeMoveForCheck(id, t.first, t.second);
+                if (!board.isPlayerInCheck(side)) {
+                    count += depth == 1 ? 1 : perftFrom(board, other, depth - 1);
+                }
+                board.undoMoveForCheck();
+            }
+        }
+        return count;
+    }
+}
+
+std::vector<PackedMove> generateLegalMoves(const Board& board, Color side) {
+    PROFILE_SCOPE(Phase::LEGALITY);
+    std::vector<PackedMove> moves;
+    std::vector<std::pair<int, int>> targets;
+    const std::vector<Piece>& pieces = (side == Color::WHITE) ? board.whitePieces : board.blackPieces;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        const Piece& piece = pieces[i];
+        if (!piece.isAlive()) continue;
+        int fx = piece.getX(), fy = piece.getY();
+        targets.clear();
+        piece.generateMoves(board, MoveGenType::ALL, targets);
+        for (const auto& t : targets) {
+            if (!board.leavesKingInCheck(fx, fy, t.first, t.second)) moves.push_back(packMove(fx, fy, t.first, t.second));
+        }
+    }
+    return moves;
+}
+
+long long perft(const Board& position, int depth) {
+    if (depth <= 0) return 1;
+    Board board = position;
+    return perftFrom(board, board.currentPlayerColor, depth);
+}
+
+std::string moveToSan(const Board& board, PackedMove move) {
+    int fx = packedFromX(move), fy = packedFromY(move);
+    int tx = packedToX(move), ty = packedToY(move);
+    Piece* piece = board.getPieceAt(fx, fy);
+    if (!piece) return packedMoveToString(move);
+    Color side = piece->getColor();
+    bool capture = board.getPieceAt(tx, ty) != nullptr;
+    std::string target = packedMoveToString(move).substr(2);
+
+    std::string san;
+    if (piece->getType() == PieceType::PAWN) {
+        if (capture) {
+            san += char('a' + fx);
+            san += 'x';
+        }
+        san += target;
+        if (isPromotion(board, move)) san += "=Q";
+    }
+    else {
+        san += pieceLetter(piece->getType());
+        // Disambiguate against other pieces of the same type that can reach the same square.
+        bool sameFile = false, sameRank = false, ambiguous = false;
+        for (PackedMove other : generateLegalMoves(board, side)) {
+            if (other == move || packedToX(other) != tx || packedToY(other) != ty) continue;
+            Piece* p = board.getPieceAt(packedFromX(other), packedFromY(other));
+            if (p->getType() != piece->getType()) continue;
+            ambiguous = true;
+            if (packedFromX(other) == fx) sameFile = true;
+            if (packedFromY(other) == fy) sameRank = true;
+        }
+        if (ambiguous) {
+            if (!sameFile) san += char('a' + fx);
+            else if (!sameRank) san += char('8' - fy);
+            else { san += char('a' + fx); san += char('8' - fy); }
+        }
+        if (capture) san += 'x';
+        san += target;
+    }
+
+    Board after = board;
+    after.makeMoveForCheck(piece->getId(), tx, ty);
+    Color them = side == Color::WHITE ? Color::BLACK : Color::WHITE;
+    if (after.isPlayerInCheck(them)) {
+        san += after.hasLegalMove(them) ? '+' : '#';
+    }
+    return san;
+}
+
+std::string moveToUci(const Board& board, PackedMove move) {
+    if (!move) return "0000";
+    std::string text = packedMoveToString(move);
+    if (isPromotion(board, move)) text += 'q';
+    return text;
+}
+
+std::string scoreToUci(int score) {
+    if (score >= Bot::MATE_SCORE - Bot::MAX_PLY || score <= -Bot::MATE_SCORE + Bot::MAX_PLY) {
+        int moves = (Bot::MATE_SCORE - std::abs(score) + 1) / 2;
+        return "mate " + std::to_string(score < 0 ? -moves : moves);
+    }
+    return "cp " + std::to_string(score);
+}
+
+PackedMove parseMove(const Board& board, const std::string& text) {
+    std::string wanted = stripMarks(text);
+    if (wanted.empty()) return 0;
+    std::vector<PackedMove> moves = generateLegalMoves(board, board.currentPlayerColor);
+    for (PackedMove move : moves) {
+        std::string coord = packedMoveToString(move);
+        if (wanted == coord || (isPromotion(board, move) && wanted == coord + "q")) return move;
+    }
+    for (PackedMove move : moves) {
+        if (stripMarks(moveToSan(board, move)) == wanted) return move;
+    }
+    // Accept the "=" less promotion form ("e8Q") some suites use.
+    for (PackedMove move : moves) {
+        std::string san = stripMarks(moveToSan(board, move));
+        size_t eq = san.find('=');
+        if (eq != std::string::npos && san.substr(0, eq) + san.substr(eq + 1) == wanted) return move;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <string>
+#include <vector>
+#include "Board.h"
+
+/**
+ * @brief All legal moves of `side` in a position, as packed moves.
+ *
+ * Promotions appear once (the board always promotes to a queen). Castling and en passant
+ * are not part of this engine's rules and never appear.
+ */
+std::vector<PackedMove> generateLegalMoves(const Board& board, Color side);
+
+/**
+ * @brief Number of move sequences `depth` plies long from a position (perft), side to move first.
+ *
+ * Counts by this engine's rules: positions where castling, en passant or under-promotion
+ * would be legal give lower numbers than the published perft tables.
+ */
+long long perft(const Board& board, int depth);
+
+/**
+ * @brief Standard algebraic notation ("Nf3", "exd5", "e8=Q+", "Qh4#") of a legal move.
+ */
+std::string moveToSan(const Board& board, PackedMove move);
+
+/**
+ * @brief UCI coordinate notation of a move: "e2e4", "e7e8q" for a promotion (the board always
+ *        promotes to a queen), "0000" for no move.
+ */
+std::string moveToUci(const Board& board, PackedMove move);
+
+/**
+ * @brief UCI score of a search result: "cp 35", or "mate 3" / "mate -2" (moves, not plies).
+ */
+std::string scoreToUci(int score);
+
+/**
+ * @brief Find the legal move written in SAN ("Nbd7", "exd5", "e8=Q") or coordinate
+ *        notation ("e2e4", "e7e8q") for the side to move.
+ * @return The move, or 0 if no legal move matches. Check, mate and annotation marks
+ *         (+ # ! ?) are ignored.
+ */
+PackedMove parseMove(const Board& board, const std::string& text);
+
+#endif // NOTATION_H
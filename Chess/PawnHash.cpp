@@ -0,0 +1,173 @@
+/**
+ * @file PawnHash.cpp
+ * @brief Pawn-structure evaluation and its hash table.
+ *
+ * Terms: passed pawns (by advancement), isolated, doubled and backward pawns, and the pawn
+ * shelter in front of each possible king zone. Everything here depends only on pawn
+ * placement, so the results are cached by the pawn-only Zobrist key.
+ */
+#include "PawnHash.h"
+#include <algorithm>
+
+namespace {
+    const int DOUBLED_PENALTY = 15;
+    const int ISOLATED_PENALTY = 15;
+    const int BACKWARD_PENALTY = 10;
+    // Indexed by ranks advanced from the pawn's starting rank (0 = still on it).
+    const int PASSED_BONUS[7] = { 5, 10, 20, 35, 60, 100, 0 };
+    const int SHIELD_NEAR = 10;      // own pawn one rank in front of the king's back rank
+    const int SHIELD_FAR = 5;        // own pawn two ranks in front
+    const int SHIELD_MISSING = 15;   // no own pawn on the file at all near the king
+
+    inline std::uint64_t bit(int x, int y) {
+        return 1ULL << (y * 8 + x);
+    }
+
+    std::uint64_t fileMask(int x) {
+        return 0x0101010101010101ULL << x;
+    }
+
+    std::uint64_t adjacentFiles(int x) {
+        std::uint64_t mask = 0;
+        if (x > 0) mask |= fileMask(x - 1);
+        if (x < 7) mask |= fileMask(x + 1);
+        return mask;
+    }
+
+    // Squares strictly in front of rank y from `color`'s point of view (White moves towards y = 0).
+    std::uint64_t frontRanks(Color color, int y) {
+        std::uint64_t mask = 0;
+        if (color == Color::WHITE) {
+            for (int r = 0; r < y; ++r) mask |= 0xFFULL << (r * 8);
+        }
+        else {
+            for (int r = y + 1; r < 8; ++r) mask |= 0xFFULL << (r * 8);
+        }
+        return mask;
+    }
+
+    int sign(Color color) {
+        return color == Color::WHITE ? 1 : -1;
+    }
+}
+
+PawnHashTable::PawnHashTable(std::size_t entryCount) {
+    std::size_t count = 1;
+    while (count * 2 <= std::max<std::size_t>(entryCount, 1)) {
+        count *= 2;
+    }
+    entries.assign(count, PawnEntry());
+    mask = count - 1;
+}
+
+const PawnEntry& PawnHashTable::probe(const Board& board) {
+    std::uint64_t key = board.getPawnKey();
+    PawnEntry& entry = entries[key & mask];
+    ++probes;
+    if (entry.valid && entry.key == key) {
+        ++hits;
+        return entry;
+    }
+    evaluate(board, entry);
+    entry.key = key;
+    entry.valid = true;
+    return entry;
+}
+
+void PawnHashTable::clear() {
+    std::fill(entries.begin(), entries.end(), PawnEntry());
+}
+
+void PawnHashTable::resetStats() {
+    probes = 0;
+    hits = 0;
+}
+
+long long PawnHashTable::getProbes() const {
+    return probes;
+}
+
+long long PawnHashTable::getHits() const {
+    return hits;
+}
+
+void PawnHashTable::evaluate(const Board& board, PawnEntry& entry) {
+    entry = PawnEntry();
+
+    // Collect pawn locations and attack masks.
+    for (int c = 0; c < 2; ++c) {
+        const std::vector<Piece>& pieces = (c == 0) ? board.whitePieces : board.blackPieces;
+        int forward = (c == 0) ? -1 : 1;
+        for (const Piece& p : pieces) {
+            if (!p.isAlive() || p.getType() != PieceType::PAWN) continue;
+            int x = p.getX(), y = p.getY();
+            entry.pawns[c] |= bit(x, y);
+            int ay = y + forward;
+            if (ay >= 0 && ay < 8) {
+                if (x > 0) entry.attacks[c] |= bit(x - 1, ay);
+                if (x < 7) entry.attacks[c] |= bit(x + 1, ay);
+            }
+        }
+    }
+
+    for (int c = 0; c < 2; ++c) {
+        Color color = (c == 0) ? Color::WHITE : Color::BLACK;
+        int them = 1 - c;
+        std::uint64_t own = entry.pawns[c];
+        std::uint64_t enemy = entry.pawns[them];
+        int forward = (c == 0) ? -1 : 1;
+        int startRank = (c == 0) ? 6 : 1;
+        int score = 0;
+
+        for (int sq = 0; sq < 64; ++sq) {
+            if (!(own & (1ULL << sq))) continue;
+            int x = sq % 8, y = sq / 8;
+            std::uint64_t front = frontRanks(color, y);
+
+            // Doubled: another own pawn ahead on the same file.
+            if (own & fileMask(x) & front) {
+                score -= DOUBLED_PENALTY;
+            }
+            // Isolated: no own pawns on either neighbouring file.
+            bool isolated = !(own & adjacentFiles(x));
+            if (isolated) {
+                score -= ISOLATED_PENALTY;
+            }
+            // Passed: no enemy pawn ahead on this or a neighbouring file.
+            if (!(enemy & (fileMask(x) | adjacentFiles(x)) & front)) {
+                entry.passed[c] |= 1ULL << sq;
+                int advanced = (y - startRank) * forward;
+                score += PASSED_BONUS[std::min(std::max(advanced, 0), 6)];
+            }
+            // Backward: neighbours are all ahead of it and its stop square is covered by an enemy pawn.
+            else if (!isolated) {
+                std::uint64_t behindOrLevel = ~front;
+                int stopY = y + forward;
+                bool supported = (own & adjacentFiles(x) & behindOrLevel) != 0;
+                if (!supported && stopY >= 0 && stopY < 8 && (entry.attacks[them] & bit(x, stopY))) {
+                    score -= BACKWARD_PENALTY;
+                }
+            }
+        }
+        entry.score += sign(color) * score;
+
+        // King shelter for each zone: own pawns one or two ranks in front of the back rank.
+        int backRank = (c == 0) ? 7 : 0;
+        static const int zoneFiles[3][3] = { { 0, 1, 2 }, { 2, 3, 4 }, { 5, 6, 7 } };
+        for (int zone = 0; zone < 3; ++zone) {
+            int shield = 0;
+            for (int x : zoneFiles[zone]) {
+                if (own & bit(x, backRank + forward)) {
+                    shield += SHIELD_NEAR;
+                }
+                else if (own & bit(x, backRank + 2 * forward)) {
+                    shield += SHIELD_FAR;
+                }
+                else if (!(own & fileMask(x))) {
+                    shield -= SHIELD_MISSING;
+                }
+            }
+            entry.shield[c][zone] = shield;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef PAWN_HASH_H
+#define PAWN_HASH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Board.h"
+
+/**
+ * @struct PawnEntry
+ * @brief Cached evaluation of one pawn structure (both colors), indexed by Board::getPawnKey.
+ *
+ * Square masks use bit (y * 8 + x), matching Board coordinates (y = 0 is Black's back rank).
+ * Scores are in centipawns from White's point of view.
+ */
+struct PawnEntry {
+    std::uint64_t key = 0;
+    bool          valid = false;
+    int           score = 0;              ///< Passed/isolated/doubled/backward terms.
+    int           shield[2][3] = {};      ///< [color][zone] king-shelter score (zone: files a-c, d-e, f-h).
+    std::uint64_t pawns[2] = {};          ///< [color] pawn locations.
+    std::uint64_t attacks[2] = {};        ///< [color] squares attacked by that color's pawns.
+    std::uint64_t passed[2] = {};         ///< [color] passed pawns.
+};
+
+/**
+ * @class PawnHashTable
+ * @brief Small direct-mapped cache of pawn-structure evaluations.
+ *
+ * Pawn structure changes on few moves, so nearly every leaf finds its structure here and the
+ * pawn terms cost one lookup instead of a full scan.
+ */
+class PawnHashTable {
+public:
+    explicit PawnHashTable(std::size_t entryCount = 16384);  ///< Rounded down to a power of two.
+
+    /**
+     * @brief Return the entry for the board's pawn structure, computing it on a miss.
+     */
+    const PawnEntry& probe(const Board& board);
+
+    void clear();                        ///< Forget all entries (statistics are kept).
+    void resetStats();
+    long long getProbes() const;
+    long long getHits() const;
+
+    static void evaluate(const Board& board, PawnEntry& entry);  ///< Full pawn-structure scan.
+
+private:
+    std::vector<PawnEntry> entries;
+    std::size_t mask{ 0 };
+    long long probes{ 0 };
+    long long hits{ 0 };
+};
+
+#endif // PAWN_HASH_H
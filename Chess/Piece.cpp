@@ -10,9 +10,11 @@
  * Pawn (including initial double move and diagonal captures), Knight (L-shaped moves),
  * Bishop (diagonal moves), Rook (straight moves), Queen (straight and diagonal moves),
  * and King (adjacent one-square moves). It does not handle special moves like castling or en passant.
+ * Moves can also be generated by class (captures/promotions or quiets) for the staged search.
  */
 #include "Piece.h"
 #include "Board.h"
+#include "Trace.h"
 #include <array>
 #include <cctype>
 
@@ -85,9 +87,30 @@ bool Piece::isMoveValid(int newX, int newY, const Board& board) const {
 
 std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) const {
     std::vector<std::pair<int, int>> validMoves;
+    generateMoves(board, MoveGenType::ALL, validMoves);
+    return validMoves;
+}
+
+void Piece::generateMoves(const Board& board, MoveGenType genType,
+    std::vector<std::pair<int, int>>& validMoves) const {
+    PROFILE_SCOPE(Phase::MOVE_GENERATION);
     int xPos = getX();
     int yPos = getY();
 
+    // Append a destination if it belongs to the requested move class. Captures and pawn
+    // promotions are "noisy" and generated first by the search; everything else is quiet.
+    auto addMove = [&](int newX, int newY) {
+        if (genType != MoveGenType::ALL) {
+            bool isCapture = board.getSquareStatus(newX, newY).isOccupied;
+            bool isPromotion = (type == PieceType::PAWN && (newY == 0 || newY == 7));
+            bool isNoisy = isCapture || isPromotion;
+            if (isNoisy != (genType == MoveGenType::CAPTURES)) {
+                return;
+            }
+        }
+        validMoves.emplace_back(newX, newY);
+        };
+
     // Determine moves based on the type of the piece.
     switch (type) {
     case PieceType::PAWN: {
@@ -99,7 +122,7 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
         // Single step forward.
         int forwardY = yPos + direction;
         if (isMoveValid(xPos, forwardY, board) && !board.getSquareStatus(xPos, forwardY).isOccupied) {
-            validMoves.emplace_back(xPos, forwardY);
+            addMove(xPos, forwardY);
 
             // Double step forward from starting position (only if single step was valid and start position).
             if (yPos == startRow) {
@@ -107,7 +130,7 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
                 if (isMoveValid(xPos, doubleStepY, board) &&
                     !board.getSquareStatus(xPos, doubleStepY).isOccupied &&
                     !board.getSquareStatus(xPos, forwardY).isOccupied) {
-                    validMoves.emplace_back(xPos, doubleStepY);
+                    addMove(xPos, doubleStepY);
                 }
             }
         }
@@ -119,7 +142,7 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
             if (isMoveValid(diagX, diagY, board)) {
                 SquareStatus status = board.getSquareStatus(diagX, diagY);
                 if (status.isOccupied && status.pieceColor != getColor()) {
-                    validMoves.emplace_back(diagX, diagY);
+                    addMove(diagX, diagY);
                 }
             }
         }
@@ -145,7 +168,7 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
                 SquareStatus status = board.getSquareStatus(newX, newY);
                 // Knight can jump: if target square is empty or has enemy piece, it's a valid move.
                 if (!status.isOccupied || status.pieceColor != getColor()) {
-                    validMoves.emplace_back(newX, newY);
+                    addMove(newX, newY);
                 }
             }
         }
@@ -167,12 +190,12 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
                 SquareStatus status = board.getSquareStatus(currX, currY);
                 if (!status.isOccupied) {
                     // Empty square: bishop can move here and continue further in this direction.
-                    validMoves.emplace_back(currX, currY);
+                    addMove(currX, currY);
                 }
                 else {
                     // Occupied: if by enemy piece, it can be captured (include move, then stop); if by same color, stop.
                     if (status.pieceColor != getColor()) {
-                        validMoves.emplace_back(currX, currY);
+                        addMove(currX, currY);
                     }
                     break;  // Stop moving further in this direction when blocked.
                 }
@@ -197,11 +220,11 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
             while (isMoveValid(currX, currY, board)) {
                 SquareStatus status = board.getSquareStatus(currX, currY);
                 if (!status.isOccupied) {
-                    validMoves.emplace_back(currX, currY);
+                    addMove(currX, currY);
                 }
                 else {
                     if (status.pieceColor != getColor()) {
-                        validMoves.emplace_back(currX, currY);
+                        addMove(currX, currY);
                     }
                     break;
                 }
@@ -230,11 +253,11 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
             while (isMoveValid(currX, currY, board)) {
                 SquareStatus status = board.getSquareStatus(currX, currY);
                 if (!status.isOccupied) {
-                    validMoves.emplace_back(currX, currY);
+                    addMove(currX, currY);
                 }
                 else {
                     if (status.pieceColor != getColor()) {
-                        validMoves.emplace_back(currX, currY);
+                        addMove(currX, currY);
                     }
                     break;
                 }
@@ -263,7 +286,7 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
             if (isMoveValid(newX, newY, board)) {
                 SquareStatus status = board.getSquareStatus(newX, newY);
                 if (!status.isOccupied || status.pieceColor != getColor()) {
-                    validMoves.emplace_back(newX, newY);
+                    addMove(newX, newY);
                 }
             }
         }
@@ -273,7 +296,5 @@ std::vector<std::pair<int, int>> Piece::getAllValidMoves(const Board& board) con
     default:
         break;
     }
-
-    return validMoves;
 }
 
@@ -6,6 +6,7 @@
 
 enum class Color { WHITE, BLACK };
 enum class PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+enum class MoveGenType { ALL, CAPTURES, QUIETS };  ///< Subset of moves to generate
 
 class Board;  // forward declaration to avoid circular include
 
@@ -39,6 +40,15 @@ public:
      */
     std::vector<std::pair<int, int>> getAllValidMoves(const Board& board) const;
 
+    /**
+     * @brief Append the destinations of one move class to an existing list.
+     * @param board   Current board state for occupancy checks.
+     * @param genType CAPTURES (captures and promotions), QUIETS (the rest) or ALL.
+     * @param out     List the (x,y) target squares are appended to.
+     */
+    void generateMoves(const Board& board, MoveGenType genType,
+        std::vector<std::pair<int, int>>& out) const;
+
     /**
      * @brief Basic move validity: in-bounds and not landing on friendly.
      * @param newX  Target file
@@ -7,9 +7,11 @@
  */
 #include "Player.h"
 #include "Board.h"
+#include "Trace.h"
 #include <iostream>
 #include <cctype>
 #include <unordered_map>
+#include <chrono>
 
 Player::Player(Color color, bool isHuman) {
     this->playerColor = color;
@@ -69,9 +71,34 @@ std::pair<std::pair<int, int>, std::pair<int, int>> Player::userInput() {
     return { {sourceX, sourceY}, {targetX, targetY} };
 }
 
+namespace {
+    // Adds the time between construction (or resume()) and pause() or destruction to `total`.
+    class ValidationTimer {
+    public:
+        explicit ValidationTimer(long long& total) : total(total) { total = 0; resume(); }
+        ~ValidationTimer() { pause(); }
+        void pause() {
+            if (!running) return;
+            total += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            running = false;
+        }
+        void resume() {
+            start = std::chrono::steady_clock::now();
+            running = true;
+        }
+
+    private:
+        long long& total;
+        std::chrono::steady_clock::time_point start;
+        bool running = false;
+    };
+}
+
 bool Player::makeMove(Board& board) {
     // Get the move coordinates from the user.
     auto moveCoords = userInput();
+    ValidationTimer timer(lastValidationMicros);
 
     int currentX = moveCoords.first.first;
     int currentY = moveCoords.first.second;
@@ -109,10 +136,8 @@ bool Player::makeMove(Board& board) {
         return false;
     }
 
-    // Use a copy of the board to test if the move would put the player's own king in check.
-    Board testBoard = board;
-    testBoard.movePiece(piece->getId(), moveToX, moveToY);
-    if (testBoard.isPlayerInCheck(this->playerColor)) {
+    // Test if the move would put the player's own king in check.
+    if (board.leavesKingInCheck(piece->getX(), piece->getY(), moveToX, moveToY)) {
         std::cerr << "Move would put your own king in check. Invalid move." << std::endl;
         return false;
     }
@@ -132,32 +157,33 @@ bool Player::makeMove(Board& board) {
         if (piece->getType() == PieceType::PAWN && (moveToY == 0 || moveToY == 7)) {
             char choice;
             std::cout << "Pawn reached the end of the board. Promote to (Q)ueen, (R)ook, (B)ishop, or k(N)ight? ";
+            timer.pause();
             std::cin >> choice;
+            timer.resume();
             choice = std::tolower(choice);
             switch (choice) {
             case 'q':
-                piece->setType(PieceType::QUEEN);
+                board.promotePiece(piece->getId(), PieceType::QUEEN);
                 break;
             case 'r':
-                piece->setType(PieceType::ROOK);
+                board.promotePiece(piece->getId(), PieceType::ROOK);
                 break;
             case 'b':
-                piece->setType(PieceType::BISHOP);
+                board.promotePiece(piece->getId(), PieceType::BISHOP);
                 break;
             case 'n':
-                piece->setType(PieceType::KNIGHT);
+                board.promotePiece(piece->getId(), PieceType::KNIGHT);
                 break;
             default:
                 std::cout << "Invalid choice. Promoting to Queen by default." << std::endl;
-                piece->setType(PieceType::QUEEN);
+                board.promotePiece(piece->getId(), PieceType::QUEEN);
                 break;
             }
         }
-        // Check if opponent is in check or checkmate after this move.
-        Color opponentColor = (this->playerColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
-        if (board.isPlayerInCheck(opponentColor)) {
+        // Check if opponent is in check or checkmate after this move (movePiece has tested both).
+        if (board.isPlayerChecked()) {
             std::cout << "You have put the opponent in check!" << std::endl;
-            if (board.isCheckmate(opponentColor)) {
+            if (!board.isGameRunning()) {
                 std::cout << "Checkmate! You win!" << std::endl;
                 board.setGameRunning(false);
             }
@@ -171,6 +197,7 @@ bool Player::makeMove(Board& board) {
 }
 
 std::unordered_map<int, std::vector<std::pair<int, int>>> Player::validMoves(const Board& board) const {
+    PROFILE_SCOPE(Phase::LEGALITY);
     std::unordered_map<int, std::vector<std::pair<int, int>>> pieceMovesMap;
     Color color = this->getColor();
 
@@ -183,9 +210,7 @@ std::unordered_map<int, std::vector<std::pair<int, int>>> Player::validMoves(con
                 std::vector<std::pair<int, int>> moves = piece->getAllValidMoves(board);
                 std::vector<std::pair<int, int>> legalMoves;
                 for (const auto& mv : moves) {
-                    Board testBoard = board;
-                    testBoard.movePiece(piece->getId(), mv.first, mv.second);
-                    if (!testBoard.isPlayerInCheck(color)) {
+                    if (!board.leavesKingInCheck(x, y, mv.first, mv.second)) {
                         legalMoves.push_back(mv);
                     }
                 }
@@ -198,6 +223,10 @@ std::unordered_map<int, std::vector<std::pair<int, int>>> Player::validMoves(con
     return pieceMovesMap;
 }
 
+long long Player::getLastValidationMicros() const {
+    return lastValidationMicros;
+}
+
 Color Player::getColor() const {
     return playerColor;
 }
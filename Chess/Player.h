@@ -29,6 +29,9 @@ public:
     // Attempt a move; may throw SaveGameException or QuitGameException
     virtual bool makeMove(Board& board);
 
+    // Time the last makeMove() spent validating and playing the move, not waiting for input
+    long long getLastValidationMicros() const;
+
     // Get all legal moves for each piece (excluding moves into check)
     std::unordered_map<int, std::vector<std::pair<int, int>>> validMoves(const Board& board) const;
 
@@ -51,6 +54,7 @@ private:
     Color playerColor;
     bool human;
     std::vector<Piece*> capturedPieces;
+    long long lastValidationMicros = 0;
 
     // Convert PieceType to string for display
     std::string pieceTypeToString(PieceType type) const;
@@ -0,0 +1,92 @@
+/**
+ * @file SearchScheduler.cpp
+ * @brief Earliest-deadline-first time slicing of resumable Bot searches, by priority class.
+ */
+#include "SearchScheduler.h"
+#include <algorithm>
+
+SearchScheduler::SearchScheduler(int workerCount, long long sliceNodes)
+    : sliceNodes(std::max(1LL, sliceNodes)) {
+    if (workerCount <= 0) {
+        workerCount = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+SearchScheduler::~SearchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    taskReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void SearchScheduler::submit(Bot& bot, const Board& board, Clock::time_point deadline, Completion done,
+    int priority) {
+    bot.beginSearch(board);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Task task{ &bot, priority, deadline, nextTurn++, std::move(done) };
+        ready.push_back(std::move(task));
+        std::push_heap(ready.begin(), ready.end(), runsLater);
+    }
+    taskReady.notify_one();
+}
+
+void SearchScheduler::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return ready.empty() && running == 0; });
+}
+
+int SearchScheduler::getWorkerCount() const {
+    return int(workers.size());
+}
+
+long long SearchScheduler::getSliceCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slices;
+}
+
+bool SearchScheduler::runsLater(const Task& a, const Task& b) {
+    if (a.priority != b.priority) return a.priority > b.priority;
+    if (a.deadline != b.deadline) return a.deadline > b.deadline;
+    return a.turn > b.turn;
+}
+
+void SearchScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskReady.wait(lock, [this] { return shuttingDown || !ready.empty(); });
+        if (ready.empty()) {
+            return;   // shutting down with nothing left to do
+        }
+        std::pop_heap(ready.begin(), ready.end(), runsLater);
+        Task task = std::move(ready.back());
+        ready.pop_back();
+        ++running;
+        ++slices;
+        lock.unlock();
+
+        bool finished = task.bot->runSlice(sliceNodes);
+        if (finished && task.done) {
+            task.done(*task.bot);
+        }
+
+        lock.lock();
+        --running;
+        if (!finished) {
+            // Back in line behind the searches due at the same time.
+            task.turn = nextTurn++;
+            ready.push_back(std::move(task));
+            std::push_heap(ready.begin(), ready.end(), runsLater);
+        }
+        else if (ready.empty() && running == 0) {
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef SEARCH_SCHEDULER_H
+#define SEARCH_SCHEDULER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include "Bot.h"
+
+/**
+ * @class SearchScheduler
+ * @brief Interleaves many resumable Bot searches on a few worker threads.
+ *
+ * A worker takes the search with the earliest deadline, runs it for one slice of nodes with
+ * Bot::runSlice() and puts it back unless it finished. Searches with equal deadlines take
+ * turns in submission order, which makes the scheduler plain round robin. An optional
+ * priority class ranks above the deadline, so overdue background work never runs ahead of
+ * a more urgent class. A search's time
+ * budget only counts the slices it actually ran (see Bot::runSlice()); the deadline decides
+ * which search runs, not how long it thinks. Scheduled searches run on one thread each, so
+ * the Bots' Lazy SMP helpers are not used.
+ */
+class SearchScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Completion = std::function<void(Bot& bot)>;   ///< Called on a worker when a search ends.
+
+    /**
+     * @param workers    Worker threads (0 = hardware threads).
+     * @param sliceNodes Nodes a search may run before the next-due search gets its turn.
+     */
+    explicit SearchScheduler(int workers = 0, long long sliceNodes = 1024);
+    ~SearchScheduler();   ///< Finishes the submitted searches, then joins the workers.
+
+    SearchScheduler(const SearchScheduler&) = delete;
+    SearchScheduler& operator=(const SearchScheduler&) = delete;
+
+    /**
+     * @brief Start searching `board` with `bot` (its limits and params as set).
+     *
+     * The bot must stay alive and otherwise unused until `done` has been called.
+     */
+    void submit(Bot& bot, const Board& board, Clock::time_point deadline, Completion done = Completion(),
+        int priority = 0);           ///< Lower priority classes run first.
+    void wait();                     ///< Block until every submitted search has finished.
+    int getWorkerCount() const;
+    long long getSliceCount() const; ///< Slices run so far.
+
+private:
+    struct Task {
+        Bot* bot;
+        int priority;
+        Clock::time_point deadline;
+        std::uint64_t turn;          ///< Tie-break: lower goes first, renewed after every slice.
+        Completion done;
+    };
+
+    static bool runsLater(const Task& a, const Task& b);
+    void workerLoop();
+
+    long long sliceNodes;
+    std::vector<std::thread> workers;
+    std::vector<Task> ready;         ///< Min-heap on (priority, deadline, turn).
+    mutable std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable idle;
+    std::uint64_t nextTurn{ 0 };
+    long long slices{ 0 };
+    int running{ 0 };
+    bool shuttingDown{ false };
+};
+
+#endif // SEARCH_SCHEDULER_H
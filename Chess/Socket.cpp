@@ -0,0 +1,234 @@
+/**
+ * @file Socket.cpp
+ * @brief TCP helpers over Winsock or BSD sockets.
+ */
+#include "Socket.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+#include <cstring>
+
+namespace {
+    sockaddr_in loopbackAddress(int port) {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<unsigned short>(port));
+        return addr;
+    }
+
+    // Replies are single short lines; don't let Nagle hold them back.
+    void setNoDelay(SocketHandle s) {
+        int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+    }
+}
+
+bool initSockets() {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    // A client that disconnects mid-reply must not kill the process.
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+}
+
+void closeSocket(SocketHandle s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+SocketHandle listenLoopback(int port, int& boundPort) {
+    return listenOn("127.0.0.1", port, boundPort);
+}
+
+SocketHandle listenOn(const std::string& address, int port, int& boundPort) {
+    sockaddr_in addr = loopbackAddress(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) return INVALID_SOCKET_HANDLE;
+    SocketHandle s = static_cast<SocketHandle>(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (s == INVALID_SOCKET_HANDLE) return INVALID_SOCKET_HANDLE;
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+    if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, 128) != 0) {
+        closeSocket(s);
+        return INVALID_SOCKET_HANDLE;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(s, reinterpret_cast<sockaddr*>(&addr), &len);
+    boundPort = ntohs(addr.sin_port);
+    return s;
+}
+
+SocketHandle acceptClient(SocketHandle listener) {
+    SocketHandle s = static_cast<SocketHandle>(accept(listener, nullptr, nullptr));
+    if (s != INVALID_SOCKET_HANDLE) setNoDelay(s);
+    return s;
+}
+
+SocketHandle connectLoopback(int port) {
+    return connectTo("127.0.0.1", port);
+}
+
+SocketHandle connectTo(const std::string& host, int port) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0 || !found) {
+        return INVALID_SOCKET_HANDLE;
+    }
+    SocketHandle s = static_cast<SocketHandle>(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (s != INVALID_SOCKET_HANDLE && connect(s, found->ai_addr, static_cast<int>(found->ai_addrlen)) != 0) {
+        closeSocket(s);
+        s = INVALID_SOCKET_HANDLE;
+    }
+    freeaddrinfo(found);
+    if (s != INVALID_SOCKET_HANDLE) setNoDelay(s);
+    return s;
+}
+
+bool sendAll(SocketHandle s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = static_cast<int>(send(s, data.data() + sent, static_cast<int>(data.size() - sent), 0));
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+int pollReadable(const std::vector<SocketHandle>& sockets, std::vector<bool>& readable, int timeoutMs) {
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> fds(sockets.size());
+#else
+    std::vector<pollfd> fds(sockets.size());
+#endif
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        fds[i].fd = sockets[i];
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+#ifdef _WIN32
+    int ready = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+    int ready = poll(fds.data(), fds.size(), timeoutMs);
+#endif
+    readable.assign(sockets.size(), false);
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        readable[i] = (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    }
+    return ready;
+}
+
+bool LineReader::readLines(std::vector<std::string>& lines) {
+    char buffer[4096];
+    int n = static_cast<int>(recv(socket, buffer, sizeof(buffer), 0));
+    if (n <= 0) return false;
+    pending.append(buffer, static_cast<size_t>(n));
+    size_t start = 0, end;
+    while ((end = pending.find('\n', start)) != std::string::npos) {
+        std::string line = pending.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+        start = end + 1;
+    }
+    pending.erase(0, start);
+    return true;
+}
+
+void LineServer::run(SocketHandle listener, const std::atomic<bool>& running, const LineHandler& onLine,
+    const DropHandler& onDrop, const std::function<void()>& beforePoll) {
+    std::vector<SocketHandle> sockets;
+    std::vector<std::uint32_t> ids;
+    std::vector<bool> readable;
+    std::vector<std::string> lines;
+    while (running) {
+        sockets.assign(1, listener);
+        ids.assign(1, 0);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& entry : connections) {
+                sockets.push_back(entry.second->socket);
+                ids.push_back(entry.first);
+            }
+        }
+        if (beforePoll) beforePoll();
+        // The timeout only bounds how long stopping the server waits for this loop.
+        if (pollReadable(sockets, readable, 100) <= 0) continue;
+
+        if (readable[0]) {
+            SocketHandle client = acceptClient(listener);
+            if (client != INVALID_SOCKET_HANDLE) {
+                std::lock_guard<std::mutex> lock(mutex);
+                connections[nextConnection++] = std::make_shared<Connection>(client);
+            }
+        }
+        for (size_t i = 1; i < sockets.size(); ++i) {
+            if (!readable[i]) continue;
+            std::shared_ptr<Connection> connection = find(ids[i]);
+            if (!connection) continue;
+            lines.clear();
+            bool alive = connection->reader.readLines(lines);
+            for (const std::string& line : lines) {
+                onLine(ids[i], line);
+            }
+            if (!alive) onDrop(ids[i]);
+        }
+    }
+}
+
+void LineServer::send(std::uint32_t id, const std::string& line) {
+    std::shared_ptr<Connection> connection = find(id);
+    if (!connection) return;
+    std::lock_guard<std::mutex> lock(connection->sendMutex);
+    if (connection->open) sendAll(connection->socket, line + "\n");
+}
+
+bool LineServer::close(std::uint32_t id) {
+    std::shared_ptr<Connection> connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = connections.find(id);
+        if (it == connections.end()) return false;
+        connection = it->second;
+        connections.erase(it);
+    }
+    std::lock_guard<std::mutex> lock(connection->sendMutex);
+    connection->open = false;
+    closeSocket(connection->socket);
+    return true;
+}
+
+void LineServer::closeAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : connections) {
+        closeSocket(entry.second->socket);
+    }
+    connections.clear();
+}
+
+std::shared_ptr<LineServer::Connection> LineServer::find(std::uint32_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = connections.find(id);
+    return it == connections.end() ? nullptr : it->second;
+}
@@ -0,0 +1,108 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @file Socket.h
+ * @brief Minimal TCP helpers shared by the server modes (Winsock or BSD sockets).
+ *
+ * The servers listen on 127.0.0.1; only the distributed coordinator and its workers use
+ * other addresses. Every protocol on top of this is line based: one command or reply per '\n'-terminated line.
+ */
+
+#ifdef _WIN32
+typedef std::uintptr_t SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+const SocketHandle INVALID_SOCKET_HANDLE = static_cast<SocketHandle>(-1);
+
+bool initSockets();                                   ///< Once per process (WSAStartup on Windows).
+void closeSocket(SocketHandle socket);
+SocketHandle listenLoopback(int port, int& boundPort); ///< Listen on 127.0.0.1; port 0 picks a free one.
+SocketHandle acceptClient(SocketHandle listener);
+SocketHandle connectLoopback(int port);
+SocketHandle listenOn(const std::string& address, int port, int& boundPort); ///< IPv4 address, "0.0.0.0" = all interfaces.
+SocketHandle connectTo(const std::string& host, int port);                  ///< Host name or IPv4 address.
+bool sendAll(SocketHandle socket, const std::string& data);
+
+/**
+ * @brief Wait until sockets are readable.
+ * @param sockets   Sockets to watch.
+ * @param readable  Receives one flag per socket (also set on hang-up or error).
+ * @param timeoutMs -1 waits forever.
+ * @return Number of ready sockets, 0 on timeout, -1 on error.
+ */
+int pollReadable(const std::vector<SocketHandle>& sockets, std::vector<bool>& readable, int timeoutMs);
+
+/**
+ * @class LineReader
+ * @brief Splits the byte stream of one socket into lines.
+ */
+class LineReader {
+public:
+    explicit LineReader(SocketHandle socket) : socket(socket) {}
+
+    /**
+     * @brief Read what is available (blocking once) and append complete lines to `lines`.
+     * @return False once the peer has closed the connection or an error occurred.
+     */
+    bool readLines(std::vector<std::string>& lines);
+
+private:
+    SocketHandle socket;
+    std::string pending;
+};
+
+/**
+ * @class LineServer
+ * @brief The client connections of a line-based server, multiplexed on one network thread.
+ *
+ * run() accepts clients on the listener and passes each complete line to the line handler on
+ * the calling thread, identified by a connection ID (from 1, never reused). send() and close()
+ * may be called from any thread; each connection's writes are serialised.
+ */
+class LineServer {
+public:
+    typedef std::function<void(std::uint32_t connection, const std::string& line)> LineHandler;
+    typedef std::function<void(std::uint32_t connection)> DropHandler;
+
+    /**
+     * @brief Serve until `running` turns false (checked at least every 100 ms).
+     * @param onLine     Called for every line received.
+     * @param onDrop     Called when a client hangs up; it is expected to close() the connection.
+     * @param beforePoll Optional; called before every wait for input (e.g. for periodic flushing).
+     */
+    void run(SocketHandle listener, const std::atomic<bool>& running, const LineHandler& onLine,
+        const DropHandler& onDrop, const std::function<void()>& beforePoll = nullptr);
+    void send(std::uint32_t connection, const std::string& line);  ///< Appends '\n'; ignored once closed.
+    bool close(std::uint32_t connection);  ///< False if it was already closed.
+    void closeAll();
+
+private:
+    struct Connection {
+        SocketHandle socket;
+        LineReader reader;
+        std::mutex sendMutex;
+        bool open{ true };
+
+        explicit Connection(SocketHandle s) : socket(s), reader(s) {}
+    };
+
+    std::shared_ptr<Connection> find(std::uint32_t connection);
+
+    std::mutex mutex;    ///< Guards the table; a connection's sendMutex guards its socket.
+    std::unordered_map<std::uint32_t, std::shared_ptr<Connection>> connections;
+    std::uint32_t nextConnection{ 1 };
+};
+
+#endif // SOCKET_H
@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads running queued tasks in submission order.
+ *
+ * Tasks receive the index of the worker running them (0 .. size()-1), so callers can keep
+ * expensive per-thread state such as a Bot and its hash table in an array indexed by it.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void(std::size_t worker)>;
+
+    explicit ThreadPool(std::size_t threads);
+    ~ThreadPool();   ///< Finishes the queued tasks, then joins the workers.
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+    void wait();     ///< Block until the queue is empty and no task is running.
+    std::size_t size() const;
+
+private:
+    void workerLoop(std::size_t index);
+
+    std::vector<std::thread> workers;
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable idle;
+    std::size_t running{ 0 };
+    bool shuttingDown{ false };
+};
+
+#endif // THREAD_POOL_H
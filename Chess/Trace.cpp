@@ -0,0 +1,155 @@
+/**
+ * @file Trace.cpp
+ * @brief Phase names, and trace-event recording when built with CHESS_TRACE.
+ *
+ * Each thread appends to its own buffer (locked only against the final write), so tracing
+ * many search threads doesn't serialise them. A buffer holds the last MAX_EVENTS events of
+ * its thread: the slow move being investigated is usually the latest one, and a scope's
+ * event is recorded when it ends, so the enclosing phases of the kept events are kept too.
+ * The number of older events overwritten is written into the trace's metadata.
+ */
+#include "Trace.h"
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::BOT_MOVE: return "bot move";
+    case Phase::SEARCH_ITERATION: return "search iteration";
+    case Phase::MOVE_GENERATION: return "move generation";
+    case Phase::LEGALITY: return "legality";
+    case Phase::EVALUATION: return "evaluation";
+    case Phase::CHECKMATE: return "checkmate detection";
+    case Phase::MOVE_EXECUTION: return "move execution";
+    case Phase::BOARD_COPY: return "board copy";
+    case Phase::BOARD_DISPLAY: return "board display";
+    case Phase::SAVE_LOAD: return "save/load";
+    case Phase::COUNT: break;
+    }
+    return "other";
+}
+
+#ifdef CHESS_TRACE
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    const std::size_t MAX_EVENTS = 1 << 20;   // per thread, about 32 MB
+
+    struct Event {
+        std::int64_t startNs;
+        std::int64_t durationNs;
+        const char* argName;
+        long long argValue;
+        Phase phase;
+    };
+
+    struct ThreadBuffer {
+        std::mutex mutex;
+        int tid = 0;
+        std::vector<Event> events;
+        std::size_t next = 0;              // oldest event once the buffer is full
+    };
+
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::string outputPath;
+    std::atomic<long long> dropped{ 0 };
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    bool atExitRegistered = false;
+
+    ThreadBuffer& threadBuffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+            auto b = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            b->tid = static_cast<int>(buffers.size()) + 1;
+            buffers.push_back(b);
+            return b;
+        }();
+        return *buffer;
+    }
+
+    void writeEvent(std::ostream& out, const Event& e, int tid) {
+        char times[96];
+        std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", e.startNs / 1000.0, e.durationNs / 1000.0);
+        out << ",\n{\"name\":\"" << phaseName(e.phase) << "\",\"cat\":\"chess\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << "," << times;
+        if (e.argName) {
+            out << ",\"args\":{\"" << e.argName << "\":" << e.argValue << "}";
+        }
+        out << "}";
+    }
+}
+
+namespace Trace {
+    std::atomic<bool> recording{ false };
+
+    bool start(const std::string& path) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::ofstream probe(path);
+        if (!probe) return false;
+        outputPath = path;
+        origin = std::chrono::steady_clock::now();
+        if (!atExitRegistered) {
+            std::atexit(stop);
+            atExitRegistered = true;
+        }
+        recording = true;
+        return true;
+    }
+
+    std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void complete(Phase phase, std::int64_t startNs, const char* argName, long long argValue) {
+        if (!enabled()) return;
+        std::int64_t endNs = now();
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        Event event = { startNs, endNs - startNs, argName, argValue, phase };
+        if (buffer.events.size() < MAX_EVENTS) {
+            buffer.events.push_back(event);
+            return;
+        }
+        buffer.events[buffer.next] = event;
+        buffer.next = (buffer.next + 1) % MAX_EVENTS;
+        ++dropped;
+    }
+
+    void stop() {
+        if (!recording.exchange(false)) return;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::ofstream out(outputPath);
+        if (!out) {
+            std::cerr << "trace: cannot write " << outputPath << std::endl;
+            return;
+        }
+        out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten_events\":" << dropped.load() << "},\n"
+            << "\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Chess\"}}";
+        long long total = 0;
+        for (const auto& buffer : buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+            std::size_t count = buffer->events.size();
+            for (std::size_t i = 0; i < count; ++i) {
+                writeEvent(out, buffer->events[(buffer->next + i) % count], buffer->tid);
+            }
+            total += static_cast<long long>(count);
+            buffer->events.clear();
+            buffer->next = 0;
+        }
+        out << "\n]}\n";
+        std::cerr << "trace: " << total << " events written to " << outputPath;
+        if (dropped.load() > 0) std::cerr << " (" << dropped.load() << " older ones overwritten)";
+        std::cerr << std::endl;
+    }
+}
+
+#endif // CHESS_TRACE
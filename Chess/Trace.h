@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief The phases of a game and a search that instrumentation tags its measurements with.
+ */
+enum class Phase {
+    BOT_MOVE,            ///< Bot::think(): one whole search.
+    SEARCH_ITERATION,    ///< One iteration of iterative deepening.
+    MOVE_GENERATION,     ///< Piece::generateMoves().
+    LEGALITY,            ///< Does a move leave the king in check (Board::leavesKingInCheck, isPlayerInCheck).
+    EVALUATION,          ///< Static evaluation of a position.
+    CHECKMATE,           ///< Checkmate and stalemate detection.
+    MOVE_EXECUTION,      ///< Board::movePiece() / applyMove(), including their checkmate test.
+    BOARD_COPY,          ///< Board copy constructor and assignment.
+    BOARD_DISPLAY,       ///< Drawing the board on the console.
+    SAVE_LOAD,           ///< Saving or loading a game file.
+    COUNT
+};
+
+const char* phaseName(Phase phase);  ///< "move generation" style name of a phase.
+
+#ifdef CHESS_TRACE
+
+#include <atomic>
+
+/**
+ * @brief Chrome / Perfetto trace-event recording (compiled in with CHESS_TRACE).
+ *
+ * PROFILE_SCOPE(phase) records a complete ("X") event from the scope's start to its end on
+ * the calling thread's track. Events are buffered per thread and written as trace-event JSON
+ * (load it at ui.perfetto.dev or chrome://tracing) by stop(), which start() also arranges to
+ * run at exit. Without CHESS_TRACE these macros expand to nothing and none of this is built.
+ */
+namespace Trace {
+    bool start(const std::string& path);   ///< Begin recording; false if the file can't be created.
+    void stop();                           ///< Write the recorded events and stop recording.
+    std::int64_t now();                    ///< Timestamp for complete(), in nanoseconds.
+
+    extern std::atomic<bool> recording;
+    inline bool enabled() { return recording.load(std::memory_order_relaxed); }
+
+    /// Record an event that started at `startNs` (from now()) and ends now, with an optional argument.
+    void complete(Phase phase, std::int64_t startNs, const char* argName = nullptr, long long argValue = 0);
+
+    class Scope {
+    public:
+        explicit Scope(Phase phase) : phase(phase), startNs(enabled() ? now() : -1) {}
+        ~Scope() { if (startNs >= 0) complete(phase, startNs); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Phase phase;
+        std::int64_t startNs;
+    };
+}
+
+#define PROFILE_TRACE_SCOPE(phase) Trace::Scope PROFILE_CONCAT(profileScope_, __LINE__)(phase)
+#define PROFILE_MARK(var) ((var) = Trace::now())
+#define PROFILE_COMPLETE(phase, var, argName, argValue) Trace::complete((phase), (var), (argName), (argValue))
+
+#else
+
+#define PROFILE_TRACE_SCOPE(phase) ((void)0)
+#define PROFILE_MARK(var) ((void)0)
+#define PROFILE_COMPLETE(phase, var, argName, argValue) ((void)0)
+
+#endif // CHESS_TRACE
+
+#ifdef CHESS_ALLOC_TRACKING
+#include "AllocTracker.h"
+#define PROFILE_ALLOC_SCOPE(phase) AllocTracker::PhaseScope PROFILE_CONCAT(allocScope_, __LINE__)(phase)
+#else
+#define PROFILE_ALLOC_SCOPE(phase) ((void)0)
+#endif // CHESS_ALLOC_TRACKING
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+/// Tag the rest of the enclosing scope with a phase, for every instrumentation compiled in.
+#define PROFILE_SCOPE(phase) PROFILE_TRACE_SCOPE(phase); PROFILE_ALLOC_SCOPE(phase)
+
+#endif // TRACE_H
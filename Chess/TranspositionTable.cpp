@@ -0,0 +1,92 @@
+/**
+ * @file TranspositionTable.cpp
+ * @brief Implementation of the transposition table used by the Bot search.
+ *
+ * The table is a power-of-two array of entries indexed by the low bits of the Zobrist
+ * position key. Each slot keeps a single entry; a new result replaces the old one unless
+ * the old one belongs to the same position and was searched deeper.
+ *
+ * An entry's fields are packed into one 64-bit word so a slot can be read and written with
+ * two relaxed atomic operations, which lets helper search threads share the table without
+ * locks (see the class comment in TranspositionTable.h).
+ */
+#include "TranspositionTable.h"
+#include <algorithm>
+
+namespace {
+    std::uint64_t pack(int score, PackedMove move, int depth, BoundType bound) {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(score))
+            | (static_cast<std::uint64_t>(move) << 32)
+            | (static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 48)
+            | (static_cast<std::uint64_t>(bound) << 56);
+    }
+
+    void unpack(std::uint64_t data, TTEntry& entry) {
+        entry.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data & 0xFFFFFFFFULL));
+        entry.bestMove = static_cast<PackedMove>((data >> 32) & 0xFFFF);
+        entry.depth = static_cast<std::int8_t>(static_cast<std::uint8_t>((data >> 48) & 0xFF));
+        entry.bound = static_cast<BoundType>((data >> 56) & 0xFF);
+    }
+}
+
+TranspositionTable::TranspositionTable(std::size_t sizeMb) {
+    resize(sizeMb);
+}
+
+void TranspositionTable::resize(std::size_t newSizeMb) {
+    // Round the entry count down to a power of two so the index is a simple mask.
+    sizeMb = std::max<std::size_t>(newSizeMb, 1);
+    std::size_t bytes = sizeMb * 1024 * 1024;
+    std::size_t entries = 1;
+    while (entries * 2 * sizeof(Slot) <= bytes) {
+        entries *= 2;
+    }
+    slots.reset(new Slot[entries]);
+    count = entries;
+    mask = entries - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i < count; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t TranspositionTable::getSizeMb() const {
+    return sizeMb;
+}
+
+bool TranspositionTable::probe(std::uint64_t key, TTEntry& entry) const {
+    const Slot& slot = slots[key & mask];
+    std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key) {
+        return false;
+    }
+    unpack(data, entry);
+    entry.key = key;
+    return entry.bound != BoundType::NONE;
+}
+
+void TranspositionTable::store(std::uint64_t key, int depth, int score, BoundType bound, PackedMove bestMove) {
+    Slot& slot = slots[key & mask];
+    std::uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    bool samePosition = (slot.check.load(std::memory_order_relaxed) ^ oldData) == key;
+    if (samePosition) {
+        TTEntry old;
+        unpack(oldData, old);
+        // Keep a deeper result for the same position, but always let new positions in.
+        if (old.depth > depth && bound != BoundType::EXACT) {
+            return;
+        }
+        // Don't lose a known best move when the new result has none (e.g. a fail-low).
+        if (bestMove == 0) {
+            bestMove = old.bestMove;
+        }
+    }
+    std::uint64_t data = pack(score, bestMove, depth, bound);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,65 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "Board.h"
+
+enum class BoundType : std::uint8_t { NONE, EXACT, LOWER, UPPER };
+
+/**
+ * @struct TTEntry
+ * @brief One cached search result: score, bound, depth and best move of a position.
+ */
+struct TTEntry {
+    std::uint64_t key = 0;              ///< Full position key (verifies index collisions)
+    std::int32_t  score = 0;            ///< Score from the side to move's point of view
+    PackedMove    bestMove = 0;         ///< Best or refutation move, 0 if none
+    std::int8_t   depth = -1;           ///< Remaining depth the score was searched to
+    BoundType     bound = BoundType::NONE;
+};
+
+/**
+ * @class TranspositionTable
+ * @brief Fixed-size hash table of search results keyed by Board::getPositionKey.
+ *
+ * Several search threads may probe and store concurrently. Each slot holds the packed entry
+ * and the key XOR-ed with it; a slot torn by a concurrent write fails the key check and simply
+ * reads as a miss. resize() and clear() must not run while a search is using the table.
+ */
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t sizeMb = 16);  ///< Allocate roughly sizeMb megabytes.
+
+    void resize(std::size_t sizeMb);   ///< Reallocate (and clear) the table.
+    void clear();                      ///< Forget all entries.
+    std::size_t getSizeMb() const;
+
+    /**
+     * @brief Look up a position.
+     * @param key   Position key.
+     * @param entry Receives the stored entry on a hit.
+     * @return True if an entry for exactly this key exists.
+     */
+    bool probe(std::uint64_t key, TTEntry& entry) const;
+
+    /**
+     * @brief Store a search result, preferring deeper results for the same position.
+     */
+    void store(std::uint64_t key, int depth, int score, BoundType bound, PackedMove bestMove);
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check;  ///< key ^ data
+        std::atomic<std::uint64_t> data;   ///< score | move | depth | bound
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t count{ 0 };
+    std::size_t mask{ 0 };
+    std::size_t sizeMb{ 0 };
+};
+
+#endif // TRANSPOSITION_TABLE_H
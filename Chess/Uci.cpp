@@ -0,0 +1,331 @@
+/**
+ * @file Uci.cpp
+ * @brief UCI protocol mode: lets GUIs and match runners drive the Bot without the menu.
+ *
+ * The command loop owns the Board; a search works on a copy inside Bot::think() on the
+ * worker thread, and progress is streamed as `info` lines from the Bot's iteration callback.
+ */
+#include "Uci.h"
+#include "MovePicker.h"
+#include "Notation.h"
+#include "Nnue.h"
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+namespace {
+    const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    // First legal move, for the rare case where the search was stopped before it had one.
+    PackedMove firstLegalMove(Board& board, Color side) {
+        MovePicker picker(board, side, 0, 0, 0);
+        PackedMove move;
+        while ((move = picker.nextMove()) != 0) {
+            if (!board.leavesKingInCheck(packedFromX(move), packedFromY(move), packedToX(move), packedToY(move))) {
+                return move;
+            }
+        }
+        return 0;
+    }
+
+    bool parseSquare(const std::string& s, size_t at, int& x, int& y) {
+        if (s.size() < at + 2) return false;
+        char file = s[at], rank = s[at + 1];
+        if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return false;
+        x = file - 'a';
+        y = 8 - (rank - '0');
+        return true;
+    }
+}
+
+UciEngine::UciEngine(std::istream& input, std::ostream& output)
+    : in(input), out(output), bot(Color::WHITE) {
+    board.loadFromFen(START_FEN);
+    bot.setInfoCallback([this](const SearchResult& result) { sendInfo(result); });
+}
+
+UciEngine::~UciEngine() {
+    waitForSearch();
+}
+
+int UciEngine::run() {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream args(line);
+        std::string command;
+        if (!(args >> command)) {
+            continue;
+        }
+        if (command == "uci") {
+            handleUci();
+        }
+        else if (command == "isready") {
+            send("readyok");
+        }
+        else if (command == "ucinewgame") {
+            waitForSearch();
+            bot.clearHash();
+        }
+        else if (command == "setoption") {
+            handleSetOption(args);
+        }
+        else if (command == "position") {
+            handlePosition(args);
+        }
+        else if (command == "go") {
+            handleGo(args);
+        }
+        else if (command == "stop") {
+            handleStop();
+        }
+        else if (command == "ponderhit") {
+            handlePonderHit();
+        }
+        else if (command == "quit") {
+            break;
+        }
+        else {
+            send("info string unknown command: " + command);
+        }
+    }
+    waitForSearch();
+    return 0;
+}
+
+void UciEngine::handleUci() {
+    send("id name Chess");
+    send("id author RileyK05");
+    send("option name Hash type spin default 16 min 1 max 4096");
+    send("option name Threads type spin default 1 min 1 max 64");
+    send("option name Ponder type check default false");
+    send("option name EvalFile type string default <empty>");
+    send("option name SearchStats type check default false");
+    send("uciok");
+}
+
+void UciEngine::handleSetOption(std::istream& args) {
+    // setoption name <id> [value <x>]; names may contain spaces.
+    std::string token, name, value;
+    std::string* target = nullptr;
+    while (args >> token) {
+        if (token == "name") {
+            target = &name;
+        }
+        else if (token == "value") {
+            target = &value;
+        }
+        else if (target) {
+            if (!target->empty()) *target += " ";
+            *target += token;
+        }
+    }
+    std::string key = name;
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+    waitForSearch();
+    if (key == "hash") {
+        int mb = std::atoi(value.c_str());
+        bot.setHashSize(std::size_t(std::min(std::max(mb, 1), 4096)));
+    }
+    else if (key == "threads") {
+        int threads = std::atoi(value.c_str());
+        bot.setThreads(std::min(std::max(threads, 1), 64));
+    }
+    else if (key == "ponder") {
+        // Pondering is driven entirely by `go ponder`; nothing to configure.
+    }
+    else if (key == "searchstats") {
+        searchStats = value == "true";
+    }
+    else if (key == "evalfile") {
+        if (value.empty() || value == "<empty>") {
+            bot.setNetwork(nullptr);
+            return;
+        }
+        std::string error;
+        auto network = NnueNetwork::load(value, error);
+        if (!network) {
+            send("info string " + error);
+            return;
+        }
+        bot.setNetwork(network);
+        send("info string loaded NNUE network " + value);
+    }
+    else {
+        send("info string unknown option: " + name);
+    }
+}
+
+void UciEngine::handlePosition(std::istream& args) {
+    waitForSearch();
+    std::string token, fen;
+    args >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        args >> token;
+    }
+    else if (token == "fen") {
+        while (args >> token && token != "moves") {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+    }
+    else {
+        send("info string position: expected startpos or fen");
+        return;
+    }
+    try {
+        board.loadFromFen(fen);
+    }
+    catch (const std::exception& e) {
+        send(std::string("info string ") + e.what());
+        board.loadFromFen(START_FEN);
+        return;
+    }
+    if (token != "moves") {
+        return;
+    }
+
+    static const std::string promotionLetters = "nbrq";
+    static const PieceType promotionTypes[] = { PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN };
+    while (args >> token) {
+        int fx, fy, tx, ty;
+        Piece* piece = nullptr;
+        if (parseSquare(token, 0, fx, fy) && parseSquare(token, 2, tx, ty)) {
+            piece = board.getPieceAt(fx, fy);
+        }
+        if (!piece || !board.applyMove(piece->getId(), tx, ty).first) {
+            send("info string illegal or unsupported move " + token +
+                " (castling and en passant are not implemented); position stops before it");
+            return;
+        }
+        // The board promotes to a queen by itself; apply an under-promotion afterwards.
+        if (token.size() == 5) {
+            size_t kind = promotionLetters.find(token[4]);
+            if (kind != std::string::npos && piece->getType() == PieceType::QUEEN) {
+                board.promotePiece(piece->getId(), promotionTypes[kind]);
+            }
+        }
+    }
+}
+
+void UciEngine::handleGo(std::istream& args) {
+    waitForSearch();
+    SearchLimits limits;
+    limits.moveTimeMs = 0;
+    long long time[2] = { -1, -1 }, inc[2] = { 0, 0 };
+    int movesToGo = 0;
+    long long moveTime = -1;
+    bool limited = false;
+
+    std::string token;
+    while (args >> token) {
+        if (token == "wtime") { args >> time[0]; limited = true; }
+        else if (token == "btime") { args >> time[1]; limited = true; }
+        else if (token == "winc") args >> inc[0];
+        else if (token == "binc") args >> inc[1];
+        else if (token == "movestogo") args >> movesToGo;
+        else if (token == "depth") { args >> limits.maxDepth; limited = true; }
+        else if (token == "nodes") { args >> limits.maxNodes; limited = true; }
+        else if (token == "movetime") { args >> moveTime; limited = true; }
+        else if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponder = true;
+    }
+    // A bare "go" searches until stopped, like "go infinite".
+    if (!limited) limits.infinite = true;
+    limits.maxDepth = std::min(std::max(limits.maxDepth, 1), Bot::MAX_PLY - 1);
+
+    int us = board.currentPlayerColor == Color::WHITE ? 0 : 1;
+    if (moveTime >= 0) {
+        limits.moveTimeMs = int(std::max(moveTime, 1LL));
+    }
+    else if (time[us] >= 0) {
+        limits.moveTimeMs = Bot::allocateTime(time[us], inc[us], movesToGo);
+    }
+
+    bot.setColor(board.currentPlayerColor);
+    bot.setSearchLimits(limits);
+    bool hold = limits.infinite || limits.ponder;
+    {
+        std::lock_guard<std::mutex> lock(releaseMutex);
+        released = !hold;
+    }
+    worker = std::thread([this, hold] { search(hold); });
+}
+
+void UciEngine::handleStop() {
+    bot.stop();
+    std::lock_guard<std::mutex> lock(releaseMutex);
+    released = true;
+    releaseSignal.notify_all();
+}
+
+void UciEngine::handlePonderHit() {
+    // The search goes on, now on our own clock; bestmove is sent as soon as it finishes.
+    bot.ponderHit();
+    std::lock_guard<std::mutex> lock(releaseMutex);
+    released = true;
+    releaseSignal.notify_all();
+}
+
+void UciEngine::search(bool holdBestMove) {
+    PackedMove best = bot.think(board);
+    const SearchResult& result = bot.getLastResult();
+    if (searchStats) {
+        send("info string stats " + result.stats.summary());
+    }
+#ifdef CHESS_ALLOC_TRACKING
+    send("info string allocs " + AllocTracker::report(result.allocations, result.nodes));
+#endif
+    if (holdBestMove) {
+        std::unique_lock<std::mutex> lock(releaseMutex);
+        releaseSignal.wait(lock, [this] { return released; });
+    }
+    if (!best) {
+        // Stopped before the first iteration finished, or no legal move at all.
+        Board scratch = board;
+        best = firstLegalMove(scratch, board.currentPlayerColor);
+    }
+    if (!best) {
+        send("bestmove 0000");
+        return;
+    }
+    std::string line = "bestmove " + moveToUci(board, best);
+    if (result.pv.size() >= 2 && result.pv[0] == best) {
+        Board next = board;
+        Piece* piece = next.getPieceAt(packedFromX(best), packedFromY(best));
+        next.applyMove(piece->getId(), packedToX(best), packedToY(best));
+        line += " ponder " + moveToUci(next, result.pv[1]);
+    }
+    send(line);
+}
+
+void UciEngine::waitForSearch() {
+    if (!worker.joinable()) {
+        return;
+    }
+    handleStop();
+    worker.join();
+}
+
+void UciEngine::sendInfo(const SearchResult& result) {
+    std::ostringstream line;
+    line << "info depth " << result.depth << " score " << scoreToUci(result.score);
+    long long nps = result.timeMs > 0 ? result.nodes * 1000 / result.timeMs : result.nodes;
+    line << " nodes " << result.nodes << " nps " << nps << " time " << result.timeMs << " pv";
+    // PV moves only need the board for promotion suffixes, so walk a copy along the line.
+    Board walk = board;
+    for (PackedMove move : result.pv) {
+        line << " " << moveToUci(walk, move);
+        Piece* piece = walk.getPieceAt(packedFromX(move), packedFromY(move));
+        if (!piece || !walk.applyMove(piece->getId(), packedToX(move), packedToY(move)).first) {
+            break;
+        }
+    }
+    send(line.str());
+}
+
+void UciEngine::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outMutex);
+    out << line << std::endl;
+}
@@ -0,0 +1,65 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Board.h"
+#include "Bot.h"
+
+/**
+ * @class UciEngine
+ * @brief Headless Universal Chess Interface front end for the Bot.
+ *
+ * Commands are read line by line on the calling thread; each `go` runs on a worker thread so
+ * that `stop`, `ponderhit` and `isready` are answered while the search is in progress.
+ * Supported: uci, isready, ucinewgame, setoption (Hash, Threads, Ponder, EvalFile, SearchStats),
+ * position (startpos | fen) [moves ...], go (wtime btime winc binc movestogo depth nodes
+ * movetime infinite ponder), stop, ponderhit, quit.
+ *
+ * The engine has no castling or en passant; moves using them are rejected with an
+ * `info string` and the position is left at the last move that could be played.
+ *
+ * With SearchStats on, every search ends with an `info string stats ...` line before its
+ * bestmove: the SearchStats::summary() of the search.
+ */
+class UciEngine {
+public:
+    UciEngine(std::istream& in, std::ostream& out);
+    ~UciEngine();
+
+    int run();  ///< Process commands until `quit` or end of input.
+
+private:
+    void handleUci();
+    void handleSetOption(std::istream& args);
+    void handlePosition(std::istream& args);
+    void handleGo(std::istream& args);
+    void handleStop();
+    void handlePonderHit();
+
+    void search(bool holdBestMove);        ///< Worker thread body.
+    void waitForSearch();                  ///< Stop any running search and join its thread.
+    void sendInfo(const SearchResult& result);
+    void send(const std::string& line);    ///< Write one line (thread-safe, flushed).
+
+    std::istream& in;
+    std::ostream& out;
+    std::mutex outMutex;
+
+    Board board;
+    Bot bot;
+    bool searchStats{ false };             ///< Send SearchStats after every search.
+    std::thread worker;
+
+    // A `go infinite` or `go ponder` search may finish early but must hold its bestmove
+    // until the GUI releases it with `stop` or `ponderhit`.
+    std::mutex releaseMutex;
+    std::condition_variable releaseSignal;
+    bool released{ true };
+};
+
+#endif // UCI_H